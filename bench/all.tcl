@@ -0,0 +1,35 @@
+# See LICENSE for license terms.
+#
+# Runs all benchmarks in this directory.
+#
+# Usage: tclsh all.tcl ?-load SCRIPT? ?-match PATTERN? ?-iterations N? ?-json FILE?
+#   -load SCRIPT - script to evaluate to make the cffi package available
+#   -match PATTERN - only run benchmarks whose ids match PATTERN
+#   -iterations N - number of iterations for each benchmark
+#   -json FILE - also write results in JSON format to FILE
+
+set benchDir [file dirname [file normalize [info script]]]
+array set benchOpts {-load {} -match * -iterations {} -json {}}
+foreach {opt val} $argv {
+    if {![info exists benchOpts($opt)]} {
+        error "Unknown option \"$opt\". Must be one of [join [lsort [array names benchOpts]] {, }]."
+    }
+    set benchOpts($opt) $val
+}
+uplevel #0 $benchOpts(-load)
+
+source [file join $benchDir common.tcl]
+set cffi::bench::match $benchOpts(-match)
+if {$benchOpts(-iterations) ne ""} {
+    set cffi::bench::defaultIterations $benchOpts(-iterations)
+}
+
+foreach benchFile [lsort [glob -directory $benchDir *.bench]] {
+    source $benchFile
+}
+
+if {$benchOpts(-json) ne ""} {
+    set fd [open $benchOpts(-json) w]
+    puts -nonewline $fd [cffi::bench::json]
+    close $fd
+}
@@ -0,0 +1,87 @@
+# See LICENSE for license terms.
+#
+# Contains common definitions for benchmark scripts. Benchmarks are not
+# tests - they report the time per invocation of a script and do not
+# check results.
+
+set NS cffi
+if {[namespace exists ${NS}::bench]} {
+    return
+}
+
+package require $NS
+
+namespace eval cffi::bench {
+    variable testDllPath [file normalize [file join [file dirname $::cffi::dll_path] cffitest[info sharedlibextension]]]
+    cffi::Wrapper create testDll $testDllPath
+
+    # Number of iterations for each benchmark unless overridden
+    variable defaultIterations 100000
+
+    # Pattern for benchmark ids to run
+    variable match *
+
+    # List of {id description nanoseconds} for benchmarks run
+    variable results {}
+
+    # Runs a benchmark script and records the average time per iteration.
+    #  id - benchmark identifier
+    #  description - short description of the benchmark
+    #  script - script to run in the caller's context
+    #  iterations - number of iterations. Defaults to defaultIterations
+    # Returns the time per iteration in nanoseconds or an empty string
+    # if the benchmark did not match the configured pattern.
+    proc bench {id description script {iterations {}}} {
+        variable defaultIterations
+        variable match
+        variable results
+        if {![string match $match $id]} {
+            return
+        }
+        if {$iterations eq ""} {
+            set iterations $defaultIterations
+        }
+        # Warm up so one-time costs like shimmering are not measured
+        uplevel 1 $script
+        set usecs [lindex [uplevel 1 [list time $script $iterations]] 0]
+        set ns [expr {$usecs * 1000.0}]
+        lappend results [list $id $description $ns]
+        puts [format "%-36s %10.1f ns  %s" $id $ns $description]
+        return $ns
+    }
+
+    # Returns a string quoted as a JSON string.
+    proc jsonString {s} {
+        return "\"[string map {\\ \\\\ \" \\\" \n \\n \r \\r \t \\t} $s]\""
+    }
+
+    # Returns the benchmark results run so far as a JSON document that
+    # also identifies the package, backend and platform so results from
+    # different builds can be compared.
+    proc json {} {
+        variable defaultIterations
+        variable results
+        set entries {}
+        foreach result $results {
+            lassign $result id description ns
+            lappend entries [format \
+                "    {\"id\": %s, \"description\": %s, \"ns\": %.1f}" \
+                [jsonString $id] [jsonString $description] $ns]
+        }
+        set fields [list \
+            package [jsonString cffi] \
+            version [jsonString [package present cffi]] \
+            backend [jsonString [cffi::pkgconfig get backend]] \
+            tcl [jsonString [info patchlevel]] \
+            os [jsonString $::tcl_platform(os)] \
+            machine [jsonString $::tcl_platform(machine)] \
+            pointerSize $::tcl_platform(pointerSize) \
+            iterations $defaultIterations]
+        set json "\{\n"
+        foreach {field value} $fields {
+            append json "  [jsonString $field]: $value,\n"
+        }
+        append json "  \"results\": \[\n[join $entries ,\n]\n  \]\n\}\n"
+        return $json
+    }
+}
@@ -68,23 +68,74 @@ CffiGetEncodingFromObj(Tcl_Interp *ip, Tcl_Obj *encObj, Tcl_Encoding *encP)
     return TCL_OK;
 }
 
+/* Function: CffiCallCacheReset
+ * Removes all entries from the function pointer cache used by *cffi::call*.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * Must be called whenever prototypes are deleted so calls through function
+ * pointers do not use stale prototype definitions.
+ */
+void
+CffiCallCacheReset(CffiInterpCtx *ipCtxP)
+{
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+
+    for (heP = Tcl_FirstHashEntry(&ipCtxP->callCache, &hSearch); heP != NULL;
+         heP = Tcl_NextHashEntry(&hSearch)) {
+        CffiFunction *fnP = Tcl_GetHashValue(heP);
+        Tcl_DeleteHashEntry(heP);
+        CffiFunctionUnref(fnP);
+    }
+}
+
+/* Function: CffiFnPtrResolve
+ * Returns a function definition for a function pointer.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * fnPtrObj - function pointer tagged with a prototype name
+ * fnPP - location to store the function definition
+ *
+ * Definitions for pointers with fully qualified tags are cached in the
+ * interpreter context.
+ *
+ * *NOTE:* The reference count on the returned structure is *not* incremented.
+ * The caller must do so around any use of it, and unref it afterward, so that
+ * uncached definitions are freed.
+ *
+ * Returns:
+ * *TCL_OK* on success with the definition stored in *fnPP*, or
+ * *TCL_ERROR* on error with message in interpreter.
+ */
 static CffiResult
-CffiCallObjCmd(ClientData cdata,
-               Tcl_Interp *ip,
-               int objc,
-               Tcl_Obj *const objv[])
+CffiFnPtrResolve(CffiInterpCtx *ipCtxP, Tcl_Obj *fnPtrObj, CffiFunction **fnPP)
 {
+    Tcl_Interp *ip = ipCtxP->interp;
     Tcl_Obj *protoNameObj;
-    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
     CffiProto *protoP;
     CffiFunction *fnP;
-    CffiResult ret;
+    Tcl_HashEntry *heP;
     void *fnAddr;
+    int cacheable;
 
-    CHECK_NARGS(ip, 2, INT_MAX, "FNPTR ?ARG ...?");
-    CHECK(Tclh_PointerObjGetTag(ip, objv[1], &protoNameObj));
-    CHECK(Tclh_PointerUnwrap(ip, objv[1], &fnAddr));
+    /*
+     * The string form of a function pointer with a fully qualified tag
+     * uniquely identifies the address and prototype so it can be used
+     * as the key for looking up a previously constructed CffiFunction.
+     */
+    heP = Tcl_FindHashEntry(&ipCtxP->callCache, Tcl_GetString(fnPtrObj));
+    if (heP) {
+        *fnPP = Tcl_GetHashValue(heP);
+        return TCL_OK;
+    }
+
+    CHECK(Tclh_PointerObjGetTag(ip, fnPtrObj, &protoNameObj));
+    CHECK(Tclh_PointerUnwrap(ip, fnPtrObj, &fnAddr));
 
+    cacheable = protoNameObj && Tclh_NsIsFQN(Tcl_GetString(protoNameObj));
     protoNameObj = Tclh_NsQualifyNameObj(ip, protoNameObj, NULL);
     Tcl_IncrRefCount(protoNameObj);
     protoP = CffiProtoGet(ipCtxP, protoNameObj);
@@ -93,10 +144,40 @@ CffiCallObjCmd(ClientData cdata,
 
     if (protoP == NULL) {
         return Tclh_ErrorNotFound(
-            ip, "Prototype", objv[1], "Function prototype not found.");
+            ip, "Prototype", fnPtrObj, "Function prototype not found.");
     }
 
     fnP = CffiFunctionNew(ipCtxP, protoP, NULL, NULL, fnAddr);
+    if (cacheable) {
+        int isNew;
+        /* Simple bound on cache size - just start over when full */
+        if (ipCtxP->callCache.numEntries >= CFFI_CALL_CACHE_MAX_ENTRIES)
+            CffiCallCacheReset(ipCtxP);
+        heP = Tcl_CreateHashEntry(
+            &ipCtxP->callCache, Tcl_GetString(fnPtrObj), &isNew);
+        CFFI_ASSERT(isNew);
+        Tcl_SetHashValue(heP, fnP);
+        CffiFunctionRef(fnP); /* For the cache entry */
+    }
+    *fnPP = fnP;
+    return TCL_OK;
+}
+
+static CffiResult
+CffiCallObjCmd(ClientData cdata,
+               Tcl_Interp *ip,
+               int objc,
+               Tcl_Obj *const objv[])
+{
+    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
+    CffiFunction *fnP;
+    CffiResult ret;
+
+    CHECK_NARGS(ip, 2, INT_MAX, "FNPTR ?ARG ...?");
+
+    CHECK(CffiFnPtrResolve(ipCtxP, objv[1], &fnP));
+
+    /* Ref so fnP survives a cache reset from within a callback */
     CffiFunctionRef(fnP);
     ret = CffiFunctionCall(fnP, ip, 2, objc, objv);
     CffiFunctionUnref(fnP);
@@ -104,6 +185,198 @@ CffiCallObjCmd(ClientData cdata,
     return ret;
 }
 
+/* Function: CffiBatchObjCmd
+ * Implements the *batch* script level command.
+ *
+ * Parameters:
+ * cdata - the interpreter context
+ * ip - interpreter
+ * objc - number of elements in *objv*
+ * objv - command arguments
+ *
+ * The syntax is
+ *   batch FUNCTION ARGLISTS ?-collect results|errors?
+ * where *FUNCTION* is either a command created with a *Wrapper* instance's
+ * *function* or *stdcall* methods, or a function pointer as accepted by
+ * *call*. The function is invoked once for every element of *ARGLISTS*
+ * without going through Tcl command dispatch.
+ *
+ * Returns:
+ * *TCL_OK* on success with the list of function results, or with
+ * *-collect errors*, a flat list of index and error message pairs for
+ * the failed calls, stored in the interpreter. *TCL_ERROR* on error with
+ * message in the interpreter.
+ */
+static CffiResult
+CffiBatchObjCmd(ClientData cdata,
+                Tcl_Interp *ip,
+                int objc,
+                Tcl_Obj *const objv[])
+{
+    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
+    CffiFunction *fnP;
+    Tcl_Obj *argListsObj;
+    Tcl_Obj **argLists;
+    Tcl_Obj **fnArgs;
+    Tcl_Obj **callObjs;
+    Tcl_Obj *resultObj;
+    Tcl_Size i, j, nArgLists, nFnArgs, maxFnArgs;
+    Tclh_LifoMark mark;
+    CffiResult ret;
+    int collectErrors;
+    static const char *const opts[] = {"-collect", NULL};
+    static const char *const collectOpts[] = {"results", "errors", NULL};
+
+    CHECK_NARGS(ip, 3, 5, "FUNCTION ARGLISTS ?-collect results|errors?");
+
+    collectErrors = 0;
+    if (objc > 3) {
+        int optIndex;
+        CHECK(Tcl_GetIndexFromObj(ip, objv[3], opts, "option", 0, &optIndex));
+        if (objc == 4)
+            return Tclh_ErrorOptionValueMissing(ip, objv[3], NULL);
+        CHECK(Tcl_GetIndexFromObj(
+            ip, objv[4], collectOpts, "collect mode", 0, &collectErrors));
+    }
+
+    CHECK(CffiFunctionFromCommand(ip, objv[1], &fnP));
+    if (fnP == NULL) {
+        CHECK(CffiFnPtrResolve(ipCtxP, objv[1], &fnP));
+    }
+
+    /*
+     * Work on a private copy of the argument lists so element pointers
+     * stay valid even if the function calls back into the script.
+     */
+    argListsObj = Tcl_DuplicateObj(objv[2]);
+    Tcl_IncrRefCount(argListsObj);
+    ret = Tcl_ListObjGetElements(ip, argListsObj, &nArgLists, &argLists);
+    if (ret != TCL_OK) {
+        Tcl_DecrRefCount(argListsObj);
+        return ret;
+    }
+
+    /* Validate all argument lists before making any call */
+    for (maxFnArgs = 0, i = 0; i < nArgLists; ++i) {
+        ret = Tcl_ListObjGetElements(ip, argLists[i], &nFnArgs, &fnArgs);
+        if (ret != TCL_OK) {
+            Tcl_DecrRefCount(argListsObj);
+            return ret;
+        }
+        if (nFnArgs > maxFnArgs)
+            maxFnArgs = nFnArgs;
+    }
+
+    /* IMPORTANT - mark has to be popped and fnP unref'ed before returning */
+    CffiFunctionRef(fnP);
+    mark = Tclh_LifoPushMark(&ipCtxP->memlifo);
+    /* Slot 0 holds the function for error messages, as for a direct call */
+    callObjs = Tclh_LifoAlloc(&ipCtxP->memlifo,
+                              (maxFnArgs + 1) * sizeof(Tcl_Obj *));
+    callObjs[0] = objv[1];
+
+    resultObj = Tcl_NewListObj(0, NULL);
+    for (i = 0; i < nArgLists; ++i) {
+        /* Cannot fail, validated above. Hold refs in case of callbacks */
+        Tcl_IncrRefCount(argLists[i]);
+        (void)Tcl_ListObjGetElements(NULL, argLists[i], &nFnArgs, &fnArgs);
+        for (j = 0; j < nFnArgs; ++j) {
+            callObjs[j + 1] = fnArgs[j];
+            Tcl_IncrRefCount(fnArgs[j]);
+        }
+        Tcl_ResetResult(ip);
+        ret = CffiFunctionCall(fnP, ip, 1, (int)nFnArgs + 1, callObjs);
+        for (j = 0; j < nFnArgs; ++j)
+            Tcl_DecrRefCount(callObjs[j + 1]);
+        Tcl_DecrRefCount(argLists[i]);
+
+        if (ret == TCL_OK) {
+            if (!collectErrors)
+                Tcl_ListObjAppendElement(NULL, resultObj, Tcl_GetObjResult(ip));
+        }
+        else if (collectErrors) {
+            Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewWideIntObj(i));
+            Tcl_ListObjAppendElement(NULL, resultObj, Tcl_GetObjResult(ip));
+        }
+        else {
+            Tcl_AppendObjToErrorInfo(
+                ip, Tcl_ObjPrintf("\n    (batch call %d)", (int)i));
+            break;
+        }
+    }
+
+    Tclh_LifoPopMark(mark);
+    CffiFunctionUnref(fnP);
+    Tcl_DecrRefCount(argListsObj);
+
+    if (ret == TCL_OK || collectErrors) {
+        Tcl_SetObjResult(ip, resultObj);
+        return TCL_OK;
+    }
+    Tcl_DecrRefCount(resultObj); /* Never had a reference so free it */
+    return TCL_ERROR;
+}
+
+#ifdef CFFI_USE_LIBFFI
+/* Function: CffiAsyncObjCmd
+ * Implements the *async* script level command.
+ *
+ * Parameters:
+ * cdata - the interpreter context
+ * ip - interpreter
+ * objc - number of elements in *objv*
+ * objv - command arguments
+ *
+ * The syntax is
+ *   async ?-command CMDPREFIX? FUNCTION ?ARG ...?
+ * where *FUNCTION* is resolved as for the *batch* command. The function is
+ * called from a worker thread and *CMDPREFIX*, if specified, is invoked
+ * from the event loop on completion.
+ *
+ * Returns:
+ * *TCL_OK* if the call was initiated, *TCL_ERROR* on error with message
+ * in the interpreter.
+ */
+static CffiResult
+CffiAsyncObjCmd(ClientData cdata,
+                Tcl_Interp *ip,
+                int objc,
+                Tcl_Obj *const objv[])
+{
+    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
+    CffiFunction *fnP;
+    Tcl_Obj *cmdObj = NULL;
+    int fnIndex;
+    CffiResult ret;
+    static const char *const opts[] = {"-command", NULL};
+    static const char *const syntax = "?-command CMDPREFIX? FUNCTION ?ARG ...?";
+
+    CHECK_NARGS(ip, 2, INT_MAX, syntax);
+
+    fnIndex = 1;
+    if (objc > 2 && Tcl_GetString(objv[1])[0] == '-') {
+        int optIndex;
+        CHECK(Tcl_GetIndexFromObj(ip, objv[1], opts, "option", 0, &optIndex));
+        if (objc < 4) {
+            Tcl_WrongNumArgs(ip, 1, objv, syntax);
+            return TCL_ERROR;
+        }
+        cmdObj  = objv[2];
+        fnIndex = 3;
+    }
+
+    CHECK(CffiFunctionFromCommand(ip, objv[fnIndex], &fnP));
+    if (fnP == NULL) {
+        CHECK(CffiFnPtrResolve(ipCtxP, objv[fnIndex], &fnP));
+    }
+
+    CffiFunctionRef(fnP);
+    ret = CffiFunctionCallAsync(fnP, ip, fnIndex + 1, objc, objv, cmdObj);
+    CffiFunctionUnref(fnP);
+    return ret;
+}
+#endif
+
 static CffiResult
 CffiLimitsObjCmd(ClientData cdata,
                   Tcl_Interp *ip,
@@ -246,7 +519,13 @@ CffiClosureDeleteEntry(Tcl_HashTable *htP, Tcl_HashEntry *heP, ClientData unused
 static void
 CffiInterpCtxCleanupAndFree(CffiInterpCtx *ipCtxP)
 {
+        /* Views must get private copies before arena etc. are released */
+        CffiMemoryViewsCleanup(ipCtxP);
+        CffiMemoryMappingsCleanup(ipCtxP);
+        CffiPoolsCleanup(ipCtxP);
+        CffiAlignedAllocationsCleanup(ipCtxP);
 #ifdef CFFI_USE_LIBFFI
+        CffiAsyncCallsCleanup(ipCtxP);
         CffiLibffiFinit(ipCtxP);
 #endif
 #ifdef CFFI_USE_DYNCALL
@@ -254,13 +533,18 @@ CffiInterpCtxCleanupAndFree(CffiInterpCtx *ipCtxP)
 #endif
         CffiAliasesCleanup(ipCtxP);
         CffiEnumsCleanup(ipCtxP);
+        CffiCallCacheReset(ipCtxP);
+        CffiPointerCacheReset(ipCtxP);
+        Tcl_DeleteHashTable(&ipCtxP->callCache);
         CffiPrototypesCleanup(ipCtxP);
+        CffiCallStatsCleanup(ipCtxP);
 
         Tclh_HashIterate(
             &ipCtxP->callbackClosures, CffiClosureDeleteEntry, NULL);
         Tcl_DeleteHashTable(&ipCtxP->callbackClosures);
 
         CffiArenaFinit(ipCtxP);
+        CffiPointerRangesCleanup(ipCtxP);
 
         Tclh_LifoClose(&ipCtxP->memlifo);
 
@@ -297,10 +581,16 @@ CffiInterpCtxAllocAndInit(Tcl_Interp *ip, CffiInterpCtx **ipCtxPP)
     CffiNameTableInit(&ipCtxP->scope.enums);
     CffiNameTableInit(&ipCtxP->scope.aliases);
     CffiNameTableInit(&ipCtxP->scope.prototypes);
+    Tcl_InitHashTable(&ipCtxP->callCache, TCL_STRING_KEYS);
+    CffiDefinitionsChanged(ipCtxP); /* Unique initial epoch */
+    CffiCallStatsInit(ipCtxP);
 
     /* Table mapping callback closure function addresses to CffiCallback */
     Tcl_InitHashTable(&ipCtxP->callbackClosures, TCL_ONE_WORD_KEYS);
 
+    /* Table mapping aligned allocations to the underlying allocation */
+    Tcl_InitHashTable(&ipCtxP->alignedAllocations, TCL_ONE_WORD_KEYS);
+
 #ifdef CFFI_USE_DYNCALL
     ret = CffiDyncallInit(ipCtxP);
 #endif
@@ -372,6 +662,12 @@ Cffi_Init(Tcl_Interp *ip)
         ip, CFFI_NAMESPACE "::Interface", CffiInterfaceObjCmd, ipCtxP, NULL);
     Tcl_CreateObjCommand(
         ip, CFFI_NAMESPACE "::call", CffiCallObjCmd, ipCtxP, NULL);
+    Tcl_CreateObjCommand(
+        ip, CFFI_NAMESPACE "::batch", CffiBatchObjCmd, ipCtxP, NULL);
+#ifdef CFFI_USE_LIBFFI
+    Tcl_CreateObjCommand(
+        ip, CFFI_NAMESPACE "::async", CffiAsyncObjCmd, ipCtxP, NULL);
+#endif
 #ifdef CFFI_HAVE_CALLBACKS
     Tcl_CreateObjCommand(
         ip, CFFI_NAMESPACE "::callback", CffiCallbackObjCmd, ipCtxP, NULL);
@@ -398,6 +694,12 @@ Cffi_Init(Tcl_Interp *ip)
         ip, CFFI_NAMESPACE "::savederrors", CffiSavedErrorsObjCmd, ipCtxP, NULL);
     Tcl_CreateObjCommand(
         ip, CFFI_NAMESPACE "::sandbox", CffiSandboxObjCmd, NULL, NULL);
+    Tcl_CreateObjCommand(
+        ip, CFFI_NAMESPACE "::stats", CffiStatsObjCmd, ipCtxP, NULL);
+    Tcl_CreateObjCommand(
+        ip, CFFI_NAMESPACE "::image", CffiImageObjCmd, ipCtxP, NULL);
+    Tcl_CreateObjCommand(
+        ip, CFFI_NAMESPACE "::vector", CffiVectorObjCmd, ipCtxP, NULL);
 
     Tcl_CallWhenDeleted(ip, CffiFinit, ipCtxP);
 
@@ -141,7 +141,9 @@ CffiAliasAdd(CffiInterpCtx *ipCtxP,
                          typeAttrsP,
                          &fqnObj);
 
-    if (ret != TCL_OK) {
+    if (ret == TCL_OK)
+        CffiDefinitionsChanged(ipCtxP);
+    else {
         /* Only permit if definition is the same */
         CffiTypeAndAttrs *oldP;
         Tcl_Obj *oldObj;
@@ -319,6 +321,7 @@ CffiAliasDeleteCmd(CffiInterpCtx *ipCtxP,
                     Tcl_Obj *const objv[])
 {
     CFFI_ASSERT(objc == 3);
+    CffiDefinitionsChanged(ipCtxP);
     return CffiNameDeleteNames(ipCtxP->interp,
                                &ipCtxP->scope.aliases,
                                Tcl_GetString(objv[2]),
@@ -332,6 +335,7 @@ CffiAliasClearCmd(CffiInterpCtx *ipCtxP,
                   Tcl_Obj *const objv[])
 {
     CFFI_ASSERT(objc == 2);
+    CffiDefinitionsChanged(ipCtxP);
     return CffiNameDeleteNames(ipCtxP->interp,
                                &ipCtxP->scope.aliases,
                                NULL,
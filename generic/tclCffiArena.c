@@ -12,19 +12,73 @@
 /* Round up to alignment size */
 #define ROUNDUP(x_) ((ALIGNMENT - 1 + (x_)) & ALIGNMASK)
 
+/*
+ * Allocations in a frame are not registered individually. The memory they
+ * occupy is registered as a single address range that grows with every
+ * allocation so the validity of pointers into the frame derives from that
+ * one entry. Popping a frame drops the range irrespective of the number of
+ * allocations made from it. A further range is only started when the
+ * memlifo places an allocation in a new chunk.
+ */
 typedef struct CffiArenaFrame {
     struct CffiArenaFrame *prevFrameP;
-    struct CffiArenaAllocationLink *allocationsP; /* List of allocations in this arena */
+    char *rangeStartP;    /* Start of current address range, NULL if none */
+    char *rangeEndP;      /* End of current address range */
+    char **oldRangesP;    /* Starts of earlier ranges of the frame */
+    Tcl_Size nOldRanges;  /* Number of entries in oldRangesP */
 } CffiArenaFrame;
 #define ARENA_FRAME_HEADER_SIZE ROUNDUP(sizeof(CffiArenaFrame))
 
-typedef struct CffiArenaAllocationLink {
-    struct CffiArenaAllocationLink *prevAllocationP;
-} CffiArenaAllocationLink;
-#define ARENA_ALLOCATION_LINK_SIZE ROUNDUP(sizeof(CffiArenaAllocationLink))
+/*
+ * Maximum gap between the end of the current range and the next allocation
+ * for the range to be extended. Allows for rounding by the memlifo.
+ */
+#define ARENA_RANGE_MAX_GAP (2 * ALIGNMENT)
 
 static CffiResult CffiArenaPopFrame(CffiInterpCtx *ipCtxP);
 
+/* Function: CffiArenaAddAllocation
+ * Adds an allocation to the address range of the top frame.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address of the allocation
+ * size - size of the allocation
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in the interpreter.
+ */
+static CffiResult
+CffiArenaAddAllocation(CffiInterpCtx *ipCtxP, void *pv, Tcl_Size size)
+{
+    CffiArenaFrame *arenaFrameP = ipCtxP->arenaFrameP;
+    char *startP = (char *)pv;
+    char *endP   = startP + size;
+
+    if (arenaFrameP->rangeStartP) {
+        if (startP >= arenaFrameP->rangeEndP
+            && (startP - arenaFrameP->rangeEndP) <= ARENA_RANGE_MAX_GAP
+            && CffiPointerRangeExtend(
+                ipCtxP, arenaFrameP->rangeStartP, endP)) {
+            arenaFrameP->rangeEndP = endP;
+            return TCL_OK;
+        }
+    }
+
+    CHECK(CffiPointerRangeRegister(ipCtxP, pv, size));
+    if (arenaFrameP->rangeStartP) {
+        /* Rare, only when the memlifo moves on to another chunk */
+        arenaFrameP->oldRangesP =
+            ckrealloc(arenaFrameP->oldRangesP,
+                      (arenaFrameP->nOldRanges + 1) * sizeof(char *));
+        arenaFrameP->oldRangesP[arenaFrameP->nOldRanges++] =
+            arenaFrameP->rangeStartP;
+    }
+    arenaFrameP->rangeStartP = startP;
+    arenaFrameP->rangeEndP   = endP;
+    return TCL_OK;
+}
+
 CffiResult CffiArenaInit(CffiInterpCtx *ipCtxP)
 {
     if (Tclh_LifoInit(
@@ -53,8 +107,6 @@ memFail:
     }
 
     Tcl_Size extra = ARENA_FRAME_HEADER_SIZE;
-    if (size && allocationP)
-        extra += ARENA_ALLOCATION_LINK_SIZE;
 
     if ((TCL_SIZE_MAX - extra) < size)
         goto memFail;
@@ -65,17 +117,20 @@ memFail:
         goto memFail;
 
     /* Link on to list of active arenas */
-    arenaFrameP->prevFrameP = ipCtxP->arenaFrameP;
-    ipCtxP->arenaFrameP     = arenaFrameP;
-    arenaFrameP->allocationsP = NULL;
+    arenaFrameP->prevFrameP  = ipCtxP->arenaFrameP;
+    ipCtxP->arenaFrameP      = arenaFrameP;
+    arenaFrameP->rangeStartP = NULL;
+    arenaFrameP->rangeEndP   = NULL;
+    arenaFrameP->oldRangesP  = NULL;
+    arenaFrameP->nOldRanges  = 0;
 
     if (size && allocationP) {
-        CffiArenaAllocationLink *arenaLinkP;
-        arenaLinkP   = (CffiArenaAllocationLink *) (ARENA_FRAME_HEADER_SIZE + (char *)arenaFrameP);
-        arenaLinkP->prevAllocationP = NULL;
-        arenaFrameP->allocationsP   = arenaLinkP;
-        *allocationP = ARENA_ALLOCATION_LINK_SIZE + (char *)arenaLinkP;
-        CFFI_ASSERT(*allocationP == (extra + (char *)arenaFrameP));
+        void *pv = extra + (char *)arenaFrameP;
+        if (CffiArenaAddAllocation(ipCtxP, pv, size) != TCL_OK) {
+            CffiArenaPopFrame(ipCtxP);
+            return TCL_ERROR;
+        }
+        *allocationP = pv;
     }
     else {
         /* No allocation requested. */
@@ -100,19 +155,15 @@ memFail:
             "Internal error: attempt to allocate from an empty arena.");
     }
 
-    if ((TCL_SIZE_MAX - ARENA_ALLOCATION_LINK_SIZE) < size)
+    /* Allocate within the current memlifo frame, no new mark */
+    void *pv = Tclh_LifoAlloc(&ipCtxP->arenaStore, size);
+    if (pv == NULL)
         goto memFail;
 
-    CffiArenaAllocationLink *arenaLinkP =
-        Tclh_LifoPushFrame(&ipCtxP->arenaStore, size + ARENA_ALLOCATION_LINK_SIZE);
-    if (arenaLinkP == NULL)
-        goto memFail;
-
-    arenaLinkP->prevAllocationP = ipCtxP->arenaFrameP->allocationsP;
-    ipCtxP->arenaFrameP->allocationsP   = arenaLinkP;
-
-    *allocationP = ARENA_ALLOCATION_LINK_SIZE + (char *)arenaLinkP;
+    /* Memory is released when the frame is popped even on error */
+    CHECK(CffiArenaAddAllocation(ipCtxP, pv, size));
 
+    *allocationP = pv;
     return TCL_OK;
 }
 
@@ -128,12 +179,14 @@ CffiArenaPopFrame(CffiInterpCtx *ipCtxP)
     }
     ipCtxP->arenaFrameP = arenaFrameP->prevFrameP;
 
-    /* Unregister any pointers that might have been registered */
-    CffiArenaAllocationLink *arenaLinkP;
-    for (arenaLinkP = arenaFrameP->allocationsP; arenaLinkP;
-         arenaLinkP = arenaLinkP->prevAllocationP) {
-        void *p = ARENA_ALLOCATION_LINK_SIZE + (char *)arenaLinkP;
-        (void)Tclh_PointerUnregister(ipCtxP->interp, ipCtxP->tclhCtxP, p);
+    /* Drop the address range covering the frame's allocations */
+    if (arenaFrameP->rangeStartP)
+        CffiPointerRangeUnregister(ipCtxP, arenaFrameP->rangeStartP);
+    if (arenaFrameP->oldRangesP) {
+        Tcl_Size i;
+        for (i = 0; i < arenaFrameP->nOldRanges; ++i)
+            CffiPointerRangeUnregister(ipCtxP, arenaFrameP->oldRangesP[i]);
+        ckfree(arenaFrameP->oldRangesP);
     }
     Tclh_LifoPopFrame(&ipCtxP->arenaStore);
     return TCL_OK;
@@ -153,15 +206,23 @@ CffiArenaValidate(CffiInterpCtx *ipCtxP)
 
     CffiArenaFrame *frameP;
     for (frameP = ipCtxP->arenaFrameP; frameP; frameP = frameP->prevFrameP) {
-        CffiArenaAllocationLink *linkP;
-        for (linkP = frameP->allocationsP; linkP;
-             linkP = linkP->prevAllocationP) {
-            void *p = ARENA_ALLOCATION_LINK_SIZE + (char *)linkP;
-            CHECK(
-                Tclh_PointerVerify(ipCtxP->interp, ipCtxP->tclhCtxP, p));
+        Tcl_Size i;
+        if (frameP->rangeStartP == NULL)
+            continue;
+        if (!CffiPointerRangeLookup(ipCtxP, frameP->rangeStartP)
+            || !CffiPointerRangeLookup(ipCtxP, frameP->rangeEndP - 1)) {
+            goto invalid_range;
+        }
+        for (i = 0; i < frameP->nOldRanges; ++i) {
+            if (!CffiPointerRangeLookup(ipCtxP, frameP->oldRangesP[i]))
+                goto invalid_range;
         }
     }
     return TCL_OK;
+
+invalid_range:
+    return Tclh_ErrorGeneric(
+        ipCtxP->interp, NULL, "Arena address range is not registered.");
 }
 
 CffiResult
@@ -174,26 +235,62 @@ CffiArenaObjCmd(ClientData cdata,
     enum cmds { ALLOCATE, NEW, POPFRAME, PUSHFRAME, VALIDATE };
     int cmdIndex;
     static Tclh_SubCommand subCommands[] = {
-        {"allocate", 1, 2, "SIZE ?TAG?", NULL},
+        {"allocate", 1, 4, "?-align ALIGNMENT? SIZE ?TAG?", NULL},
         {"new", 2, 3, "TYPE INITIALIZER ?TAG?", NULL},
         {"popframe", 0, 0, "", NULL},
         {"pushframe", 0, 2, "?SIZE ?TAG??", NULL},
         {"validate", 0, 0, "", NULL},
         {NULL}};
     void *pv;
+    void *allocP;
     Tcl_Obj *resultObj = NULL;
     Tcl_Size size = 0;
+    Tcl_Size align = 0;
     CffiResult ret = TCL_OK;
+    int i;
     CffiTypeAndAttrs typeAttrs;
 
     CHECK(Tclh_SubCommandLookup(ip, subCommands, objc, objv, &cmdIndex));
     switch (cmdIndex) {
     case ALLOCATE:
-        CHECK(CffiParseAllocationSize(ipCtxP, objv[2], &size));
-        CHECK(CffiArenaAllocate(ipCtxP, size, &pv));
-        /* Note nothing to free if pointer obj creation fails */
-        ret = CffiMakePointerObj(
-            ipCtxP, pv, objc > 3 ? objv[3] : NULL, 0, &resultObj);
+        i = 2;
+        if (!strcmp(Tcl_GetString(objv[2]), "-align")) {
+            if (objc == 3)
+                return Tclh_ErrorOptionValueMissing(ip, objv[2], NULL);
+            CHECK(CffiAlignmentFromObj(ip, objv[3], &align));
+            i = 4;
+        }
+        if (objc - i < 1 || objc - i > 2) {
+            Tcl_WrongNumArgs(ip, 2, objv, "?-align ALIGNMENT? SIZE ?TAG?");
+            return TCL_ERROR;
+        }
+        CHECK(CffiParseAllocationSize(ipCtxP, objv[i], &size));
+        if (align > 1) {
+            /*
+             * Over-allocate and round up. Nothing to track for freeing
+             * since the whole frame is released on pop.
+             */
+            if (size > TCL_SIZE_MAX - align) {
+                return Tclh_ErrorAllocation(
+                    ip, "Arena", "Could not allocate arena memory.");
+            }
+            CHECK(CffiArenaAllocate(ipCtxP, size + align - 1, &allocP));
+            pv = (void *)(((uintptr_t)allocP + align - 1)
+                          & ~(uintptr_t)(align - 1));
+        }
+        else {
+            CHECK(CffiArenaAllocate(ipCtxP, size, &allocP));
+            pv = allocP;
+        }
+        /*
+         * Note nothing to free if pointer obj creation fails. Pointer is
+         * not registered as it lies in the frame's registered range.
+         */
+        ret = CffiMakePointerObj(ipCtxP,
+                                 pv,
+                                 objc > i + 1 ? objv[i + 1] : NULL,
+                                 CFFI_F_ATTR_UNSAFE,
+                                 &resultObj);
         break;
 
     case NEW:
@@ -203,8 +300,11 @@ CffiArenaObjCmd(ClientData cdata,
         /* Note nothing to free on failure */
         CHECK(CffiNativeValueFromObj(
             ipCtxP, &typeAttrs, 0, objv[3], 0, pv, 0, NULL));
-        ret = CffiMakePointerObj(
-            ipCtxP, pv, objc > 4 ? objv[4] : NULL, 0, &resultObj);
+        ret = CffiMakePointerObj(ipCtxP,
+                                 pv,
+                                 objc > 4 ? objv[4] : NULL,
+                                 CFFI_F_ATTR_UNSAFE,
+                                 &resultObj);
         break;
 
     case PUSHFRAME:
@@ -214,8 +314,11 @@ CffiArenaObjCmd(ClientData cdata,
         CHECK(CffiArenaPushFrame(ipCtxP, size, &pv));
         if (size) {
             CFFI_ASSERT(pv);
-            ret = CffiMakePointerObj(
-                ipCtxP, pv, objc > 3 ? objv[3] : NULL, 0, &resultObj);
+            ret = CffiMakePointerObj(ipCtxP,
+                                     pv,
+                                     objc > 3 ? objv[3] : NULL,
+                                     CFFI_F_ATTR_UNSAFE,
+                                     &resultObj);
             if (ret != TCL_OK) {
                 CffiArenaPopFrame(ipCtxP); /* Pop frame we just created */
             }
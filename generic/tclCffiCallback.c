@@ -303,6 +303,7 @@ CffiCallbackFreeCmd(CffiInterpCtx *ipCtxP,
     CHECK(Tclh_PointerObjGetTag(ip, objv[2], &tagObj));
     if (tagObj == NULL)
         return Tclh_ErrorInvalidValue(ip, objv[2], "Not a callback function pointer.");
+    CffiPointerRegistryChanged(ipCtxP);
     ret = Tclh_PointerUnregisterTagged(ip, ipCtxP->tclhCtxP, pv, tagObj);
     if (ret == TCL_OK)
         CffiCallbackCleanupAndFree(cbP);
@@ -363,8 +364,10 @@ CffiCallbackNewCmd(CffiInterpCtx *ipCtxP,
 #endif
     /*
      * Construct return function pointer value. This pointer is passed
-     * as the callback function address.
+     * as the callback function address. Registration may replace the tag
+     * of a stale registration of a reused closure address.
      */
+    CffiPointerRegistering(ipCtxP, executableAddr);
     ret = Tclh_PointerRegister(
         ip, ipCtxP->tclhCtxP, executableAddr, protoFqnObj, &cbObj);
     if (ret == TCL_OK) {
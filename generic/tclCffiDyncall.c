@@ -256,7 +256,7 @@ CffiDyncallVarargsInit(CffiInterpCtx *ipCtxP,
                 ip, varArgObjs[i], "A vararg must be a type and value pair.");
             break;
         }
-        ret = CffiTypeAndAttrsParse(
+        ret = CffiTypeAndAttrsParseCached(
             ipCtxP, argObjs[0], CFFI_F_TYPE_PARSE_PARAM, &varArgTypesP[i]);
         if (ret != TCL_OK)
             break;
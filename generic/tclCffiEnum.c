@@ -18,6 +18,7 @@ CffiEnumNameDeleteCallback(ClientData clientData)
 static CffiResult
 CffiEnumDelete(CffiInterpCtx *ipCtxP, Tcl_Obj *nameObj)
 {
+    CffiDefinitionsChanged(ipCtxP);
     return CffiNameDeleteNames(ipCtxP->interp,
                                &ipCtxP->scope.enums,
                                Tcl_GetString(nameObj),
@@ -255,6 +256,7 @@ CffiEnumDefine(CffiInterpCtx *ipCtxP,
         return TCL_ERROR;
     }
     Tcl_IncrRefCount(membersObj); /* As it is stored in members dictionary */
+    CffiDefinitionsChanged(ipCtxP);
     *fqnObjP = fqnObj;
     return TCL_OK;
 }
@@ -421,8 +423,10 @@ CffiEnumFlagsCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
     Tcl_IncrRefCount(enumObj);
     ret = CffiNameObjAdd(
         ip, &ipCtxP->scope.enums, objv[2], "Enum", enumObj, &fqnObj);
-    if (ret == TCL_OK)
+    if (ret == TCL_OK) {
+        CffiDefinitionsChanged(ipCtxP);
         Tcl_SetObjResult(ip, fqnObj);
+    }
     else
         Tcl_DecrRefCount(enumObj);
     return ret;
@@ -473,8 +477,10 @@ CffiEnumSequenceCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
     Tcl_IncrRefCount(enumObj);
     ret = CffiNameObjAdd(
         ip, &ipCtxP->scope.enums, objv[2], "Enum", enumObj, &fqnObj);
-    if (ret == TCL_OK)
+    if (ret == TCL_OK) {
+        CffiDefinitionsChanged(ipCtxP);
         Tcl_SetObjResult(ip, fqnObj);
+    }
     else
         Tcl_DecrRefCount(enumObj);
     return ret;
@@ -549,6 +555,7 @@ static CffiResult
 CffiEnumClearCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
 {
     CFFI_ASSERT(objc == 2);
+    CffiDefinitionsChanged(ipCtxP);
     return CffiNameDeleteNames(ipCtxP->interp,
                                &ipCtxP->scope.enums,
                                NULL,
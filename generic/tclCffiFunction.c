@@ -7,6 +7,9 @@
 
 #define TCLH_SHORTNAMES
 #include "tclCffiInt.h"
+#ifndef _WIN32
+#include <time.h>
+#endif
 
 static CffiResult CffiArgPrepare(CffiCall *callP, int arg_index, Tcl_Obj *valueObj);
 static CffiResult
@@ -15,9 +18,8 @@ static void CffiArgCleanup(CffiCall *callP, int arg_index);
 static CffiResult CffiReturnPrepare(CffiCall *callP);
 static CffiResult CffiReturnCleanup(CffiCall *callP);
 static void CffiPointerArgsDispose(CffiInterpCtx *ipCtxP,
-                                   int nArgs,
-                                   CffiArgument *argsP,
-                                   int callSucceeded);
+                                   CffiCall *callP,
+                                   int callFailed);
 static CffiResult CffiGetCountFromValue(Tcl_Interp *ip,
                                         CffiBaseType valueType,
                                         const CffiValue *valueP,
@@ -40,66 +42,170 @@ CffiGrabSystemError(const CffiTypeAndAttrs *typeAttrsP,
 }
 
 
+/* Function: CffiPointerArgDispose
+ * Disposes a pointer argument if so annotated.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * argP - argument value
+ * callFailed - 0 if the function invocation had succeeded, else non-0
+ *
+ * Returns:
+ * Nothing.
+ */
+static void
+CffiPointerArgDispose(CffiInterpCtx *ipCtxP,
+                      CffiArgument *argP,
+                      int callFailed)
+{
+    CffiTypeAndAttrs *typeAttrsP = argP->typeAttrsP;
+    if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_POINTER
+        && (typeAttrsP->flags & (CFFI_F_ATTR_IN | CFFI_F_ATTR_INOUT))) {
+        /*
+         * DISPOSE - always dispose of pointer
+         * DISPOSEONSUCCESS - dispose if the call had returned successfully
+         */
+        if ((typeAttrsP->flags & CFFI_F_ATTR_DISPOSE)
+            || ((typeAttrsP->flags & CFFI_F_ATTR_DISPOSEONSUCCESS)
+                && !callFailed)) {
+            Tcl_Interp *ip = ipCtxP->interp;
+            int nptrs = argP->arraySize;
+            CffiPointerRegistryChanged(ipCtxP);
+            /* Note no error checks because the CffiFunctionSetup calls
+               above would have already done validation */
+            if (nptrs < 0) {
+                /* Scalar */
+                if (argP->savedValue.u.ptr != NULL) {
+                    Tclh_PointerUnregister(
+                        ip, ipCtxP->tclhCtxP, argP->savedValue.u.ptr);
+                    /* No copy as the callee may have freed the memory */
+                    CffiPointerReleased(ipCtxP, argP->savedValue.u.ptr, 0);
+                }
+            }
+            else {
+                /* Array */
+                int j;
+                void **ptrArray = argP->savedValue.u.ptr;
+                CFFI_ASSERT(ptrArray);
+                for (j = 0; j < nptrs; ++j) {
+                    if (ptrArray[j] != NULL) {
+                        Tclh_PointerUnregister(
+                            ip, ipCtxP->tclhCtxP, ptrArray[j]);
+                        CffiPointerReleased(ipCtxP, ptrArray[j], 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
 /* Function: CffiPointerArgsDispose
  * Disposes pointer arguments
  *
  * Parameters:
- * ip - interpreter
- * nArgs - size of argsP[]
- * argsP - array of argument values
+ * ipCtxP - interpreter context
+ * callP - the call context
  * callFailed - 0 if the function invocation had succeeded, else non-0
  *
  * The function loops through all argument values that are pointers
  * and annotated as *dispose* or *disposeonsuccess*. Any such pointers
- * are unregistered.
+ * are unregistered. For fixed parameters, the candidates are taken
+ * from the prototype's call plan.
  *
  * Returns:
  * Nothing.
  */
 static void
 CffiPointerArgsDispose(CffiInterpCtx *ipCtxP,
-                       int nArgs,
-                       CffiArgument *argsP,
+                       CffiCall *callP,
                        int callFailed)
 {
-    Tcl_Interp *ip = ipCtxP->interp;
+    CffiProto *protoP         = callP->fnP->protoP;
+    const CffiCallPlan *planP = protoP->planP;
     int i;
-    for (i = 0; i < nArgs; ++i) {
-        CffiTypeAndAttrs *typeAttrsP = argsP[i].typeAttrsP;
-        if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_POINTER
-            && (typeAttrsP->flags & (CFFI_F_ATTR_IN | CFFI_F_ATTR_INOUT))) {
-            /*
-             * DISPOSE - always dispose of pointer
-             * DISPOSEONSUCCESS - dispose if the call had returned successfully
-             */
-            if ((typeAttrsP->flags & CFFI_F_ATTR_DISPOSE)
-                || ((typeAttrsP->flags & CFFI_F_ATTR_DISPOSEONSUCCESS)
-                    && !callFailed)) {
-                int nptrs = argsP[i].arraySize;
-                /* Note no error checks because the CffiFunctionSetup calls
-                   above would have already done validation */
-                if (nptrs < 0) {
-                    /* Scalar */
-                    if (argsP[i].savedValue.u.ptr != NULL)
-                        Tclh_PointerUnregister(
-                            ip, ipCtxP->tclhCtxP, argsP[i].savedValue.u.ptr);
-                }
-                else {
-                    /* Array */
-                    int j;
-                    void **ptrArray = argsP[i].savedValue.u.ptr;
-                    CFFI_ASSERT(ptrArray);
-                    for (j = 0; j < nptrs; ++j) {
-                        if (ptrArray[j] != NULL)
-                            Tclh_PointerUnregister(
-                                ip, ipCtxP->tclhCtxP, ptrArray[j]);
-                    }
-                }
+
+    for (i = 0; i < planP->nDispose; ++i) {
+        CffiPointerArgDispose(
+            ipCtxP, &callP->argsP[planP->disposeIndices[i]], callFailed);
+    }
+    /* Varargs are not covered by the call plan */
+    for (i = protoP->nParams; i < callP->nArgs; ++i) {
+        CffiPointerArgDispose(ipCtxP, &callP->argsP[i], callFailed);
+    }
+}
+
+/* Function: CffiPointerArgSnapshotViews
+ * Detaches memory views of a pointer argument that is to be disposed.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * argP - argument value
+ *
+ * Must be called before the function is invoked. Views of pointers passed
+ * as *dispose* or *disposeonsuccess* arguments are given a copy of the
+ * memory content as the callee may free the memory.
+ *
+ * Returns:
+ * Nothing.
+ */
+static void
+CffiPointerArgSnapshotViews(CffiInterpCtx *ipCtxP, CffiArgument *argP)
+{
+    CffiTypeAndAttrs *typeAttrsP = argP->typeAttrsP;
+    if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_POINTER
+        && (typeAttrsP->flags & (CFFI_F_ATTR_IN | CFFI_F_ATTR_INOUT))
+        && (typeAttrsP->flags
+            & (CFFI_F_ATTR_DISPOSE | CFFI_F_ATTR_DISPOSEONSUCCESS))) {
+        if (argP->arraySize < 0) {
+            /* Scalar */
+            if (argP->savedValue.u.ptr != NULL)
+                CffiPointerViewsSnapshot(ipCtxP, argP->savedValue.u.ptr);
+        }
+        else {
+            /* Array */
+            int j;
+            void **ptrArray = argP->savedValue.u.ptr;
+            CFFI_ASSERT(ptrArray);
+            for (j = 0; j < argP->arraySize; ++j) {
+                if (ptrArray[j] != NULL)
+                    CffiPointerViewsSnapshot(ipCtxP, ptrArray[j]);
             }
         }
     }
 }
 
+/* Function: CffiPointerArgsSnapshotViews
+ * Detaches memory views of pointer arguments that are to be disposed.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * callP - the call context
+ *
+ * See <CffiPointerArgSnapshotViews>. Candidates are selected as for
+ * <CffiPointerArgsDispose>.
+ *
+ * Returns:
+ * Nothing.
+ */
+static void
+CffiPointerArgsSnapshotViews(CffiInterpCtx *ipCtxP, CffiCall *callP)
+{
+    CffiProto *protoP         = callP->fnP->protoP;
+    const CffiCallPlan *planP = protoP->planP;
+    int i;
+
+    if (ipCtxP->memoryViewsP == NULL)
+        return;
+    for (i = 0; i < planP->nDispose; ++i) {
+        CffiPointerArgSnapshotViews(
+            ipCtxP, &callP->argsP[planP->disposeIndices[i]]);
+    }
+    /* Varargs are not covered by the call plan */
+    for (i = protoP->nParams; i < callP->nArgs; ++i) {
+        CffiPointerArgSnapshotViews(ipCtxP, &callP->argsP[i]);
+    }
+}
+
 /* Function: CffiArgPrepareChars
  * Initializes a CffiValue to pass a chars argument.
  *
@@ -684,8 +790,11 @@ CffiArgPrepare(CffiCall *callP, int arg_index, Tcl_Obj *valueObj)
 
                 if (passOutputPointerAsNull)
                     dict_size = 0;
+                else if (flags & CFFI_F_ATTR_LIST) {
+                    CHECK(Tcl_ListObjLength(ip, valueObj, &dict_size));
+                }
                 else {
-                    CHECK(Tcl_DictObjSize(ip, valueObj, &dict_size));
+                    CHECK(CffiStructObjDictSize(ip, valueObj, &dict_size));
                 }
                 if (dict_size == 0) {
                     /* Empty dictionary AND NULLIFEMPTY set */
@@ -704,10 +813,13 @@ CffiArgPrepare(CffiCall *callP, int arg_index, Tcl_Obj *valueObj)
                                        NULL));
             structValueP = Tclh_LifoAlloc(&ipCtxP->memlifo, needed);
             if (flags & (CFFI_F_ATTR_IN | CFFI_F_ATTR_INOUT)) {
-                CHECK(CffiStructFromObj(ipCtxP,
-                                        typeAttrsP->dataType.u.structP,
-                                        valueObj, 0,
-                                        structValueP, &ipCtxP->memlifo));
+                CHECK(CffiStructFromObj(
+                    ipCtxP,
+                    typeAttrsP->dataType.u.structP,
+                    valueObj,
+                    (flags & CFFI_F_ATTR_LIST) ? CFFI_F_AS_LIST : 0,
+                    structValueP,
+                    &ipCtxP->memlifo));
             }
             else if (typeAttrsP->dataType.u.structP->structSizeFieldIndex >= 0) {
                 CffiStructInitSizeField(typeAttrsP->dataType.u.structP,
@@ -761,10 +873,13 @@ CffiArgPrepare(CffiCall *callP, int arg_index, Tcl_Obj *valueObj)
                     nvalues = argP->arraySize;
                 for (toP = valueArray, i = 0; i < nvalues;
                      toP += struct_size, ++i) {
-                    CHECK(CffiStructFromObj(ipCtxP,
-                                            typeAttrsP->dataType.u.structP,
-                                            valueObjList[i], 0,
-                                            toP, &ipCtxP->memlifo));
+                    CHECK(CffiStructFromObj(
+                        ipCtxP,
+                        typeAttrsP->dataType.u.structP,
+                        valueObjList[i],
+                        (flags & CFFI_F_ATTR_LIST) ? CFFI_F_AS_LIST : 0,
+                        toP,
+                        &ipCtxP->memlifo));
                 }
                 if (i < argP->arraySize) {
                     /* Fill uninitialized with 0 */
@@ -898,9 +1013,13 @@ CffiArgPrepare(CffiCall *callP, int arg_index, Tcl_Obj *valueObj)
     case CFFI_K_TYPE_BINARY:
         CFFI_ASSERT(typeAttrsP->flags & CFFI_F_ATTR_IN);
         /* Pure input but could still shimmer so copy to memlifo */
-        p = (char *)Tcl_GetByteArrayFromObj(valueObj, &len);
+        p = (char *)CffiGetByteArrayFromObj(valueObj, &len);
         /* If zero length, always store null pointer regardless of nullifempty */
-        if (len) {
+        if (len && CffiIsMemoryViewObj(valueObj)) {
+            /* Views do not shimmer. Pass the viewed memory without copying */
+            argP->value.u.ptr = p;
+        }
+        else if (len) {
             argP->value.u.ptr = Tclh_LifoAlloc(&ipCtxP->memlifo, len);
             memmove(argP->value.u.ptr, p, len);
         }
@@ -1573,6 +1692,339 @@ CffiGetCountFromValue(Tcl_Interp *ip,
     return TCL_OK;
 }
 
+/*
+ * Argument converters specialized for scalar numeric and pointer input
+ * parameters passed by value. These are by far the most common parameter
+ * types and do not need the generic checks in CffiArgPrepare. They are
+ * selected per parameter by CffiCallPlanInit.
+ */
+#ifdef CFFI_USE_LIBFFI
+#define STOREFASTARG_(storefn_, fld_) \
+    (callP->argValuesPP[arg_index] = &argP->value.u.fld_)
+#endif
+#ifdef CFFI_USE_DYNCALL
+#define STOREFASTARG_(storefn_, fld_) \
+    storefn_(callP, arg_index, argP->value.u.fld_)
+#endif
+
+#define DEFINEFASTARGFN_(name_, objfn_, storefn_, fld_)                     \
+    static CffiResult CffiArgPrepare##name_(                                \
+        CffiCall *callP, int arg_index, Tcl_Obj *valueObj)                  \
+    {                                                                       \
+        CffiArgument *argP = &callP->argsP[arg_index];                      \
+        CFFI_ASSERT(argP->flags == 0);                                      \
+        CHECK(objfn_(callP->fnP->ipCtxP->interp, valueObj, &argP->value.u.fld_)); \
+        argP->varNameObj = NULL;                                            \
+        STOREFASTARG_(storefn_, fld_);                                      \
+        argP->flags |= CFFI_F_ARG_INITIALIZED;                              \
+        return TCL_OK;                                                      \
+    }
+
+DEFINEFASTARGFN_(SChar, ObjToChar, CffiStoreArgSChar, schar)
+DEFINEFASTARGFN_(UChar, ObjToUChar, CffiStoreArgUChar, uchar)
+DEFINEFASTARGFN_(Short, ObjToShort, CffiStoreArgShort, sshort)
+DEFINEFASTARGFN_(UShort, ObjToUShort, CffiStoreArgUShort, ushort)
+DEFINEFASTARGFN_(Int, ObjToInt, CffiStoreArgInt, sint)
+DEFINEFASTARGFN_(UInt, ObjToUInt, CffiStoreArgUInt, uint)
+DEFINEFASTARGFN_(Long, ObjToLong, CffiStoreArgLong, slong)
+DEFINEFASTARGFN_(ULong, ObjToULong, CffiStoreArgULong, ulong)
+DEFINEFASTARGFN_(LongLong, ObjToLongLong, CffiStoreArgLongLong, slonglong)
+DEFINEFASTARGFN_(ULongLong, ObjToULongLong, CffiStoreArgULongLong, ulonglong)
+DEFINEFASTARGFN_(Float, ObjToFloat, CffiStoreArgFloat, flt)
+DEFINEFASTARGFN_(Double, ObjToDouble, CffiStoreArgDouble, dbl)
+
+#undef DEFINEFASTARGFN_
+
+static CffiResult
+CffiArgPreparePointer(CffiCall *callP, int arg_index, Tcl_Obj *valueObj)
+{
+    CffiArgument *argP = &callP->argsP[arg_index];
+    CFFI_ASSERT(argP->flags == 0);
+    CHECK(CffiPointerFromObj(
+        callP->fnP->ipCtxP, argP->typeAttrsP, valueObj, &argP->value.u.ptr));
+    argP->varNameObj = NULL;
+    STOREFASTARG_(CffiStoreArgPointer, ptr);
+    argP->flags |= CFFI_F_ARG_INITIALIZED;
+    return TCL_OK;
+}
+
+#undef STOREFASTARG_
+
+/* Function: CffiArgPrepareProcGet
+ * Returns the argument converter to use for a parameter type.
+ *
+ * Parameters:
+ * typeAttrsP - parameter type
+ *
+ * Returns:
+ * Pointer to a specialized converter if one exists for the type, or to the
+ * generic CffiArgPrepare otherwise. *NULL* is returned for dynamically sized
+ * arrays since those cannot be set up until other arguments are known.
+ */
+static CffiArgPrepareProc *
+CffiArgPrepareProcGet(const CffiTypeAndAttrs *typeAttrsP)
+{
+    CffiAttrFlags flags = typeAttrsP->flags;
+
+    if (CffiTypeIsVLA(&typeAttrsP->dataType))
+        return NULL;
+    if (CffiTypeIsArray(&typeAttrsP->dataType)
+        || (flags & CFFI_F_ATTR_BYREF)
+        || (flags & CFFI_F_ATTR_PARAM_DIRECTION_MASK) != CFFI_F_ATTR_IN)
+        return CffiArgPrepare;
+
+    if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_POINTER) {
+        if (flags & (CFFI_F_ATTR_DISPOSE | CFFI_F_ATTR_DISPOSEONSUCCESS))
+            return CffiArgPrepare;
+        return CffiArgPreparePointer;
+    }
+
+    /* Enums and bitmasks need symbol lookup */
+    if (flags & (CFFI_F_ATTR_ENUM | CFFI_F_ATTR_BITMASK))
+        return CffiArgPrepare;
+
+    switch (typeAttrsP->dataType.baseType) {
+    case CFFI_K_TYPE_SCHAR: return CffiArgPrepareSChar;
+    case CFFI_K_TYPE_UCHAR: return CffiArgPrepareUChar;
+    case CFFI_K_TYPE_SHORT: return CffiArgPrepareShort;
+    case CFFI_K_TYPE_USHORT: return CffiArgPrepareUShort;
+    case CFFI_K_TYPE_INT: return CffiArgPrepareInt;
+    case CFFI_K_TYPE_UINT: return CffiArgPrepareUInt;
+    case CFFI_K_TYPE_LONG: return CffiArgPrepareLong;
+    case CFFI_K_TYPE_ULONG: return CffiArgPrepareULong;
+    case CFFI_K_TYPE_LONGLONG: return CffiArgPrepareLongLong;
+    case CFFI_K_TYPE_ULONGLONG: return CffiArgPrepareULongLong;
+    case CFFI_K_TYPE_FLOAT: return CffiArgPrepareFloat;
+    case CFFI_K_TYPE_DOUBLE: return CffiArgPrepareDouble;
+    default: return CffiArgPrepare;
+    }
+}
+
+/* Function: CffiCallPlanFastCallable
+ * Checks whether a prototype is eligible for the fast call path.
+ *
+ * Parameters:
+ * protoP - prototype
+ * planP - call plan for the prototype with argument converters set up
+ *
+ * Eligible prototypes have a bounded number of fixed parameters all of
+ * which have specialized converters, i.e. are scalar numeric or pointer
+ * input parameters passed by value. The return type must be void or a
+ * numeric passed by value with no error checking annotations.
+ *
+ * Returns:
+ * Non-0 if the fast call path can be used, 0 otherwise.
+ */
+static int
+CffiCallPlanFastCallable(const CffiProto *protoP, const CffiCallPlan *planP)
+{
+    const CffiTypeAndAttrs *retTypeAttrsP = &protoP->returnType.typeAttrs;
+    int i;
+
+    if ((protoP->flags & CFFI_F_PROTO_VARARGS)
+        || protoP->nParams > CFFI_FASTCALL_MAX_PARAMS)
+        return 0;
+    for (i = 0; i < protoP->nParams; ++i) {
+        if (planP->argPrepareProcs[i] == NULL
+            || planP->argPrepareProcs[i] == CffiArgPrepare)
+            return 0;
+    }
+
+    if (retTypeAttrsP->flags
+        & (CFFI_F_ATTR_BYREF | CFFI_F_ATTR_REQUIREMENT_MASK
+           | CFFI_F_ATTR_ONERROR | CFFI_F_ATTR_RETVAL))
+        return 0;
+    switch (retTypeAttrsP->dataType.baseType) {
+    case CFFI_K_TYPE_VOID:
+    case CFFI_K_TYPE_SCHAR:
+    case CFFI_K_TYPE_UCHAR:
+    case CFFI_K_TYPE_SHORT:
+    case CFFI_K_TYPE_USHORT:
+    case CFFI_K_TYPE_INT:
+    case CFFI_K_TYPE_UINT:
+    case CFFI_K_TYPE_LONG:
+    case CFFI_K_TYPE_ULONG:
+    case CFFI_K_TYPE_LONGLONG:
+    case CFFI_K_TYPE_ULONGLONG:
+    case CFFI_K_TYPE_FLOAT:
+    case CFFI_K_TYPE_DOUBLE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+#ifdef CFFI_USE_LIBFFI
+/* Function: CffiCallPlanAsyncCallable
+ * Checks whether a prototype is eligible for asynchronous calls.
+ *
+ * Parameters:
+ * protoP - prototype
+ * planP - call plan for the prototype with argument converters set up
+ *
+ * Asynchronous calls store arguments in storage owned by the call and not
+ * in the memlifo. Eligible prototypes are therefore restricted to scalar
+ * numeric and pointer parameters, including output parameters, without
+ * dispose annotations. The return type must be void, numeric or a pointer
+ * passed by value.
+ *
+ * Returns:
+ * Non-0 if the prototype can be called asynchronously, 0 otherwise.
+ */
+static int
+CffiCallPlanAsyncCallable(const CffiProto *protoP, const CffiCallPlan *planP)
+{
+    const CffiTypeAndAttrs *retTypeAttrsP = &protoP->returnType.typeAttrs;
+    CffiBaseType baseType;
+    int i;
+
+    if (protoP->flags & CFFI_F_PROTO_VARARGS)
+        return 0;
+    for (i = 0; i < protoP->nParams; ++i) {
+        const CffiTypeAndAttrs *typeAttrsP = &protoP->params[i].typeAttrs;
+        if (planP->argPrepareProcs[i] == NULL)
+            return 0; /* Dynamic array */
+        if (planP->argPrepareProcs[i] != CffiArgPrepare)
+            continue; /* Specialized scalar converter */
+        if (CffiTypeIsArray(&typeAttrsP->dataType)
+            || (typeAttrsP->flags
+                & (CFFI_F_ATTR_DISPOSE | CFFI_F_ATTR_DISPOSEONSUCCESS)))
+            return 0;
+        baseType = typeAttrsP->dataType.baseType;
+        if (!CffiTypeIsInteger(baseType) && baseType != CFFI_K_TYPE_FLOAT
+            && baseType != CFFI_K_TYPE_DOUBLE
+            && baseType != CFFI_K_TYPE_POINTER)
+            return 0;
+    }
+
+    if (retTypeAttrsP->flags & CFFI_F_ATTR_BYREF)
+        return 0;
+    baseType = retTypeAttrsP->dataType.baseType;
+    return CffiTypeIsInteger(baseType) || baseType == CFFI_K_TYPE_FLOAT
+        || baseType == CFFI_K_TYPE_DOUBLE || baseType == CFFI_K_TYPE_POINTER
+        || baseType == CFFI_K_TYPE_VOID;
+}
+#endif
+
+/* Function: CffiCallPlanInit
+ * Builds the precompiled call plan for a prototype.
+ *
+ * Parameters:
+ * protoP - prototype whose parameters have been fully parsed. Any existing
+ *   plan must have been freed.
+ *
+ * The plan is stored in the *planP* field of the prototype and allocated
+ * as a single block that is freed along with the prototype.
+ *
+ * Returns:
+ * Nothing.
+ */
+void
+CffiCallPlanInit(CffiProto *protoP)
+{
+    CffiCallPlan *planP;
+    int nParams = protoP->nParams;
+    int i;
+    int nScriptArgs;
+    size_t sz;
+
+    /* Converter pointers first so the int arrays after are aligned */
+    sz = sizeof(*planP) + nParams * sizeof(CffiArgPrepareProc *)
+       + 3 * nParams * sizeof(int);
+    planP                  = ckalloc(sz);
+    planP->argPrepareProcs = (CffiArgPrepareProc **)(planP + 1);
+    planP->disposeIndices  = (int *)(planP->argPrepareProcs + nParams);
+    planP->outputIndices   = planP->disposeIndices + nParams;
+    planP->vlaIndices      = planP->outputIndices + nParams;
+    planP->nDispose        = 0;
+    planP->nOutput         = 0;
+    planP->nVLA            = 0;
+    planP->retvalIndex     = -1;
+    planP->minArgs         = 0;
+
+    nScriptArgs = 0;
+    for (i = 0; i < nParams; ++i) {
+        const CffiTypeAndAttrs *typeAttrsP = &protoP->params[i].typeAttrs;
+        CffiAttrFlags flags                = typeAttrsP->flags;
+
+        planP->argPrepareProcs[i] = CffiArgPrepareProcGet(typeAttrsP);
+        if (planP->argPrepareProcs[i] == NULL)
+            planP->vlaIndices[planP->nVLA++] = i;
+
+        if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_POINTER
+            && (flags & (CFFI_F_ATTR_IN | CFFI_F_ATTR_INOUT))
+            && (flags & (CFFI_F_ATTR_DISPOSE | CFFI_F_ATTR_DISPOSEONSUCCESS)))
+            planP->disposeIndices[planP->nDispose++] = i;
+
+        if (flags & CFFI_F_ATTR_RETVAL) {
+            /* Not counted as a script argument nor as a stored output */
+            planP->retvalIndex = i;
+            continue;
+        }
+        if (flags & (CFFI_F_ATTR_INOUT | CFFI_F_ATTR_OUT))
+            planP->outputIndices[planP->nOutput++] = i;
+
+        ++nScriptArgs;
+        /* Arguments up to the last one without a default are mandatory */
+        if (typeAttrsP->parseModeSpecificObj == NULL
+            || (flags & CFFI_F_ATTR_ONERROR))
+            planP->minArgs = nScriptArgs;
+    }
+    planP->maxArgs = nScriptArgs;
+    if (protoP->flags & CFFI_F_PROTO_VARARGS)
+        planP->minArgs = nScriptArgs; /* Defaults not permitted */
+
+    planP->flags = 0;
+    if (CffiCallPlanFastCallable(protoP, planP))
+        planP->flags |= CFFI_F_PLAN_FASTCALL;
+#ifdef CFFI_USE_LIBFFI
+    if (CffiCallPlanAsyncCallable(protoP, planP))
+        planP->flags |= CFFI_F_PLAN_ASYNC;
+#endif
+
+    protoP->planP = planP;
+}
+
+/* Function: CffiArgPrepareVLA
+ * Prepares a dynamically sized array argument for a function call.
+ *
+ * Parameters:
+ * callP - the call context
+ * arg_index - index of the argument. Must be a fixed parameter.
+ * valueObj - the value passed from the script
+ *
+ * The parameter holding the array size must have already been set up.
+ *
+ * Returns:
+ * TCL_OK on success, TCL_ERROR on error with message in the interpreter.
+ */
+static CffiResult
+CffiArgPrepareVLA(CffiCall *callP, int arg_index, Tcl_Obj *valueObj)
+{
+    CffiProto *protoP   = callP->fnP->protoP;
+    CffiArgument *argsP = callP->argsP;
+    int dynamicCountIndex;
+    int actualCount;
+
+    CFFI_ASSERT(arg_index < protoP->nParams);
+    CFFI_ASSERT((argsP[arg_index].flags & CFFI_F_ARG_INITIALIZED) == 0);
+
+    /* Locate the parameter holding the dynamic count */
+    dynamicCountIndex = protoP->params[arg_index].arraySizeParamIndex;
+    CFFI_ASSERT(dynamicCountIndex >= 0 && dynamicCountIndex < protoP->nParams);
+    CFFI_ASSERT(argsP[dynamicCountIndex].flags & CFFI_F_ARG_INITIALIZED);
+
+    CHECK(CffiGetCountFromValue(
+        callP->fnP->ipCtxP->interp,
+        protoP->params[dynamicCountIndex].typeAttrs.dataType.baseType,
+        &argsP[dynamicCountIndex].value,
+        &actualCount));
+
+    argsP[arg_index].typeAttrsP = &protoP->params[arg_index].typeAttrs;
+    argsP[arg_index].arraySize  = actualCount;
+    return CffiArgPrepare(callP, arg_index, valueObj);
+}
+
 /* Function: CffiFunctionSetupArgs
  * Prepares the arguments needed for a function call.
  *
@@ -1600,13 +2052,14 @@ CffiFunctionSetupArgs(CffiCall *callP,
                       CffiTypeAndAttrs *varArgTypesP)
 {
     int i;
-    int need_pass2;
     CffiArgument *argsP;
     CffiProto *protoP;
+    const CffiCallPlan *planP;
     Tcl_Interp *ip;
     CffiInterpCtx *ipCtxP;
 
     protoP = callP->fnP->protoP;
+    planP  = protoP->planP;
     ipCtxP = callP->fnP->ipCtxP;
     ip     = ipCtxP->interp;
 
@@ -1637,14 +2090,18 @@ CffiFunctionSetupArgs(CffiCall *callP,
      * Arguments are set up in two phases - first set up those arguments that
      * are not dependent on other argument values. Then loop again to set up
      * the latter. Currently only dynamically sized arrays are dependent on
-     * other arguments.
+     * other arguments. The converter for each fixed parameter comes from
+     * the prototype call plan.
      */
-    need_pass2 = 0;
     for (i = 0; i < callP->nArgs; ++i) {
         CffiTypeAndAttrs *typeAttrsP;
+        CffiArgPrepareProc *prepareProc;
 
         if (i < protoP->nParams) {
             /* Fixed param */
+            prepareProc = planP->argPrepareProcs[i];
+            if (prepareProc == NULL)
+                continue; /* Dynamic array. Done in second pass */
             typeAttrsP = &protoP->params[i].typeAttrs;
         }
         else {
@@ -1657,24 +2114,28 @@ CffiFunctionSetupArgs(CffiCall *callP,
             }
 #endif
             typeAttrsP = &varArgTypesP[i - protoP->nParams];
+            if (CffiTypeIsVLA(&typeAttrsP->dataType)) {
+                Tclh_ErrorWrongType(ip,
+                                    NULL,
+                                    "Dynamically sized arrays not permitted for "
+                                    "varargs arguments.");
+                goto cleanup_and_error;
+            }
+            prepareProc = CffiArgPrepare;
         }
 
-        if (CffiTypeIsVLA(&typeAttrsP->dataType)) {
-            /* Dynamic array. */
-            need_pass2 = 1;
-            continue;
-        }
         argsP[i].typeAttrsP = typeAttrsP;
 
         /* Scalar or fixed size array. Type decl should have ensured size!=0 */
         argsP[i].arraySize = typeAttrsP->dataType.arraySize;
-        if (CffiArgPrepare(callP, i, argObjs[i]) != TCL_OK)
+        if (prepareProc(callP, i, argObjs[i]) != TCL_OK)
             goto cleanup_and_error;
     }
 
-    if (need_pass2 == 0)
+    if (planP->nVLA == 0)
         return TCL_OK;
 
+#if defined(CFFI_USE_DYNCALL)
     /*
      * Blast it. We need a second pass since some arguments were unresolved.
      * Need to reset the dyncall arg stack since some arguments may have
@@ -1686,58 +2147,28 @@ CffiFunctionSetupArgs(CffiCall *callP,
         goto cleanup_and_error;
 
     for (i = 0; i < callP->nArgs; ++i) {
-        int dynamicCountIndex;
-        int actualCount;
-        CffiTypeAndAttrs *typeAttrsP;
-        if (i < protoP->nParams) {
-            typeAttrsP = &protoP->params[i].typeAttrs;
+        /* Need to switch modes for varargs params */
+        if (i == protoP->nParams) {
+            dcMode(callP->fnP->ipCtxP->vmP, DC_CALL_C_ELLIPSIS_VARARGS);
         }
-        else {
-#if defined(CFFI_USE_DYNCALL)
-            /* Need to switch modes for varargs params */
-            if (i == protoP->nParams) {
-                dcMode(callP->fnP->ipCtxP->vmP, DC_CALL_C_ELLIPSIS_VARARGS);
-            }
-#endif
-            typeAttrsP = &varArgTypesP[i - protoP->nParams];
+        if (i < protoP->nParams && planP->argPrepareProcs[i] == NULL) {
+            if (CffiArgPrepareVLA(callP, i, argObjs[i]) != TCL_OK)
+                goto cleanup_and_error;
         }
-
-        if (! CffiTypeIsVLA(&typeAttrsP->dataType)) {
+        else {
             /* This arg already been parsed successfully. Just load it. */
             CFFI_ASSERT(argsP[i].flags & CFFI_F_ARG_INITIALIZED);
-            CffiReloadArg(callP, &argsP[i], typeAttrsP);
-            continue;
-        }
-        CFFI_ASSERT((argsP[i].flags & CFFI_F_ARG_INITIALIZED) == 0);
-
-        if (i >= protoP->nParams) {
-            Tclh_ErrorWrongType(ip,
-                                NULL,
-                                "Dynamically sized arrays not permitted for "
-                                "varargs arguments.");
-            goto cleanup_and_error;
+            CffiReloadArg(callP, &argsP[i], argsP[i].typeAttrsP);
         }
-
-        /* Locate the parameter holding the dynamic count */
-        dynamicCountIndex = protoP->params[i].arraySizeParamIndex;
-        CFFI_ASSERT(dynamicCountIndex >= 0
-                    && dynamicCountIndex < protoP->nParams);
-        CFFI_ASSERT(argsP[dynamicCountIndex].flags & CFFI_F_ARG_INITIALIZED);
-
-        if (CffiGetCountFromValue(
-                ip,
-                protoP->params[dynamicCountIndex].typeAttrs.dataType.baseType,
-                &argsP[dynamicCountIndex].value,
-                &actualCount)
-            != TCL_OK)
-            goto cleanup_and_error;
-
-
-        argsP[i].typeAttrsP = typeAttrsP;
-        argsP[i].arraySize = (int) actualCount;
-        if (CffiArgPrepare(callP, i, argObjs[i]) != TCL_OK)
+    }
+#else
+    /* libffi does not need already loaded arguments to be reloaded */
+    for (i = 0; i < planP->nVLA; ++i) {
+        int vlaIndex = planP->vlaIndices[i];
+        if (CffiArgPrepareVLA(callP, vlaIndex, argObjs[vlaIndex]) != TCL_OK)
             goto cleanup_and_error;
     }
+#endif
 
     return TCL_OK;
 
@@ -1750,82 +2181,586 @@ CffiFunctionSetupArgs(CffiCall *callP,
         return TCL_ERROR;
 }
 
-/*
- * Implements the call to a function. The cdata parameter contains the
- * prototype information about the function to call. The objv[] parameter
- * contains the arguments to pass to the function.
+/* Function: CffiStatsTimestamp
+ * Returns a monotonic timestamp for call statistics.
+ *
+ * The errno and GetLastError values are preserved so the function may be
+ * called between a native call and the checking of its error status.
+ *
+ * Returns:
+ * Timestamp in nanoseconds from an arbitrary origin.
  */
-CffiResult
-CffiFunctionCall(ClientData cdata,
-                 Tcl_Interp *ip,
-                 int objArgIndex, /* Where in objv[] args start */
-                 int objc,
-                 Tcl_Obj *const objv[])
+static Tcl_WideUInt
+CffiStatsTimestamp(void)
 {
-    CffiFunction *fnP     = (CffiFunction *)cdata;
-    CffiProto *protoP     = fnP->protoP;
-    CffiInterpCtx *ipCtxP = fnP->ipCtxP;
-    Tcl_Obj *resultObj             = NULL;
-    Tcl_Obj **argObjs              = NULL;
-    Tcl_Obj *const *varArgObjs     = NULL;
-    CffiTypeAndAttrs *varArgTypesP = NULL;
-    int nArgObjs;
-    int nVarArgs;
-    int nActualArgs;
-    int varArgsInited = 0;
-    int discardResult;
-    int argResultIndex; /* If >=0, index of output argument as function result */
-    int i;
-    void *pointer;
-    CffiCall callCtx;
-    Tclh_LifoMark mark;
-    CffiResult ret = TCL_OK;
-    CffiResult fnCheckRet = TCL_OK; /* Whether function return check passed */
-    Tcl_WideInt sysError;  /* Error retrieved from system */
-
-    CFFI_ASSERT(ip == ipCtxP->interp);
-
-    /* nArgObjs is supplied arguments. Remaining have to come from defaults */
-    CFFI_ASSERT(objc >= objArgIndex);
-    nArgObjs = objc - objArgIndex;
+    int savedErrno = errno;
+    Tcl_WideUInt now;
+#ifdef _WIN32
+    static LARGE_INTEGER frequency; /* Constant so races are benign */
+    LARGE_INTEGER counter;
+    DWORD savedWinError = GetLastError();
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    /* Split to avoid overflow of counter * 1e9 */
+    now = (Tcl_WideUInt)(counter.QuadPart / frequency.QuadPart) * 1000000000
+        + (Tcl_WideUInt)(counter.QuadPart % frequency.QuadPart) * 1000000000
+              / frequency.QuadPart;
+    SetLastError(savedWinError);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (Tcl_WideUInt)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    errno = savedErrno;
+    return now;
+}
+
+/* Function: CffiFunctionStats
+ * Returns the statistics entry for a function, creating it if necessary.
+ *
+ * Parameters:
+ * fnP - function. Its interpreter context must have statistics enabled.
+ *
+ * Functions are identified by their command name or, for calls through
+ * function pointers, by their address.
+ *
+ * Returns:
+ * Pointer to the statistics entry.
+ */
+static CffiCallStats *
+CffiFunctionStats(CffiFunction *fnP)
+{
+    CffiInterpCtx *ipCtxP = fnP->ipCtxP;
+    Tcl_HashEntry *heP;
+    Tcl_Obj *nameObj;
+    int isNew;
+
+    if (fnP->statsP)
+        return fnP->statsP;
+
+    if (fnP->cmdNameObj)
+        nameObj = fnP->cmdNameObj;
+    else
+        nameObj = Tcl_ObjPrintf("0x%" TCL_LL_MODIFIER "x",
+                                (Tcl_WideUInt)(uintptr_t)fnP->fnAddr);
+    Tcl_IncrRefCount(nameObj);
+    heP = Tcl_CreateHashEntry(
+        &ipCtxP->callStats, Tcl_GetString(nameObj), &isNew);
+    Tcl_DecrRefCount(nameObj);
+    if (isNew) {
+        CffiCallStats *statsP = ckalloc(sizeof(*statsP));
+        memset(statsP, 0, sizeof(*statsP));
+        Tcl_SetHashValue(heP, statsP);
+    }
+    fnP->statsP = Tcl_GetHashValue(heP);
+    return fnP->statsP;
+}
+
+/* Function: CffiStatsRecord
+ * Adds a completed call to a function's statistics.
+ *
+ * Parameters:
+ * statsP - statistics entry
+ * failed - non-0 if the call raised an error
+ * marshalTime - time spent converting arguments
+ * nativeTime - time spent in the native function
+ * unmarshalTime - time spent converting results
+ */
+static void
+CffiStatsRecord(CffiCallStats *statsP,
+                int failed,
+                Tcl_WideUInt marshalTime,
+                Tcl_WideUInt nativeTime,
+                Tcl_WideUInt unmarshalTime)
+{
+    Tcl_WideUInt elapsed = marshalTime + nativeTime + unmarshalTime;
+    statsP->nCalls += 1;
+    if (failed)
+        statsP->nErrors += 1;
+    statsP->totalTime += elapsed;
+    if (elapsed > statsP->maxTime)
+        statsP->maxTime = elapsed;
+    statsP->marshalTime += marshalTime;
+    statsP->nativeTime += nativeTime;
+    statsP->unmarshalTime += unmarshalTime;
+}
+
+/* Function: CffiStatsRecordCall
+ * Adds a completed synchronous call to a function's statistics.
+ *
+ * Parameters:
+ * statsP - statistics entry
+ * failed - non-0 if the call raised an error
+ * startTime - timestamp at the start of the call
+ * nativeStartTime - timestamp just before the native function was invoked
+ *   or 0 if the call failed before that point
+ * nativeEndTime - timestamp just after the native function returned or
+ *   0 if not recorded
+ */
+static void
+CffiStatsRecordCall(CffiCallStats *statsP,
+                    int failed,
+                    Tcl_WideUInt startTime,
+                    Tcl_WideUInt nativeStartTime,
+                    Tcl_WideUInt nativeEndTime)
+{
+    Tcl_WideUInt endTime = CffiStatsTimestamp();
+
+    if (nativeStartTime == 0) {
+        /* Failed while converting arguments */
+        CffiStatsRecord(statsP, failed, endTime - startTime, 0, 0);
+        return;
+    }
+    if (nativeEndTime == 0)
+        nativeEndTime = endTime;
+    CffiStatsRecord(statsP,
+                    failed,
+                    nativeStartTime - startTime,
+                    nativeEndTime - nativeStartTime,
+                    endTime - nativeEndTime);
+}
+
+/* Function: CffiCallStatsInit
+ * Initializes the call statistics table for an interpreter context.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * Statistics collection is initially disabled.
+ */
+void
+CffiCallStatsInit(CffiInterpCtx *ipCtxP)
+{
+    Tcl_InitHashTable(&ipCtxP->callStats, TCL_STRING_KEYS);
+    ipCtxP->callStatsEnabled = 0;
+}
+
+/* Function: CffiCallStatsCleanup
+ * Releases the call statistics table for an interpreter context.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * Must only be called when the interpreter context is being deleted since
+ * functions may hold pointers to the entries.
+ */
+void
+CffiCallStatsCleanup(CffiInterpCtx *ipCtxP)
+{
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+
+    for (heP = Tcl_FirstHashEntry(&ipCtxP->callStats, &hSearch); heP;
+         heP = Tcl_NextHashEntry(&hSearch)) {
+        ckfree(Tcl_GetHashValue(heP));
+    }
+    Tcl_DeleteHashTable(&ipCtxP->callStats);
+}
+
+/* Function: CffiStatsObjCmd
+ * Implements the *stats* script level command.
+ *
+ * Parameters:
+ * cdata - the interpreter context
+ * ip - interpreter
+ * objc - number of elements in *objv*
+ * objv - command arguments
+ *
+ * The syntax is
+ *   stats enable ?BOOLEAN?
+ *   stats get ?PATTERN?
+ *   stats reset
+ *
+ * Times are reported in nanoseconds. Reset zeroes entries in place
+ * instead of deleting them because functions cache pointers to them.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on error with message in the interpreter.
+ */
+CffiResult
+CffiStatsObjCmd(ClientData cdata,
+                Tcl_Interp *ip,
+                int objc,
+                Tcl_Obj *const objv[])
+{
+    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
+    enum cmds { ENABLE, GET, RESET };
+    int cmdIndex;
+    static Tclh_SubCommand subCommands[] = {
+        {"enable", 0, 1, "?BOOLEAN?", NULL},
+        {"get", 0, 1, "?PATTERN?", NULL},
+        {"reset", 0, 0, "", NULL},
+        {NULL}};
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+    Tcl_Obj *resultObj;
+
+    CHECK(Tclh_SubCommandLookup(ip, subCommands, objc, objv, &cmdIndex));
+    switch (cmdIndex) {
+    case ENABLE:
+        if (objc > 2) {
+            int enable;
+            CHECK(Tcl_GetBooleanFromObj(ip, objv[2], &enable));
+            ipCtxP->callStatsEnabled = enable;
+        }
+        Tcl_SetObjResult(ip, Tcl_NewBooleanObj(ipCtxP->callStatsEnabled));
+        break;
+
+    case GET:
+        resultObj = Tcl_NewDictObj();
+        for (heP = Tcl_FirstHashEntry(&ipCtxP->callStats, &hSearch); heP;
+             heP = Tcl_NextHashEntry(&hSearch)) {
+            const char *name = Tcl_GetHashKey(&ipCtxP->callStats, heP);
+            CffiCallStats *statsP = Tcl_GetHashValue(heP);
+            Tcl_Obj *objs[14];
+            if (statsP->nCalls == 0)
+                continue;
+            if (objc > 2 && !Tcl_StringMatch(name, Tcl_GetString(objv[2])))
+                continue;
+            objs[0]  = Tcl_NewStringObj("calls", 5);
+            objs[1]  = Tcl_NewWideIntObj((Tcl_WideInt)statsP->nCalls);
+            objs[2]  = Tcl_NewStringObj("errors", 6);
+            objs[3]  = Tcl_NewWideIntObj((Tcl_WideInt)statsP->nErrors);
+            objs[4]  = Tcl_NewStringObj("total", 5);
+            objs[5]  = Tcl_NewWideIntObj((Tcl_WideInt)statsP->totalTime);
+            objs[6]  = Tcl_NewStringObj("max", 3);
+            objs[7]  = Tcl_NewWideIntObj((Tcl_WideInt)statsP->maxTime);
+            objs[8]  = Tcl_NewStringObj("marshal", 7);
+            objs[9]  = Tcl_NewWideIntObj((Tcl_WideInt)statsP->marshalTime);
+            objs[10] = Tcl_NewStringObj("native", 6);
+            objs[11] = Tcl_NewWideIntObj((Tcl_WideInt)statsP->nativeTime);
+            objs[12] = Tcl_NewStringObj("unmarshal", 9);
+            objs[13] = Tcl_NewWideIntObj((Tcl_WideInt)statsP->unmarshalTime);
+            Tcl_DictObjPut(NULL,
+                           resultObj,
+                           Tcl_NewStringObj(name, -1),
+                           Tcl_NewListObj(14, objs));
+        }
+        Tcl_SetObjResult(ip, resultObj);
+        break;
+
+    case RESET:
+        for (heP = Tcl_FirstHashEntry(&ipCtxP->callStats, &hSearch); heP;
+             heP = Tcl_NextHashEntry(&hSearch)) {
+            CffiCallStats *statsP = Tcl_GetHashValue(heP);
+            memset(statsP, 0, sizeof(*statsP));
+        }
+        break;
+    }
+    return TCL_OK;
+}
+
+/*
+ * SAVEERROR saves errno and GetLastError values if so annotated. It expects
+ * protoP and ipCtxP to be defined in the calling context. It also records
+ * the time the native call returned in nativeEndTime if statsP, which must
+ * also be defined, is not NULL.
+ */
+#ifdef _WIN32
+#define SAVEERROR()                                                       \
+    do {                                                                  \
+        if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_SAVEERROR) { \
+            ipCtxP->savedWinError = GetLastError();                       \
+            ipCtxP->savedErrno    = errno;                                \
+        }                                                                 \
+        if (statsP)                                                       \
+            nativeEndTime = CffiStatsTimestamp();                         \
+    } while (0)
+#else
+#define SAVEERROR()                                                       \
+    do {                                                                  \
+        if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_SAVEERROR) { \
+            ipCtxP->savedErrno = errno;                                   \
+        }                                                                 \
+        if (statsP)                                                       \
+            nativeEndTime = CffiStatsTimestamp();                         \
+    } while (0)
+#endif
+
+/* Function: CffiFunctionCallFast
+ * Calls a function whose prototype is eligible for the fast call path.
+ *
+ * Parameters:
+ * fnP - function to call. Its prototype plan must have the
+ *   CFFI_F_PLAN_FASTCALL flag set.
+ * objArgIndex - index of first argument in objv[]
+ * objc - number of elements in objv[]
+ * objv - arguments. Caller must have verified the number of arguments
+ *   is within the limits of the prototype.
+ *
+ * The fast path applies to functions whose parameters are all scalar input
+ * values passed by value and whose return value is void or numeric with no
+ * error checking annotations. Argument storage is placed on the C stack
+ * so there is no need for memlifo allocations, two-pass argument setup,
+ * output parameter processing or pointer disposal.
+ *
+ * Returns:
+ * TCL_OK on success with the function result in the interpreter,
+ * TCL_ERROR on failure with error message in the interpreter.
+ */
+static CffiResult
+CffiFunctionCallFast(CffiFunction *fnP,
+                     int objArgIndex,
+                     int objc,
+                     Tcl_Obj *const objv[])
+{
+    CffiProto *protoP         = fnP->protoP;
+    CffiInterpCtx *ipCtxP     = fnP->ipCtxP;
+    const CffiCallPlan *planP = protoP->planP;
+    Tcl_Interp *ip            = ipCtxP->interp;
+    Tcl_Obj *resultObj        = NULL;
+    CffiArgument args[CFFI_FASTCALL_MAX_PARAMS];
+#ifdef CFFI_USE_LIBFFI
+    void *argValues[CFFI_FASTCALL_MAX_PARAMS];
+#endif
+    CffiCall callCtx;
+    CffiCallStats *statsP = NULL;
+    Tcl_WideUInt startTime = 0, nativeStartTime = 0, nativeEndTime = 0;
+    CffiResult ret;
+    int discardResult;
+    int i, j;
+
+    CFFI_ASSERT(planP->flags & CFFI_F_PLAN_FASTCALL);
+    CFFI_ASSERT(protoP->nParams <= CFFI_FASTCALL_MAX_PARAMS);
+    CFFI_ASSERT((objc - objArgIndex) >= planP->minArgs
+                && (objc - objArgIndex) <= planP->maxArgs);
+
+    callCtx.fnP   = fnP;
+    callCtx.nArgs = protoP->nParams;
+    callCtx.argsP = args;
+#ifdef CFFI_USE_LIBFFI
+    callCtx.argValuesPP = argValues;
+    callCtx.retValueP   = NULL;
+    /* protoP->cifP is lazy-initialized */
+    CHECK(CffiLibffiInitProtoCif(ipCtxP, protoP, 0, NULL, NULL));
+#endif
+    CHECK(CffiResetCall(ip, &callCtx));
+    CHECK(CffiReturnPrepare(&callCtx));
+
+    CffiFunctionRef(fnP); /* So it cannot get deallocated in callbacks */
+
+    if (ipCtxP->callStatsEnabled) {
+        statsP    = CffiFunctionStats(fnP);
+        startTime = CffiStatsTimestamp();
+    }
+
+    for (i = 0, j = objArgIndex; i < protoP->nParams; ++i) {
+        Tcl_Obj *valueObj;
+        if (j < objc)
+            valueObj = objv[j++];
+        else {
+            /* Argument count check guarantees a default exists */
+            valueObj = protoP->params[i].typeAttrs.parseModeSpecificObj;
+            CFFI_ASSERT(valueObj);
+        }
+        args[i].flags      = 0;
+        args[i].typeAttrsP = &protoP->params[i].typeAttrs;
+        args[i].arraySize  = -1;
+        if (planP->argPrepareProcs[i](&callCtx, i, valueObj) != TCL_OK) {
+            if (statsP)
+                CffiStatsRecordCall(statsP, 1, startTime, 0, 0);
+            CffiFunctionUnref(fnP);
+            return TCL_ERROR;
+        }
+    }
+
+    discardResult = (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_DISCARD);
+
+    if (statsP)
+        nativeStartTime = CffiStatsTimestamp();
+
+    /* IMPORTANT: SAVEERROR must immediately follow the call */
+#define FASTCALLFN_(objfn_, callfn_, type_)       \
+    do {                                          \
+        type_ cretval = callfn_(&callCtx);        \
+        SAVEERROR();                              \
+        if (!discardResult)                       \
+            resultObj = objfn_(cretval);          \
+    } while (0)
+
+    ret = TCL_OK;
+    switch (protoP->returnType.typeAttrs.dataType.baseType) {
+    case CFFI_K_TYPE_VOID:
+        CffiCallVoidFunc(&callCtx);
+        SAVEERROR();
+        break;
+    case CFFI_K_TYPE_SCHAR:
+        FASTCALLFN_(Tcl_NewIntObj, CffiCallSCharFunc, signed char);
+        break;
+    case CFFI_K_TYPE_UCHAR:
+        FASTCALLFN_(Tcl_NewIntObj, CffiCallUCharFunc, unsigned char);
+        break;
+    case CFFI_K_TYPE_SHORT:
+        FASTCALLFN_(Tcl_NewIntObj, CffiCallShortFunc, short);
+        break;
+    case CFFI_K_TYPE_USHORT:
+        FASTCALLFN_(Tcl_NewIntObj, CffiCallUShortFunc, unsigned short);
+        break;
+    case CFFI_K_TYPE_INT:
+        FASTCALLFN_(Tcl_NewIntObj, CffiCallIntFunc, int);
+        break;
+    case CFFI_K_TYPE_UINT:
+        FASTCALLFN_(Tcl_NewWideIntObj, CffiCallUIntFunc, unsigned int);
+        break;
+    case CFFI_K_TYPE_LONG:
+        FASTCALLFN_(Tcl_NewLongObj, CffiCallLongFunc, long);
+        break;
+    case CFFI_K_TYPE_ULONG:
+        FASTCALLFN_(Tclh_ObjFromULong, CffiCallULongFunc, unsigned long);
+        break;
+    case CFFI_K_TYPE_LONGLONG:
+        FASTCALLFN_(Tcl_NewWideIntObj, CffiCallLongLongFunc, long long);
+        break;
+    case CFFI_K_TYPE_ULONGLONG:
+        FASTCALLFN_(
+            Tclh_ObjFromULongLong, CffiCallULongLongFunc, unsigned long long);
+        break;
+    case CFFI_K_TYPE_FLOAT:
+        FASTCALLFN_(Tcl_NewDoubleObj, CffiCallFloatFunc, float);
+        break;
+    case CFFI_K_TYPE_DOUBLE:
+        FASTCALLFN_(Tcl_NewDoubleObj, CffiCallDoubleFunc, double);
+        break;
+    default:
+        /* CffiCallPlanInit should not have permitted the fast path */
+        ret = CffiErrorType(ip,
+                            protoP->returnType.typeAttrs.dataType.baseType,
+                            __FILE__,
+                            __LINE__);
+        break;
+    }
+#undef FASTCALLFN_
+
+    if (resultObj)
+        Tcl_SetObjResult(ip, resultObj);
+    if (statsP) {
+        CffiStatsRecordCall(
+            statsP, ret != TCL_OK, startTime, nativeStartTime, nativeEndTime);
+    }
+    CffiFunctionUnref(fnP);
+    return ret;
+}
+
+/* Function: CffiFunctionErrorNumArgs
+ * Stores a syntax error message for a function call in the interpreter.
+ *
+ * Parameters:
+ * protoP - prototype of the function
+ * ip - interpreter
+ * objArgIndex - index of first argument in objv[]
+ * objv - command words. Those before *objArgIndex* are included in the
+ *   syntax message as the command.
+ *
+ * Returns:
+ * Always *TCL_ERROR*.
+ */
+static CffiResult
+CffiFunctionErrorNumArgs(CffiProto *protoP,
+                         Tcl_Interp *ip,
+                         int objArgIndex,
+                         Tcl_Obj *const objv[])
+{
+    Tcl_Obj *syntaxObj;
+    int i;
+
+    syntaxObj = Tcl_NewListObj(protoP->nParams + 2, NULL);
+    Tcl_ListObjAppendElement(NULL, syntaxObj, Tcl_NewStringObj("Syntax:", -1));
+    for (i = 0; i < objArgIndex; ++i)
+        Tcl_ListObjAppendElement(NULL, syntaxObj, objv[i]);
+    for (i = 0; i < protoP->nParams; ++i) {
+        /* RETVAL params are "invisible" from caller's perspective */
+        if (! (protoP->params[i].typeAttrs.flags & CFFI_F_ATTR_RETVAL))
+            Tcl_ListObjAppendElement(
+                NULL, syntaxObj, protoP->params[i].nameObj);
+    }
+    if (protoP->flags & CFFI_F_PROTO_VARARGS) {
+        Tcl_ListObjAppendElement(NULL, syntaxObj, Tcl_NewStringObj("...", 3));
+    }
+    Tclh_ErrorGeneric(ip, "NUMARGS", Tcl_GetString(syntaxObj));
+    Tcl_DecrRefCount(syntaxObj); /* Never had a reference so free it */
+    return TCL_ERROR;
+}
+
+/*
+ * Implements the call to a function. The cdata parameter contains the
+ * prototype information about the function to call. The objv[] parameter
+ * contains the arguments to pass to the function.
+ */
+CffiResult
+CffiFunctionCall(ClientData cdata,
+                 Tcl_Interp *ip,
+                 int objArgIndex, /* Where in objv[] args start */
+                 int objc,
+                 Tcl_Obj *const objv[])
+{
+    CffiFunction *fnP     = (CffiFunction *)cdata;
+    CffiProto *protoP     = fnP->protoP;
+    CffiInterpCtx *ipCtxP = fnP->ipCtxP;
+    const CffiCallPlan *planP;
+    Tcl_Obj *resultObj             = NULL;
+    Tcl_Obj **argObjs              = NULL;
+    Tcl_Obj *const *varArgObjs     = NULL;
+    CffiTypeAndAttrs *varArgTypesP = NULL;
+    int nArgObjs;
+    int nVarArgs;
+    int nActualArgs;
+    int varArgsInited = 0;
+    int discardResult;
+    int argResultIndex; /* If >=0, index of output argument as function result */
+    int i;
+    void *pointer;
+    CffiCall callCtx;
+    Tclh_LifoMark mark;
+    CffiResult ret = TCL_OK;
+    CffiResult fnCheckRet = TCL_OK; /* Whether function return check passed */
+    Tcl_WideInt sysError;  /* Error retrieved from system */
+    CffiCallStats *statsP = NULL;
+    Tcl_WideUInt startTime = 0, nativeStartTime = 0, nativeEndTime = 0;
+
+    CFFI_ASSERT(ip == ipCtxP->interp);
+
+    /* nArgObjs is supplied arguments. Remaining have to come from defaults */
+    CFFI_ASSERT(objc >= objArgIndex);
+    nArgObjs = objc - objArgIndex;
 
     /* TBD - check memory executable permissions */
     if ((uintptr_t) fnP->fnAddr < 0xffff)
         return Tclh_ErrorInvalidValue(ip, NULL, "Function pointer not in executable page.");
 
+    /* Functions with simple scalar signatures bypass the generic path */
+    planP = protoP->planP;
+    if ((planP->flags & CFFI_F_PLAN_FASTCALL) && nArgObjs >= planP->minArgs
+        && nArgObjs <= planP->maxArgs) {
+        return CffiFunctionCallFast(fnP, objArgIndex, objc, objv);
+    }
+
     /* IMPORTANT - mark has to be popped even on errors before returning */
     /* Ditto for deref-ing fnP */
     mark = Tclh_LifoPushMark(&ipCtxP->memlifo);
     CffiFunctionRef(fnP); /* So it cannot get deallocated in callbacks */
 
+    if (ipCtxP->callStatsEnabled) {
+        statsP    = CffiFunctionStats(fnP);
+        startTime = CffiStatsTimestamp();
+    }
+
     discardResult = (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_DISCARD);
 
-    /* Check number of arguments passed */
+    /*
+     * Check number of arguments passed. Varargs functions do not permit
+     * defaults and may have more arguments than the prototype. Normal
+     * functions may have fewer arguments if defaults are present but never
+     * more than formal parameters. The limits are precomputed in the plan.
+     */
+    if (nArgObjs < planP->minArgs)
+        goto numargs_error;
     if (protoP->flags & CFFI_F_PROTO_VARARGS) {
-        /*
-         * Varargs functions differ from fixed arg functions in that
-         * - they do not permit default values for parameters so at least
-         *   that many arguments must be present
-         * - number of arguments may be more than number in prototype
-         */
-        int minNumArgs = protoP->nParams;
-        if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_RETVAL)
-            minNumArgs -= 1; /* One parameter is return val */
-        if (nArgObjs < minNumArgs)
-            goto numargs_error; /* More args than params */
-        nVarArgs   = nArgObjs - minNumArgs;
-        varArgObjs = nVarArgs ? (minNumArgs + objArgIndex + objv) : NULL;
+        nVarArgs   = nArgObjs - planP->maxArgs;
+        varArgObjs = nVarArgs ? (planP->maxArgs + objArgIndex + objv) : NULL;
     }
     else {
-        /*
-         * For normal functions, there may be fewer arguments as defaults
-         * may be present (if not, error is caught when setting up args)
-         * There should never me more args than formal parameters.
-         */
-        int maxNumArgs = protoP->nParams;
-        if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_RETVAL)
-            maxNumArgs -= 1; /* One param is the return val */
-        if (nArgObjs > maxNumArgs)
+        if (nArgObjs > planP->maxArgs)
             goto numargs_error; /* More args than params */
         nVarArgs   = 0;
         varArgObjs = NULL;
@@ -1890,7 +2825,8 @@ CffiFunctionCall(ClientData cdata,
      * and varargs.
      */
     nActualArgs = nVarArgs + protoP->nParams;
-    argResultIndex = -1;/* Presume function result returned as is */
+    /* If >= 0, index of an output parameter returned as function result */
+    argResultIndex = planP->retvalIndex;
     if (protoP->nParams) {
         int j;
 
@@ -1902,34 +2838,29 @@ CffiFunctionCall(ClientData cdata,
         argObjs = (Tcl_Obj **)Tclh_LifoAlloc(
             &ipCtxP->memlifo, nActualArgs * sizeof(Tcl_Obj *));
 
-        /* First do the fixed arguments */
-        for (i = 0, j = objArgIndex; i < protoP->nParams; ++i, ++j) {
-            if (protoP->params[i].typeAttrs.flags & CFFI_F_ATTR_RETVAL) {
+        /*
+         * First do the fixed arguments. The argument count check above
+         * guarantees that missing arguments have defaults.
+         */
+        for (i = 0, j = objArgIndex; i < protoP->nParams; ++i) {
+            if (i == argResultIndex) {
                 /* This is a parameter to use as return value. No argument
                    is expected from the caller */
-                CFFI_ASSERT(argResultIndex < 0); /* Checked at definition */
-                argObjs[i]     = NULL;
-                argResultIndex = i; /* Index of param to be used for func result */
-                --j; /* Negate loop ++j so same argument used for next param */
+                argObjs[i] = NULL;
+            }
+            else if (j < objc) {
+                argObjs[i] = objv[j++];
             }
             else {
-                if (j < objc) {
-                    argObjs[i] = objv[j];
-                }
-                else {
-                    /*
-                     * No argument, must have a default - parseModeSpecificObj
-                     * is used for both defaults and onerror.
-                     */
-                    if ((protoP->params[i].typeAttrs.parseModeSpecificObj
-                         == NULL)
-                        || (protoP->params[i].typeAttrs.flags
-                            & CFFI_F_ATTR_ONERROR))
-                        goto numargs_error;
-
-                    argObjs[i] =
-                        protoP->params[i].typeAttrs.parseModeSpecificObj;
-                }
+                /*
+                 * No argument, use the default - parseModeSpecificObj
+                 * is used for both defaults and onerror.
+                 */
+                CFFI_ASSERT(protoP->params[i].typeAttrs.parseModeSpecificObj);
+                CFFI_ASSERT((protoP->params[i].typeAttrs.flags
+                             & CFFI_F_ATTR_ONERROR)
+                            == 0);
+                argObjs[i] = protoP->params[i].typeAttrs.parseModeSpecificObj;
             }
         }
         /*
@@ -1967,23 +2898,6 @@ CffiFunctionCall(ClientData cdata,
         CFFI_ASSERT(callCtx.nArgs == nActualArgs);
     }
 
-#ifdef _WIN32
-#define SAVEERROR()                                                       \
-    do {                                                                  \
-        if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_SAVEERROR) { \
-            ipCtxP->savedWinError = GetLastError();                       \
-            ipCtxP->savedErrno    = errno;                                \
-        }                                                                 \
-    } while (0)
-#else
-#define SAVEERROR()                                                       \
-    do {                                                                  \
-        if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_SAVEERROR) { \
-            ipCtxP->savedErrno = errno;                                   \
-        }                                                                 \
-    } while (0)
-#endif
-
     /*
      * A note on pointer disposal - pointers must be disposed of AFTER the
      * function is invoked (since success/fail control disposal) but BEFORE
@@ -2019,8 +2933,7 @@ CffiFunctionCall(ClientData cdata,
         if (protoP->returnType.typeAttrs.flags & CFFI_F_ATTR_REQUIREMENT_MASK) \
             fnCheckRet = CffiCheckNumeric(                                     \
                 ip, &protoP->returnType.typeAttrs, &cretval, &sysError);       \
-        CffiPointerArgsDispose(                                                \
-            ipCtxP, callCtx.nArgs, callCtx.argsP, fnCheckRet);                 \
+        CffiPointerArgsDispose(ipCtxP, &callCtx, fnCheckRet);                  \
         if (fnCheckRet == TCL_OK) {                                            \
             /* Wrap function return value unless an output argument is */      \
             /* to be returned as the result or result to be discarded */       \
@@ -2034,13 +2947,18 @@ CffiFunctionCall(ClientData cdata,
         }                                                                      \
     } while (0)
 
+    /* Views of memory the callee may free must be copied while valid */
+    CffiPointerArgsSnapshotViews(ipCtxP, &callCtx);
+
+    if (statsP)
+        nativeStartTime = CffiStatsTimestamp();
+
     CFFI_ASSERT(ret == TCL_OK);
     switch (protoP->returnType.typeAttrs.dataType.baseType) {
     case CFFI_K_TYPE_VOID:
         CffiCallVoidFunc(&callCtx);
         SAVEERROR();
-        CffiPointerArgsDispose(
-            ipCtxP, callCtx.nArgs, callCtx.argsP, fnCheckRet);
+        CffiPointerArgsDispose(ipCtxP, &callCtx, fnCheckRet);
         if (!discardResult)
             resultObj = Tcl_NewObj();
         break;
@@ -2101,7 +3019,7 @@ CffiFunctionCall(ClientData cdata,
         /* Do check IMMEDIATELY so as to not lose GetLastError */
         fnCheckRet = CffiCheckPointer(
             ip, &protoP->returnType.typeAttrs, pointer, &sysError);
-        CffiPointerArgsDispose(ipCtxP, callCtx.nArgs, callCtx.argsP, fnCheckRet);         \
+        CffiPointerArgsDispose(ipCtxP, &callCtx, fnCheckRet);
         switch (protoP->returnType.typeAttrs.dataType.baseType) {
         case CFFI_K_TYPE_POINTER:
             if (!discardResult)
@@ -2152,7 +3070,7 @@ CffiFunctionCall(ClientData cdata,
             SAVEERROR();
             fnCheckRet = CffiCheckPointer(
                 ip, &protoP->returnType.typeAttrs, pointer, &sysError);
-            CffiPointerArgsDispose(ipCtxP, callCtx.nArgs, callCtx.argsP, fnCheckRet);
+            CffiPointerArgsDispose(ipCtxP, &callCtx, fnCheckRet);
             if (pointer == NULL) {
                 CffiStruct *structP =
                     protoP->returnType.typeAttrs.dataType.u.structP;
@@ -2199,6 +3117,10 @@ CffiFunctionCall(ClientData cdata,
                 CffiStructToObj(ipCtxP,
                                 protoP->returnType.typeAttrs.dataType.u.structP,
                                 pointer,
+                                (protoP->returnType.typeAttrs.flags
+                                 & CFFI_F_ATTR_LIST)
+                                    ? CFFI_F_AS_LIST
+                                    : 0,
                                 &resultObj);
         }
         break;
@@ -2284,21 +3206,16 @@ CffiFunctionCall(ClientData cdata,
          * Note only fixed params considered, not varargs. For now that's
          * fine since varargs are currently never INOUT or OUT parameters.
          */
-        for (i = 0; i < protoP->nParams; ++i) {
-            /* Skip the index, if any, that is to be returned as function result */
-            if (i != argResultIndex) {
-                CffiAttrFlags flags = protoP->params[i].typeAttrs.flags;
-                if ((flags & (CFFI_F_ATTR_INOUT | CFFI_F_ATTR_OUT))) {
-                    if ((fnCheckRet == TCL_OK
-                         && !(flags & CFFI_F_ATTR_STOREONERROR))
-                        || (fnCheckRet != TCL_OK
-                            && (flags & CFFI_F_ATTR_STOREONERROR))
-                        || (flags & CFFI_F_ATTR_STOREALWAYS)) {
-                        /* Parameter needs to be stored */
-                        if (CffiArgPostProcess(&callCtx, i, NULL) != TCL_OK)
-                            ret = TCL_ERROR;/* Only update ret on error! */
-                    }
-                }
+        for (i = 0; i < planP->nOutput; ++i) {
+            /* Note the retval parameter, if any, is not in the output list */
+            int outIndex = planP->outputIndices[i];
+            CffiAttrFlags flags = protoP->params[outIndex].typeAttrs.flags;
+            if ((fnCheckRet == TCL_OK && !(flags & CFFI_F_ATTR_STOREONERROR))
+                || (fnCheckRet != TCL_OK && (flags & CFFI_F_ATTR_STOREONERROR))
+                || (flags & CFFI_F_ATTR_STOREALWAYS)) {
+                /* Parameter needs to be stored */
+                if (CffiArgPostProcess(&callCtx, outIndex, NULL) != TCL_OK)
+                    ret = TCL_ERROR;/* Only update ret on error! */
             }
         }
     }
@@ -2342,50 +3259,719 @@ CffiFunctionCall(ClientData cdata,
         }
     }
     if (resultObj)
-        Tclh_ObjClearPtr(&resultObj);
+        Tclh_ObjClearPtr(&resultObj);
+
+    CffiReturnCleanup(&callCtx);
+    for (i = 0; i < callCtx.nArgs; ++i)
+        CffiArgCleanup(&callCtx, i);
+
+pop_and_go:
+    /* Clean up the temporary type descriptors for varargs */
+    if (varArgsInited && varArgTypesP) {
+        for (i = 0; i < nVarArgs; ++i) {
+            CffiTypeAndAttrsCleanup(&varArgTypesP[i]);
+        }
+    }
+
+    if (statsP) {
+        CffiStatsRecordCall(
+            statsP, ret != TCL_OK, startTime, nativeStartTime, nativeEndTime);
+    }
+    CffiFunctionUnref(fnP);
+    Tclh_LifoPopMark(mark);
+    return ret;
+
+numargs_error:
+    /* Do NOT jump here if args are still to be cleaned up */
+    CffiFunctionErrorNumArgs(protoP, ip, objArgIndex, objv);
+    /* Fall thru below */
+pop_and_error:
+    /* Do NOT jump here if args are still to be cleaned up */
+    /* Jump for error return after popping memlifo with error in interp */
+    if (resultObj)
+        Tcl_DecrRefCount(resultObj);
+    ret = TCL_ERROR;
+    goto pop_and_go;
+
+}
+
+#ifdef CFFI_USE_LIBFFI
+/*
+ * Asynchronous calls.
+ *
+ * Arguments are converted in the interpreter thread into storage owned by
+ * a CffiAsyncCall structure. The native call is then made from a thread in
+ * a process-wide worker pool and the CffiAsyncCall, which doubles as a Tcl
+ * event, is queued back to the interpreter thread. There output parameters
+ * are stored, the return value wrapped and the completion callback invoked.
+ *
+ * Only the worker pool queue and the state field of CffiAsyncCall are
+ * shared between threads and are protected by cffiAsyncMutex. Everything
+ * else is only touched by the interpreter thread before the call is queued
+ * and after the state changes to CFFI_ASYNC_DONE.
+ */
+#ifndef CFFI_ASYNC_MAX_WORKERS
+# define CFFI_ASYNC_MAX_WORKERS 4
+#endif
+
+typedef struct CffiAsyncCall {
+    Tcl_Event header;                   /* Must be first */
+    struct CffiAsyncCall *nextP;        /* Next in worker queue */
+    struct CffiAsyncCall *nextPendingP; /* Next outstanding call for the
+                                           interpreter */
+    CffiInterpCtx *ipCtxP; /* NULL if the interpreter was deleted before
+                              the call completed */
+    CffiFunction *fnP;     /* Function being called. Ref'ed */
+    Tcl_Obj *argListObj;   /* Argument values and output variable names.
+                              Ref'ed. */
+    Tcl_Obj *cmdObj;       /* Completion callback. May be NULL */
+    Tcl_ThreadId ownerThread; /* Thread of the interpreter */
+    int state;
+#define CFFI_ASYNC_QUEUED  0
+#define CFFI_ASYNC_RUNNING 1
+#define CFFI_ASYNC_DONE    2
+    int savedErrno;
+#ifdef _WIN32
+    DWORD savedWinError;
+#endif
+    CffiCall callCtx;
+    CffiArgument args[1]; /* Actual size is number of parameters. Followed
+                             by the libffi argument pointer array */
+    /* !!!DO NOT ADD FIELDS HERE AT END OF STRUCT!!! */
+} CffiAsyncCall;
+
+TCL_DECLARE_MUTEX(cffiAsyncMutex)
+static Tcl_Condition cffiAsyncWorkCond; /* Signalled when calls are queued */
+static Tcl_Condition cffiAsyncDoneCond; /* Signalled when a call completes */
+static CffiAsyncCall *cffiAsyncQueueHeadP;
+static CffiAsyncCall *cffiAsyncQueueTailP;
+static Tcl_ThreadId cffiAsyncWorkers[CFFI_ASYNC_MAX_WORKERS];
+static int cffiAsyncNumWorkers;
+static int cffiAsyncNumIdle;
+static int cffiAsyncShutdown;
+
+/* Function: CffiAsyncWorker
+ * Thread procedure for the asynchronous call worker pool.
+ *
+ * Parameters:
+ * clientData - unused
+ *
+ * Each worker picks calls off the shared queue, invokes the native
+ * function and queues the call back to the owning thread as an event.
+ */
+static Tcl_ThreadCreateType
+CffiAsyncWorker(ClientData clientData)
+{
+    CffiAsyncCall *asyncP;
+
+    Tcl_MutexLock(&cffiAsyncMutex);
+    while (1) {
+        while (cffiAsyncQueueHeadP == NULL && !cffiAsyncShutdown) {
+            cffiAsyncNumIdle += 1;
+            Tcl_ConditionWait(&cffiAsyncWorkCond, &cffiAsyncMutex, NULL);
+            cffiAsyncNumIdle -= 1;
+        }
+        if (cffiAsyncShutdown)
+            break;
+        asyncP              = cffiAsyncQueueHeadP;
+        cffiAsyncQueueHeadP = asyncP->nextP;
+        if (cffiAsyncQueueHeadP == NULL)
+            cffiAsyncQueueTailP = NULL;
+        asyncP->state = CFFI_ASYNC_RUNNING;
+        Tcl_MutexUnlock(&cffiAsyncMutex);
+
+        /* IMPORTANT: errors must be saved immediately after the call */
+        CffiLibffiCall(&asyncP->callCtx);
+#ifdef _WIN32
+        asyncP->savedWinError = GetLastError();
+#endif
+        asyncP->savedErrno = errno;
+
+        /* Once marked done, asyncP must not be touched by this thread */
+        Tcl_MutexLock(&cffiAsyncMutex);
+        asyncP->state = CFFI_ASYNC_DONE;
+        Tcl_ThreadQueueEvent(
+            asyncP->ownerThread, &asyncP->header, TCL_QUEUE_TAIL);
+        Tcl_ThreadAlert(asyncP->ownerThread);
+        Tcl_ConditionNotify(&cffiAsyncDoneCond);
+    }
+    Tcl_MutexUnlock(&cffiAsyncMutex);
+    Tcl_ExitThread(0);
+    TCL_THREAD_CREATE_RETURN;
+}
+
+/* Function: CffiAsyncFinalize
+ * Exit handler that shuts down the worker pool.
+ *
+ * Parameters:
+ * clientData - unused
+ *
+ * Workers complete any native call in progress before exiting. Queued
+ * calls that have not started are not made.
+ */
+static void
+CffiAsyncFinalize(ClientData clientData)
+{
+    int i, nWorkers;
+    Tcl_ThreadId workers[CFFI_ASYNC_MAX_WORKERS];
+
+    Tcl_MutexLock(&cffiAsyncMutex);
+    cffiAsyncShutdown = 1;
+    nWorkers          = cffiAsyncNumWorkers;
+    for (i = 0; i < nWorkers; ++i)
+        workers[i] = cffiAsyncWorkers[i];
+    Tcl_ConditionNotify(&cffiAsyncWorkCond);
+    Tcl_MutexUnlock(&cffiAsyncMutex);
+
+    for (i = 0; i < nWorkers; ++i) {
+        int result;
+        Tcl_JoinThread(workers[i], &result);
+    }
+}
+
+/* Function: CffiAsyncSubmit
+ * Queues an asynchronous call to the worker pool.
+ *
+ * Parameters:
+ * ip - interpreter for error messages
+ * asyncP - call to queue. Must be fully initialized.
+ *
+ * A new worker thread is created if none are idle and the pool is not
+ * at its maximum size.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* if no worker thread could be created
+ * with an error message in the interpreter.
+ */
+static CffiResult
+CffiAsyncSubmit(Tcl_Interp *ip, CffiAsyncCall *asyncP)
+{
+    Tcl_ThreadId tid;
+    int noWorkers = 0;
+
+    Tcl_MutexLock(&cffiAsyncMutex);
+    if (cffiAsyncNumIdle == 0 && cffiAsyncNumWorkers < CFFI_ASYNC_MAX_WORKERS
+        && !cffiAsyncShutdown) {
+        if (Tcl_CreateThread(&tid,
+                             CffiAsyncWorker,
+                             NULL,
+                             TCL_THREAD_STACK_DEFAULT,
+                             TCL_THREAD_JOINABLE)
+            == TCL_OK) {
+            if (cffiAsyncNumWorkers == 0)
+                Tcl_CreateExitHandler(CffiAsyncFinalize, NULL);
+            cffiAsyncWorkers[cffiAsyncNumWorkers++] = tid;
+        }
+    }
+    if (cffiAsyncNumWorkers == 0 || cffiAsyncShutdown)
+        noWorkers = 1;
+    else {
+        asyncP->state = CFFI_ASYNC_QUEUED;
+        asyncP->nextP = NULL;
+        if (cffiAsyncQueueTailP)
+            cffiAsyncQueueTailP->nextP = asyncP;
+        else
+            cffiAsyncQueueHeadP = asyncP;
+        cffiAsyncQueueTailP = asyncP;
+        Tcl_ConditionNotify(&cffiAsyncWorkCond);
+    }
+    Tcl_MutexUnlock(&cffiAsyncMutex);
+
+    if (noWorkers) {
+        return Tclh_ErrorGeneric(
+            ip, NULL, "Could not create thread for asynchronous call.");
+    }
+    return TCL_OK;
+}
+
+/* Function: CffiAsyncCallRelease
+ * Releases the interpreter resources held by an asynchronous call.
+ *
+ * Parameters:
+ * asyncP - the call. Must not be in the worker queue or running.
+ *
+ * The structure itself is not freed.
+ */
+static void
+CffiAsyncCallRelease(CffiAsyncCall *asyncP)
+{
+    int i;
+    for (i = 0; i < asyncP->callCtx.nArgs; ++i) {
+        if (asyncP->args[i].flags & CFFI_F_ARG_INITIALIZED)
+            CffiArgCleanup(&asyncP->callCtx, i);
+    }
+    Tclh_ObjClearPtr(&asyncP->argListObj);
+    if (asyncP->cmdObj)
+        Tclh_ObjClearPtr(&asyncP->cmdObj);
+    CffiFunctionUnref(asyncP->fnP);
+    asyncP->fnP    = NULL;
+    asyncP->ipCtxP = NULL;
+}
+
+/* Function: CffiAsyncCallsCleanup
+ * Detaches outstanding asynchronous calls from an interpreter context
+ * that is being deleted.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * Calls that have not started are discarded. Calls in progress cannot
+ * be aborted so the function waits for them to complete. Their completion
+ * events, which may already be queued, are then ignored.
+ */
+void
+CffiAsyncCallsCleanup(CffiInterpCtx *ipCtxP)
+{
+    CffiAsyncCall *asyncP;
+    CffiAsyncCall *nextP;
+    CffiAsyncCall **linkPP;
+
+    if (ipCtxP->asyncCallsP == NULL)
+        return;
+
+    Tcl_MutexLock(&cffiAsyncMutex);
+    for (asyncP = ipCtxP->asyncCallsP; asyncP; asyncP = asyncP->nextPendingP) {
+        if (asyncP->state == CFFI_ASYNC_QUEUED) {
+            /* Remove from the worker queue */
+            CffiAsyncCall *prevP = NULL;
+            for (linkPP = &cffiAsyncQueueHeadP; *linkPP != asyncP;
+                 linkPP = &(*linkPP)->nextP) {
+                prevP = *linkPP;
+            }
+            *linkPP = asyncP->nextP;
+            if (cffiAsyncQueueTailP == asyncP)
+                cffiAsyncQueueTailP = prevP;
+        }
+        else {
+            while (asyncP->state != CFFI_ASYNC_DONE)
+                Tcl_ConditionWait(
+                    &cffiAsyncDoneCond, &cffiAsyncMutex, NULL);
+        }
+    }
+    Tcl_MutexUnlock(&cffiAsyncMutex);
+
+    for (asyncP = ipCtxP->asyncCallsP; asyncP; asyncP = nextP) {
+        int queued = (asyncP->state == CFFI_ASYNC_QUEUED);
+        nextP      = asyncP->nextPendingP;
+        CffiAsyncCallRelease(asyncP);
+        /* Completed calls are freed by Tcl along with their event */
+        if (queued)
+            ckfree(asyncP);
+    }
+    ipCtxP->asyncCallsP = NULL;
+}
+
+/* Function: CffiAsyncCallFinish
+ * Completes an asynchronous call after the native function has returned.
+ *
+ * Parameters:
+ * asyncP - the call
+ * resultObjP - location to store the result. Stored value may be NULL if
+ *   the result is discarded. Otherwise its reference count is incremented.
+ *
+ * The processing of the return value and output parameters is the same
+ * as for synchronous calls in <CffiFunctionCall> including calling of
+ * error handlers.
+ *
+ * Returns:
+ * *TCL_OK* on success with the result in *resultObjP*, *TCL_ERROR* on
+ * failure with error message in the interpreter.
+ */
+static CffiResult
+CffiAsyncCallFinish(CffiAsyncCall *asyncP, Tcl_Obj **resultObjP)
+{
+    CffiFunction *fnP         = asyncP->fnP;
+    CffiProto *protoP         = fnP->protoP;
+    const CffiCallPlan *planP = protoP->planP;
+    CffiInterpCtx *ipCtxP     = asyncP->ipCtxP;
+    Tcl_Interp *ip            = ipCtxP->interp;
+    CffiCall *callP           = &asyncP->callCtx;
+    CffiTypeAndAttrs *retTypeAttrsP = &protoP->returnType.typeAttrs;
+    Tcl_Obj *resultObj = NULL;
+    Tcl_Obj **argObjs;
+    Tcl_Size nArgObjs;
+    CffiValue cretval;
+    Tcl_WideInt sysError = 0;
+    int discardResult;
+    int argResultIndex = planP->retvalIndex;
+    int i;
+    CffiResult ret        = TCL_OK;
+    CffiResult fnCheckRet = TCL_OK;
+
+    discardResult = (retTypeAttrsP->flags & CFFI_F_ATTR_DISCARD);
+
+    /*
+     * Restore the error state of the worker thread as the error checks
+     * below pick up errno and GetLastError.
+     */
+#ifdef _WIN32
+    SetLastError(asyncP->savedWinError);
+#endif
+    errno = asyncP->savedErrno;
+    if (retTypeAttrsP->flags & CFFI_F_ATTR_SAVEERROR) {
+        ipCtxP->savedErrno = asyncP->savedErrno;
+#ifdef _WIN32
+        ipCtxP->savedWinError = asyncP->savedWinError;
+#endif
+    }
+
+    /* See the DEFINEFN_ macro for libffi integer promotion */
+#define ASYNCRETVAL_(objfn_, fld_, type_)                                  \
+    do {                                                                   \
+        if (sizeof(type_) <= sizeof(ffi_arg))                              \
+            cretval.u.fld_ = (type_)callP->retValue.u.ffi_val;             \
+        else                                                               \
+            cretval.u.fld_ = callP->retValue.u.fld_;                       \
+        if (retTypeAttrsP->flags & CFFI_F_ATTR_REQUIREMENT_MASK)           \
+            fnCheckRet =                                                   \
+                CffiCheckNumeric(ip, retTypeAttrsP, &cretval, &sysError);  \
+        if (fnCheckRet != TCL_OK || (argResultIndex < 0 && !discardResult)) \
+            resultObj = objfn_(cretval.u.fld_);                            \
+    } while (0)
+
+    switch (retTypeAttrsP->dataType.baseType) {
+    case CFFI_K_TYPE_VOID:
+        if (!discardResult)
+            resultObj = Tcl_NewObj();
+        break;
+    case CFFI_K_TYPE_SCHAR:
+        ASYNCRETVAL_(Tcl_NewIntObj, schar, signed char);
+        break;
+    case CFFI_K_TYPE_UCHAR:
+        ASYNCRETVAL_(Tcl_NewIntObj, uchar, unsigned char);
+        break;
+    case CFFI_K_TYPE_SHORT:
+        ASYNCRETVAL_(Tcl_NewIntObj, sshort, short);
+        break;
+    case CFFI_K_TYPE_USHORT:
+        ASYNCRETVAL_(Tcl_NewIntObj, ushort, unsigned short);
+        break;
+    case CFFI_K_TYPE_INT:
+        ASYNCRETVAL_(Tcl_NewIntObj, sint, int);
+        break;
+    case CFFI_K_TYPE_UINT:
+        ASYNCRETVAL_(Tcl_NewWideIntObj, uint, unsigned int);
+        break;
+    case CFFI_K_TYPE_LONG:
+        ASYNCRETVAL_(Tcl_NewLongObj, slong, long);
+        break;
+    case CFFI_K_TYPE_ULONG:
+        ASYNCRETVAL_(Tclh_ObjFromULong, ulong, unsigned long);
+        break;
+    case CFFI_K_TYPE_LONGLONG:
+        ASYNCRETVAL_(Tcl_NewWideIntObj, slonglong, long long);
+        break;
+    case CFFI_K_TYPE_ULONGLONG:
+        ASYNCRETVAL_(Tclh_ObjFromULongLong, ulonglong, unsigned long long);
+        break;
+    case CFFI_K_TYPE_FLOAT:
+        cretval.u.flt = callP->retValue.u.flt;
+        if (retTypeAttrsP->flags & CFFI_F_ATTR_REQUIREMENT_MASK)
+            fnCheckRet =
+                CffiCheckNumeric(ip, retTypeAttrsP, &cretval, &sysError);
+        if (fnCheckRet != TCL_OK || (argResultIndex < 0 && !discardResult))
+            resultObj = Tcl_NewDoubleObj(cretval.u.flt);
+        break;
+    case CFFI_K_TYPE_DOUBLE:
+        cretval.u.dbl = callP->retValue.u.dbl;
+        if (retTypeAttrsP->flags & CFFI_F_ATTR_REQUIREMENT_MASK)
+            fnCheckRet =
+                CffiCheckNumeric(ip, retTypeAttrsP, &cretval, &sysError);
+        if (fnCheckRet != TCL_OK || (argResultIndex < 0 && !discardResult))
+            resultObj = Tcl_NewDoubleObj(cretval.u.dbl);
+        break;
+    case CFFI_K_TYPE_POINTER:
+        fnCheckRet = CffiCheckPointer(
+            ip, retTypeAttrsP, callP->retValue.u.ptr, &sysError);
+        if (!discardResult)
+            ret = CffiPointerToObj(
+                ipCtxP, retTypeAttrsP, callP->retValue.u.ptr, &resultObj);
+        break;
+    default:
+        /* CffiCallPlanAsyncCallable should not have permitted the call */
+        ret = CffiErrorType(
+            ip, retTypeAttrsP->dataType.baseType, __FILE__, __LINE__);
+        break;
+    }
+#undef ASYNCRETVAL_
+
+    if (resultObj)
+        Tcl_IncrRefCount(resultObj);
+
+    /* Note argListObj is private to the call so the array stays valid */
+    (void)Tcl_ListObjGetElements(NULL, asyncP->argListObj, &nArgObjs, &argObjs);
+
+    /* Store output parameters as in CffiFunctionCall */
+    if (ret == TCL_OK) {
+        for (i = 0; i < planP->nOutput; ++i) {
+            int outIndex        = planP->outputIndices[i];
+            CffiAttrFlags flags = protoP->params[outIndex].typeAttrs.flags;
+            if ((fnCheckRet == TCL_OK && !(flags & CFFI_F_ATTR_STOREONERROR))
+                || (fnCheckRet != TCL_OK && (flags & CFFI_F_ATTR_STOREONERROR))
+                || (flags & CFFI_F_ATTR_STOREALWAYS)) {
+                if (CffiArgPostProcess(callP, outIndex, NULL) != TCL_OK)
+                    ret = TCL_ERROR;
+            }
+        }
+    }
+
+    if (ret == TCL_OK && fnCheckRet == TCL_OK && argResultIndex >= 0) {
+        if (resultObj)
+            Tclh_ObjClearPtr(&resultObj);
+        ret = CffiArgPostProcess(callP, argResultIndex, &resultObj);
+        if (ret == TCL_OK && resultObj)
+            Tcl_IncrRefCount(resultObj);
+    }
+
+    if (ret == TCL_OK && fnCheckRet != TCL_OK) {
+        if ((retTypeAttrsP->flags & CFFI_F_ATTR_ONERROR)
+            && retTypeAttrsP->parseModeSpecificObj) {
+            Tclh_LifoMark mark = Tclh_LifoPushMark(&ipCtxP->memlifo);
+            ret = CffiCustomErrorHandler(ipCtxP,
+                                         protoP,
+                                         fnP->cmdNameObj,
+                                         argObjs,
+                                         callP->argsP,
+                                         resultObj);
+            Tclh_LifoPopMark(mark);
+            if (resultObj)
+                Tclh_ObjClearPtr(&resultObj);
+            if (ret == TCL_OK) {
+                resultObj = Tcl_GetObjResult(ip);
+                Tcl_IncrRefCount(resultObj);
+            }
+        }
+        else {
+            ret = CffiDefaultErrorHandler(
+                ip, retTypeAttrsP, resultObj, sysError);
+        }
+    }
+
+    if (ret != TCL_OK) {
+        if (resultObj)
+            Tclh_ObjClearPtr(&resultObj);
+        return TCL_ERROR;
+    }
+    *resultObjP = resultObj;
+    return TCL_OK;
+}
+
+/* Function: CffiAsyncCallEventProc
+ * Tcl event handler invoked in the interpreter thread when an asynchronous
+ * call completes.
+ *
+ * Parameters:
+ * evP - the completed call
+ * flags - event flags
+ *
+ * Output parameters are stored and the completion callback, if any, is
+ * invoked at global level with the status *ok* or *error* and the result
+ * or error message appended. Errors with no callback to receive them are
+ * reported as background errors.
+ *
+ * Returns:
+ * Always 1 indicating the event has been processed.
+ */
+static int
+CffiAsyncCallEventProc(Tcl_Event *evP, int flags)
+{
+    CffiAsyncCall *asyncP = (CffiAsyncCall *)evP;
+    CffiInterpCtx *ipCtxP = asyncP->ipCtxP;
+    CffiAsyncCall **linkPP;
+    Tcl_Interp *ip;
+    Tcl_Obj *resultObj = NULL;
+    Tcl_Obj *cmdObj    = NULL;
+    CffiResult ret;
+
+    if (ipCtxP == NULL)
+        return 1; /* Interpreter deleted. Resources already released */
+
+    for (linkPP = &ipCtxP->asyncCallsP; *linkPP != asyncP;
+         linkPP = &(*linkPP)->nextPendingP)
+        ;
+    *linkPP = asyncP->nextPendingP;
+
+    ip = ipCtxP->interp;
+    Tcl_Preserve(ip);
+    Tcl_ResetResult(ip);
+
+    ret = CffiAsyncCallFinish(asyncP, &resultObj);
+    if (asyncP->cmdObj) {
+        cmdObj = Tcl_DuplicateObj(asyncP->cmdObj);
+        Tcl_IncrRefCount(cmdObj);
+        Tcl_ListObjAppendElement(
+            NULL, cmdObj, Tcl_NewStringObj(ret == TCL_OK ? "ok" : "error", -1));
+        if (ret == TCL_OK)
+            Tcl_ListObjAppendElement(
+                NULL, cmdObj, resultObj ? resultObj : Tcl_NewObj());
+        else
+            Tcl_ListObjAppendElement(NULL, cmdObj, Tcl_GetObjResult(ip));
+    }
+    if (resultObj)
+        Tcl_DecrRefCount(resultObj);
 
-    CffiReturnCleanup(&callCtx);
-    for (i = 0; i < callCtx.nArgs; ++i)
-        CffiArgCleanup(&callCtx, i);
+    /* Release before the callback as it may delete the interpreter */
+    CffiAsyncCallRelease(asyncP);
 
-pop_and_go:
-    /* Clean up the temporary type descriptors for varargs */
-    if (varArgsInited && varArgTypesP) {
-        for (i = 0; i < nVarArgs; ++i) {
-            CffiTypeAndAttrsCleanup(&varArgTypesP[i]);
-        }
+    if (cmdObj) {
+        ret = Tcl_EvalObjEx(ip, cmdObj, TCL_EVAL_GLOBAL);
+        Tcl_DecrRefCount(cmdObj);
     }
+    if (ret != TCL_OK)
+        Tcl_BackgroundException(ip, ret);
+    Tcl_Release(ip);
+    return 1;
+}
 
-    CffiFunctionUnref(fnP);
-    Tclh_LifoPopMark(mark);
-    return ret;
+/* Function: CffiFunctionCallAsync
+ * Initiates an asynchronous call to a function.
+ *
+ * Parameters:
+ * fnP - function to call
+ * ip - interpreter
+ * objArgIndex - index of first argument in objv[]
+ * objc - number of elements in objv[]
+ * objv - arguments
+ * cmdObj - command prefix to invoke on completion. May be NULL.
+ *
+ * Arguments are converted in the calling thread and the native call is
+ * made from a worker thread. The prototype must be eligible for
+ * asynchronous calls as determined by <CffiCallPlanAsyncCallable>. Pointer
+ * arguments that are callbacks created with *callback new* are rejected.
+ * Names of output variables are resolved at global level when the call is
+ * initiated and when it completes.
+ *
+ * Returns:
+ * *TCL_OK* if the call was queued, *TCL_ERROR* on failure with error
+ * message in the interpreter.
+ */
+CffiResult
+CffiFunctionCallAsync(CffiFunction *fnP,
+                      Tcl_Interp *ip,
+                      int objArgIndex,
+                      int objc,
+                      Tcl_Obj *const objv[],
+                      Tcl_Obj *cmdObj)
+{
+    CffiProto *protoP         = fnP->protoP;
+    CffiInterpCtx *ipCtxP     = fnP->ipCtxP;
+    const CffiCallPlan *planP = protoP->planP;
+    CffiAsyncCall *asyncP;
+    Tcl_Obj **argObjs;
+    Tcl_Size nArgObjs;
+    int i, j;
 
-numargs_error:
-    /* Do NOT jump here if args are still to be cleaned up */
-    resultObj = Tcl_NewListObj(protoP->nParams + 2, NULL);
-    Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj("Syntax:", -1));
-    for (i = 0; i < objArgIndex; ++i)
-        Tcl_ListObjAppendElement(NULL, resultObj, objv[i]);
+    CFFI_ASSERT(ip == ipCtxP->interp);
+
+    if ((planP->flags & CFFI_F_PLAN_ASYNC) == 0) {
+        return Tclh_ErrorGeneric(
+            ip,
+            NULL,
+            "Function cannot be called asynchronously. Only functions with "
+            "scalar numeric or pointer parameters and return types are "
+            "supported.");
+    }
+    if ((uintptr_t) fnP->fnAddr < 0xffff)
+        return Tclh_ErrorInvalidValue(ip, NULL, "Function pointer not in executable page.");
+    if ((objc - objArgIndex) < planP->minArgs
+        || (objc - objArgIndex) > planP->maxArgs)
+        return CffiFunctionErrorNumArgs(protoP, ip, objArgIndex, objv);
+
+    /* protoP->cifP is lazy-initialized */
+    CHECK(CffiLibffiInitProtoCif(ipCtxP, protoP, 0, NULL, NULL));
+
+    asyncP = ckalloc(sizeof(*asyncP)
+                     + protoP->nParams
+                           * (sizeof(CffiArgument) + sizeof(void *)));
+    asyncP->header.proc    = CffiAsyncCallEventProc;
+    asyncP->header.nextPtr = NULL;
+    asyncP->ipCtxP         = ipCtxP;
+    asyncP->fnP            = fnP;
+    CffiFunctionRef(fnP);
+    asyncP->cmdObj = cmdObj;
+    if (cmdObj)
+        Tcl_IncrRefCount(cmdObj);
+    asyncP->ownerThread = Tcl_GetCurrentThread();
+    asyncP->callCtx.fnP   = fnP;
+    asyncP->callCtx.nArgs = protoP->nParams;
+    asyncP->callCtx.argsP = asyncP->args;
+    asyncP->callCtx.argValuesPP =
+        (void **)(asyncP->args + (protoP->nParams ? protoP->nParams : 1));
+    asyncP->callCtx.retValueP = NULL;
+    for (i = 0; i < protoP->nParams; ++i)
+        asyncP->args[i].flags = 0; /* Mark as uninitialized */
+
+    /*
+     * Collect the argument values, filling in defaults, into a list private
+     * to the call so they remain valid until completion. Output variable
+     * names are qualified as they will be accessed at global level.
+     */
+    asyncP->argListObj = Tcl_NewListObj(protoP->nParams, NULL);
+    Tcl_IncrRefCount(asyncP->argListObj);
+    for (i = 0, j = objArgIndex; i < protoP->nParams; ++i) {
+        CffiAttrFlags flags = protoP->params[i].typeAttrs.flags;
+        Tcl_Obj *valueObj;
+        if (flags & CFFI_F_ATTR_RETVAL)
+            valueObj = Tcl_NewObj(); /* Placeholder, not used */
+        else if (j < objc)
+            valueObj = objv[j++];
+        else
+            valueObj = protoP->params[i].typeAttrs.parseModeSpecificObj;
+        if ((flags & (CFFI_F_ATTR_OUT | CFFI_F_ATTR_INOUT))
+            && !(flags & CFFI_F_ATTR_RETVAL)) {
+            const char *varName = Tcl_GetString(valueObj);
+            if (varName[0] != '\0'
+                && (varName[0] != ':' || varName[1] != ':'))
+                valueObj = Tcl_ObjPrintf("::%s", varName);
+        }
+        Tcl_ListObjAppendElement(NULL, asyncP->argListObj, valueObj);
+    }
+    (void)Tcl_ListObjGetElements(NULL, asyncP->argListObj, &nArgObjs, &argObjs);
+
+    if (CffiReturnPrepare(&asyncP->callCtx) != TCL_OK)
+        goto error_return;
     for (i = 0; i < protoP->nParams; ++i) {
-        /* RETVAL params are "invisible" from caller's perspective */
-        if (! (protoP->params[i].typeAttrs.flags & CFFI_F_ATTR_RETVAL))
-            Tcl_ListObjAppendElement(
-                NULL, resultObj, protoP->params[i].nameObj);
+        CffiTypeAndAttrs *typeAttrsP = &protoP->params[i].typeAttrs;
+        asyncP->args[i].typeAttrsP   = typeAttrsP;
+        asyncP->args[i].arraySize    = typeAttrsP->dataType.arraySize;
+        if (planP->argPrepareProcs[i](
+                &asyncP->callCtx,
+                i,
+                (typeAttrsP->flags & CFFI_F_ATTR_RETVAL) ? NULL : argObjs[i])
+            != TCL_OK)
+            goto error_return;
+#ifdef CFFI_HAVE_CALLBACKS
+        /* Callbacks evaluate scripts so cannot be invoked from a worker */
+        if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_POINTER
+            && !(typeAttrsP->flags & CFFI_F_ATTR_OUT)
+            && asyncP->args[i].value.u.ptr
+            && Tcl_FindHashEntry(&ipCtxP->callbackClosures,
+                                 asyncP->args[i].value.u.ptr)) {
+            Tclh_ErrorInvalidValue(
+                ip,
+                argObjs[i],
+                "Callback function pointers cannot be passed to "
+                "asynchronous calls.");
+            goto error_return;
+        }
+#endif
     }
-    if (protoP->flags & CFFI_F_PROTO_VARARGS) {
-        Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewStringObj("...", 3));
+
+    asyncP->nextPendingP = ipCtxP->asyncCallsP;
+    ipCtxP->asyncCallsP  = asyncP;
+    if (CffiAsyncSubmit(ip, asyncP) != TCL_OK) {
+        ipCtxP->asyncCallsP = asyncP->nextPendingP;
+        goto error_return;
     }
-    Tclh_ErrorGeneric(ip, "NUMARGS", Tcl_GetString(resultObj));
-    /* Fall thru below */
-pop_and_error:
-    /* Do NOT jump here if args are still to be cleaned up */
-    /* Jump for error return after popping memlifo with error in interp */
-    if (resultObj)
-        Tcl_DecrRefCount(resultObj);
-    ret = TCL_ERROR;
-    goto pop_and_go;
 
+    return TCL_OK;
+
+error_return:
+    CffiAsyncCallRelease(asyncP);
+    ckfree(asyncP);
+    return TCL_ERROR;
 }
+#endif /* CFFI_USE_LIBFFI */
 
 CffiFunction *
 CffiFunctionNew(CffiInterpCtx *ipCtxP,
@@ -2408,6 +3994,7 @@ CffiFunctionNew(CffiInterpCtx *ipCtxP,
     if (cmdNameObj)
         Tcl_IncrRefCount(cmdNameObj);
     fnP->cmdNameObj = cmdNameObj;
+    fnP->statsP     = NULL;
     return fnP;
 }
 
@@ -2434,40 +4021,39 @@ CffiFunctionInstanceCmd(ClientData cdata,
     return ret;
 }
 
-/* Function: CffiDefineOneFunction
- * Creates a single command mapped to a function.
+/* Function: CffiFunctionDefine
+ * Parses a function definition and allocates the function descriptor.
  *
  * Parameters:
  *    ip - interpreter
  *    ipCtxP - interpreter context
  *    libCtxP - containing library, NULL for free standing function
  *    fnAddr - address of function
- *    cmdNameObj - name to give to command
+ *    cmdNameObj - name of command as specified by caller
+ *    fqnObj - fully qualified name of the command
  *    returnTypeObj - function return type definition
  *    paramsObj - list of parameter type definitions
  *    callMode - a calling convention
- *
- * *paramsObj* is a list of alternating parameter name and
- * type definitions. The return and parameter type definitions are in the
- * form expected by CffiTypeAndAttrsParse.
+ *    fnPP - location to store the function descriptor. It is returned
+ *      with a reference count of 1.
  *
  * Returns:
  * Returns TCL_OK on success and TCL_ERROR on failure with error message
  * in the interpreter.
  */
 static CffiResult
-CffiDefineOneFunction(Tcl_Interp *ip,
-                      CffiInterpCtx *ipCtxP,
-                      CffiLibCtx *libCtxP,
-                      void *fnAddr,
-                      Tcl_Obj *cmdNameObj,
-                      Tcl_Obj *returnTypeObj,
-                      Tcl_Obj *paramsObj,
-                      CffiABIProtocol abi)
+CffiFunctionDefine(Tcl_Interp *ip,
+                   CffiInterpCtx *ipCtxP,
+                   CffiLibCtx *libCtxP,
+                   void *fnAddr,
+                   Tcl_Obj *cmdNameObj,
+                   Tcl_Obj *fqnObj,
+                   Tcl_Obj *returnTypeObj,
+                   Tcl_Obj *paramsObj,
+                   CffiABIProtocol abi,
+                   CffiFunction **fnPP)
 {
-    Tcl_Obj *fqnObj;
     CffiProto *protoP = NULL;
-    CffiFunction *fnP = NULL;
     CffiResult ret;
     Tcl_Obj **paramObjs;
     Tcl_Size nparams;
@@ -2494,16 +4080,390 @@ CffiDefineOneFunction(Tcl_Interp *ip,
     protoP->cifP = NULL;
 #endif
 
+    *fnPP = CffiFunctionNew(ipCtxP, protoP, libCtxP, fqnObj, fnAddr);
+    CffiFunctionRef(*fnPP);
+    return TCL_OK;
+}
+
+/* Function: CffiDefineOneFunction
+ * Creates a single command mapped to a function.
+ *
+ * Parameters:
+ *    ip - interpreter
+ *    ipCtxP - interpreter context
+ *    libCtxP - containing library, NULL for free standing function
+ *    fnAddr - address of function
+ *    cmdNameObj - name to give to command
+ *    returnTypeObj - function return type definition
+ *    paramsObj - list of parameter type definitions
+ *    callMode - a calling convention
+ *
+ * *paramsObj* is a list of alternating parameter name and
+ * type definitions. The return and parameter type definitions are in the
+ * form expected by CffiTypeAndAttrsParse.
+ *
+ * Returns:
+ * Returns TCL_OK on success and TCL_ERROR on failure with error message
+ * in the interpreter.
+ */
+static CffiResult
+CffiDefineOneFunction(Tcl_Interp *ip,
+                      CffiInterpCtx *ipCtxP,
+                      CffiLibCtx *libCtxP,
+                      void *fnAddr,
+                      Tcl_Obj *cmdNameObj,
+                      Tcl_Obj *returnTypeObj,
+                      Tcl_Obj *paramsObj,
+                      CffiABIProtocol abi)
+{
+    Tcl_Obj *fqnObj;
+    CffiFunction *fnP = NULL;
+    CffiResult ret;
+
     fqnObj = Tclh_NsQualifyNameObj(ip, cmdNameObj, NULL);
-    fnP    = CffiFunctionNew(ipCtxP, protoP, libCtxP, fqnObj, fnAddr);
-    CffiFunctionRef(fnP); /* Will be unref-ed on command deletion */
-
-    Tcl_CreateObjCommand(ip,
-                         Tcl_GetString(fqnObj),
-                         CffiFunctionInstanceCmd,
-                         fnP,
-                         CffiFunctionInstanceDeleter);
-    Tcl_SetObjResult(ip, fqnObj);
+    Tcl_IncrRefCount(fqnObj);
+    ret = CffiFunctionDefine(ip,
+                             ipCtxP,
+                             libCtxP,
+                             fnAddr,
+                             cmdNameObj,
+                             fqnObj,
+                             returnTypeObj,
+                             paramsObj,
+                             abi,
+                             &fnP);
+    if (ret == TCL_OK) {
+        /* fnP will be unref-ed on command deletion */
+        Tcl_CreateObjCommand(ip,
+                             Tcl_GetString(fqnObj),
+                             CffiFunctionInstanceCmd,
+                             fnP,
+                             CffiFunctionInstanceDeleter);
+        Tcl_SetObjResult(ip, fqnObj);
+    }
+    Tcl_DecrRefCount(fqnObj);
+    return ret;
+}
+
+/* Struct: CffiLazyFunction
+ * Holds an unresolved function definition for a command created with
+ * the *-lazy* option. The symbol lookup and prototype parsing are done on
+ * the first call to the command at which point the command is converted to
+ * a normal function command and this structure freed.
+ */
+typedef struct CffiLazyFunction {
+    CffiLibCtx *libCtxP;      /* Library containing the function */
+    Tcl_Obj *symbolObj;       /* Name of the C function */
+    Tcl_Obj *cmdNameObj;      /* Command name as specified in definition */
+    Tcl_Obj *fqnObj;          /* Fully qualified command name */
+    Tcl_Obj *nsNameObj;       /* Namespace in which definition was made */
+    Tcl_Obj *returnTypeObj;   /* Return type definition */
+    Tcl_Obj *paramsObj;       /* Parameter definitions */
+    Tcl_Command token;        /* Token for the stub command */
+    CffiABIProtocol callMode; /* Calling convention */
+    int resolving;            /* Resolution in progress in defining
+                                 namespace */
+    int ignoreMissing;        /* Delete the command if symbol not found */
+    int symbolMissing;        /* Symbol lookup failed */
+} CffiLazyFunction;
+
+/* Function: CffiLazyFunctionFree
+ * Frees a lazy function definition.
+ *
+ * Parameters:
+ * cdata - the CffiLazyFunction to free.
+ */
+static void
+CffiLazyFunctionFree(ClientData cdata)
+{
+    CffiLazyFunction *lazyP = (CffiLazyFunction *)cdata;
+    Tcl_DecrRefCount(lazyP->symbolObj);
+    Tcl_DecrRefCount(lazyP->cmdNameObj);
+    Tcl_DecrRefCount(lazyP->fqnObj);
+    Tcl_DecrRefCount(lazyP->nsNameObj);
+    Tcl_DecrRefCount(lazyP->returnTypeObj);
+    Tcl_DecrRefCount(lazyP->paramsObj);
+    CffiLibCtxUnref(lazyP->libCtxP);
+    ckfree(lazyP);
+}
+
+/* Function: CffiLazyFunctionResolveHere
+ * Resolves a lazy function definition in the current namespace and
+ * converts its command to a normal function command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * lazyP - the lazy definition. It is freed on success and must not be
+ *   accessed after the call.
+ * fnPP - location to store the resolved function
+ *
+ * Returns:
+ * Returns TCL_OK on success and TCL_ERROR on failure with error message
+ * in the interpreter. On failure the command remains a lazy stub.
+ */
+static CffiResult
+CffiLazyFunctionResolveHere(Tcl_Interp *ip,
+                            CffiLazyFunction *lazyP,
+                            CffiFunction **fnPP)
+{
+    CffiFunction *fnP;
+    Tcl_CmdInfo cmdInfo;
+    void *fnAddr;
+
+    fnAddr = CffiLibFindSymbol(ip, lazyP->libCtxP->libH, lazyP->symbolObj);
+    if (fnAddr == NULL) {
+        lazyP->symbolMissing = 1;
+        return Tclh_ErrorNotFound(ip, "Symbol", lazyP->symbolObj, NULL);
+    }
+
+    CHECK(CffiFunctionDefine(ip,
+                             lazyP->libCtxP->ipCtxP,
+                             lazyP->libCtxP,
+                             fnAddr,
+                             lazyP->cmdNameObj,
+                             lazyP->fqnObj,
+                             lazyP->returnTypeObj,
+                             lazyP->paramsObj,
+                             lazyP->callMode,
+                             &fnP));
+
+    /*
+     * Switch the command over in place rather than recreating it so
+     * renames and traces on the command are preserved. The function
+     * reference is released by the new deleter.
+     */
+    if (Tcl_GetCommandInfoFromToken(lazyP->token, &cmdInfo) == 0) {
+        CffiFunctionUnref(fnP);
+        return Tclh_ErrorNotFound(ip, "Command", lazyP->fqnObj, NULL);
+    }
+    cmdInfo.objProc       = CffiFunctionInstanceCmd;
+    cmdInfo.objClientData = fnP;
+    cmdInfo.deleteProc    = CffiFunctionInstanceDeleter;
+    cmdInfo.deleteData    = fnP;
+    Tcl_SetCommandInfoFromToken(lazyP->token, &cmdInfo);
+    CffiLazyFunctionFree(lazyP);
+
+    *fnPP = fnP;
+    return TCL_OK;
+}
+
+/* Function: CffiLazyFunctionResolveFailed
+ * Handles failure to resolve a lazy function definition.
+ *
+ * Parameters:
+ * ip - interpreter
+ * lazyP - the lazy definition. It is freed if the command is deleted and
+ *   must not be accessed after the call.
+ *
+ * If the definition was made with *-ignoremissing* and the symbol was not
+ * found, the stub command is deleted as it would not have been created
+ * had the definition not been lazy. The interpreter result is unchanged.
+ */
+static void
+CffiLazyFunctionResolveFailed(Tcl_Interp *ip, CffiLazyFunction *lazyP)
+{
+    if (lazyP->ignoreMissing && lazyP->symbolMissing)
+        Tcl_DeleteCommandFromToken(ip, lazyP->token); /* Frees lazyP */
+}
+
+/* Function: CffiLazyFunctionResolve
+ * Resolves a lazy function definition and converts its command to a
+ * normal function command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * lazyP - the lazy definition. It is freed on success and must not be
+ *   accessed after the call.
+ * fnPP - location to store the resolved function
+ *
+ * Type and tag names in the definition must resolve as they would have at
+ * definition time. If the current namespace is not the one in which the
+ * definition was made, the stub command is re-entered through
+ * *namespace eval* in the defining namespace to do the resolution.
+ *
+ * Returns:
+ * Returns TCL_OK on success and TCL_ERROR on failure with error message
+ * in the interpreter. On failure the command remains a lazy stub unless
+ * it is deleted by <CffiLazyFunctionResolveFailed>.
+ */
+static CffiResult
+CffiLazyFunctionResolve(Tcl_Interp *ip,
+                        CffiLazyFunction *lazyP,
+                        CffiFunction **fnPP)
+{
+    Tcl_Namespace *nsP;
+    Tcl_Command token;
+    Tcl_CmdInfo cmdInfo;
+    Tcl_Obj *objs[4];
+    Tcl_Obj *fqnObj;
+    CffiResult ret;
+    int i;
+
+    nsP = Tcl_FindNamespace(ip, Tcl_GetString(lazyP->nsNameObj), NULL, 0);
+    if (lazyP->resolving || nsP == NULL || nsP == Tcl_GetCurrentNamespace(ip)) {
+        ret = CffiLazyFunctionResolveHere(ip, lazyP, fnPP);
+        /* If resolving, the outer call handles the failure */
+        if (ret != TCL_OK && !lazyP->resolving)
+            CffiLazyFunctionResolveFailed(ip, lazyP);
+        return ret;
+    }
+
+    /*
+     * The script is a single element list so the command name is not
+     * subject to substitution or word splitting.
+     */
+    token   = lazyP->token;
+    fqnObj  = Tcl_NewObj();
+    Tcl_GetCommandFullName(ip, token, fqnObj);
+    objs[0] = Tcl_NewStringObj("::namespace", -1);
+    objs[1] = Tcl_NewStringObj("eval", 4);
+    objs[2] = lazyP->nsNameObj;
+    objs[3] = Tcl_NewListObj(1, &fqnObj);
+    for (i = 0; i < 4; ++i)
+        Tcl_IncrRefCount(objs[i]);
+    lazyP->resolving = 1;
+    ret = Tcl_EvalObjv(ip, 4, objs, 0);
+    for (i = 0; i < 4; ++i)
+        Tcl_DecrRefCount(objs[i]);
+    if (ret != TCL_OK) {
+        lazyP->resolving = 0; /* Still a stub since resolution failed */
+        CffiLazyFunctionResolveFailed(ip, lazyP);
+        return TCL_ERROR;
+    }
+    /* lazyP has been freed at this point */
+    Tcl_ResetResult(ip);
+    if (Tcl_GetCommandInfoFromToken(token, &cmdInfo) == 0
+        || cmdInfo.objProc != CffiFunctionInstanceCmd) {
+        return Tclh_ErrorGeneric(
+            ip, NULL, "Internal error: lazy function not resolved.");
+    }
+    *fnPP = (CffiFunction *)cmdInfo.objClientData;
+    return TCL_OK;
+}
+
+/* Function: CffiLazyFunctionInstanceCmd
+ * Implements the stub command for a function defined with *-lazy*.
+ *
+ * Parameters:
+ * cdata - the CffiLazyFunction definition
+ * ip - interpreter
+ * objc - number of elements in *objv*
+ * objv - command arguments
+ *
+ * Resolves the definition and then calls the function. When invoked from
+ * CffiLazyFunctionResolve to resolve the definition in its namespace, the
+ * function is not called.
+ *
+ * Returns:
+ * Returns TCL_OK on success and TCL_ERROR on failure with error message
+ * in the interpreter.
+ */
+CffiResult
+CffiLazyFunctionInstanceCmd(ClientData cdata,
+                            Tcl_Interp *ip,
+                            int objc,
+                            Tcl_Obj *const objv[])
+{
+    CffiLazyFunction *lazyP = (CffiLazyFunction *)cdata;
+    CffiFunction *fnP;
+
+    if (lazyP->resolving)
+        return CffiLazyFunctionResolveHere(ip, lazyP, &fnP);
+    CHECK(CffiLazyFunctionResolve(ip, lazyP, &fnP));
+    return CffiFunctionCall(fnP, ip, 1, objc, objv);
+}
+
+/* Function: CffiDefineLazyFunction
+ * Creates a stub command for a function whose definition is resolved on
+ * first call.
+ *
+ * Parameters:
+ *    ip - interpreter
+ *    libCtxP - containing library
+ *    symbolObj - name of the C function
+ *    cmdNameObj - name to give to command
+ *    returnTypeObj - function return type definition
+ *    paramsObj - list of parameter type definitions
+ *    callMode - a calling convention
+ *    flags - if CFFI_F_DEFINE_IGNOREMISSING is set, the command is deleted
+ *            on first call if the symbol is not found
+ *
+ * Returns:
+ * Returns TCL_OK on success with the fully qualified command name as the
+ * interpreter result.
+ */
+static CffiResult
+CffiDefineLazyFunction(Tcl_Interp *ip,
+                       CffiLibCtx *libCtxP,
+                       Tcl_Obj *symbolObj,
+                       Tcl_Obj *cmdNameObj,
+                       Tcl_Obj *returnTypeObj,
+                       Tcl_Obj *paramsObj,
+                       CffiABIProtocol callMode,
+                       int flags)
+{
+    CffiLazyFunction *lazyP = ckalloc(sizeof(*lazyP));
+
+    CffiLibCtxRef(libCtxP);
+    lazyP->libCtxP = libCtxP;
+    lazyP->symbolObj = symbolObj;
+    lazyP->cmdNameObj = cmdNameObj;
+    lazyP->fqnObj = Tclh_NsQualifyNameObj(ip, cmdNameObj, NULL);
+    lazyP->nsNameObj =
+        Tcl_NewStringObj(Tcl_GetCurrentNamespace(ip)->fullName, -1);
+    lazyP->returnTypeObj = returnTypeObj;
+    lazyP->paramsObj = paramsObj;
+    lazyP->callMode = callMode;
+    lazyP->resolving = 0;
+    lazyP->ignoreMissing = (flags & CFFI_F_DEFINE_IGNOREMISSING) != 0;
+    lazyP->symbolMissing = 0;
+    Tcl_IncrRefCount(lazyP->symbolObj);
+    Tcl_IncrRefCount(lazyP->cmdNameObj);
+    Tcl_IncrRefCount(lazyP->fqnObj);
+    Tcl_IncrRefCount(lazyP->nsNameObj);
+    Tcl_IncrRefCount(lazyP->returnTypeObj);
+    Tcl_IncrRefCount(lazyP->paramsObj);
+
+    lazyP->token = Tcl_CreateObjCommand(ip,
+                                        Tcl_GetString(lazyP->fqnObj),
+                                        CffiLazyFunctionInstanceCmd,
+                                        lazyP,
+                                        CffiLazyFunctionFree);
+    Tcl_SetObjResult(ip, lazyP->fqnObj);
+    return TCL_OK;
+}
+
+/* Function: CffiFunctionFromCommand
+ * Returns the function mapped to a command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * cmdNameObj - name of the command
+ * fnPP - location to store the function. Set to NULL if the command does
+ *   not exist or is not mapped to a function.
+ *
+ * Commands defined with *-lazy* are resolved if not already done.
+ *
+ * Returns:
+ * Returns TCL_OK on success and TCL_ERROR if a lazy definition could not be
+ * resolved with an error message in the interpreter.
+ */
+CffiResult
+CffiFunctionFromCommand(Tcl_Interp *ip,
+                        Tcl_Obj *cmdNameObj,
+                        CffiFunction **fnPP)
+{
+    Tcl_CmdInfo cmdInfo;
+
+    *fnPP = NULL;
+    if (Tcl_GetCommandInfo(ip, Tcl_GetString(cmdNameObj), &cmdInfo)) {
+        if (cmdInfo.objProc == CffiFunctionInstanceCmd)
+            *fnPP = (CffiFunction *)cmdInfo.objClientData;
+        else if (cmdInfo.objProc == CffiLazyFunctionInstanceCmd) {
+            return CffiLazyFunctionResolve(
+                ip, (CffiLazyFunction *)cmdInfo.objClientData, fnPP);
+        }
+    }
     return TCL_OK;
 }
 
@@ -2518,7 +4478,12 @@ CffiDefineOneFunction(Tcl_Interp *ip,
  *    callMode - a dyncall call mode that overrides one specified
  *               in the return type definition if anything other
  *               than default
- *    flags - if low bit set, missing functions are ignored
+ *    flags - if CFFI_F_DEFINE_IGNOREMISSING is set, missing functions are
+ *            ignored. If CFFI_F_DEFINE_LAZY is set, only a stub command is
+ *            created and the symbol lookup and definition parsing are
+ *            deferred to the first call. A stub for a missing function
+ *            is then deleted on first call if CFFI_F_DEFINE_IGNOREMISSING
+ *            is also set.
  *
  * *paramsObj* is a list of alternating parameter name and
  * type definitions. The return and parameter type definitions are in the
@@ -2546,19 +4511,29 @@ CffiDefineOneFunctionFromLib(Tcl_Interp *ip,
     if (nNames == 0 || nNames > 2)
         return Tclh_ErrorInvalidValue(ip, nameObj, "Empty or invalid function name specification.");
 
+    if (nNames < 2 || ! strcmp("", Tcl_GetString(nameObjs[1])))
+        cmdNameObj = nameObjs[0];
+    else
+        cmdNameObj = nameObjs[1];
+
+    if (flags & CFFI_F_DEFINE_LAZY) {
+        return CffiDefineLazyFunction(ip,
+                                      libCtxP,
+                                      nameObjs[0],
+                                      cmdNameObj,
+                                      returnTypeObj,
+                                      paramsObj,
+                                      callMode,
+                                      flags);
+    }
+
     fn = CffiLibFindSymbol(ip, libCtxP->libH, nameObjs[0]);
     if (fn == NULL) {
-            /* flags & 1 -> No errors on missing functions */
-        return (flags & 1)
+        return (flags & CFFI_F_DEFINE_IGNOREMISSING)
                  ? TCL_OK
                  : Tclh_ErrorNotFound(ip, "Symbol", nameObjs[0], NULL);
     }
 
-    if (nNames < 2 || ! strcmp("", Tcl_GetString(nameObjs[1])))
-        cmdNameObj = nameObjs[0];
-    else
-        cmdNameObj = nameObjs[1];
-
     return CffiDefineOneFunction(ip,
                                  libCtxP->ipCtxP,
                                  libCtxP,
@@ -56,8 +56,12 @@ CffiHelpFunctionCmd(CffiInterpCtx *ipCtxP, Tcl_Obj *fnNameObj)
     Tcl_CmdInfo cmdInfo;
     CffiProto *protoP;
     Tcl_Obj *resultObj;
+    CffiFunction *fnP;
     int i;
 
+    /* Resolves functions defined with -lazy so the prototype is available */
+    CHECK(CffiFunctionFromCommand(ipCtxP->interp, fnNameObj, &fnP));
+
     if (!Tcl_GetCommandInfo(ipCtxP->interp, Tcl_GetString(fnNameObj), &cmdInfo)
         || !cmdInfo.isNativeObjectProc
         || (cmdInfo.objProc != CffiFunctionInstanceCmd
@@ -66,7 +70,6 @@ CffiHelpFunctionCmd(CffiInterpCtx *ipCtxP, Tcl_Obj *fnNameObj)
         return Tclh_ErrorNotFound(ipCtxP->interp, "Cffi command", fnNameObj, NULL);
     }
     if (cmdInfo.objProc == CffiFunctionInstanceCmd) {
-        CffiFunction *fnP = (CffiFunction *)cmdInfo.objClientData;
         protoP = fnP->protoP;
     } else {
         CffiMethod *methodP = (CffiMethod *)cmdInfo.objClientData;
@@ -265,7 +268,8 @@ CffiHelpFunctionsCmd(CffiInterpCtx *ipCtxP, Tcl_Obj *patObj)
                 if (Tcl_GetCommandInfo(
                         ip, Tcl_GetString(commandObjs[i]), &cmdInfo)
                     && cmdInfo.isNativeObjectProc
-                    && cmdInfo.objProc == CffiFunctionInstanceCmd
+                    && (cmdInfo.objProc == CffiFunctionInstanceCmd
+                        || cmdInfo.objProc == CffiLazyFunctionInstanceCmd)
                     && cmdInfo.objClientData != NULL) {
                     Tcl_ListObjAppendElement(NULL, resultObj, commandObjs[i]);
                 }
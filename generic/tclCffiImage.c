@@ -0,0 +1,1526 @@
+/*
+ * Copyright (c) 2024, Ashok P. Nadkarni
+ * All rights reserved.
+ *
+ * See the file LICENSE for license
+ */
+
+/*
+ * Implements the cffi::image command which saves the resolved struct,
+ * prototype, enum and alias definitions of an interpreter to a binary
+ * image file and loads them back without reparsing the definitions.
+ *
+ * Image layout - all integers are 32-bit in native byte order:
+ *
+ *   magic[8] version byteorder pointersize longsize backend defaultabi ntypes
+ *   nstrings {len bytes}...
+ *   nstructs {struct record}...
+ *   naliases {name typeattrs}...
+ *   nenums {name members}...
+ *   nprototypes {prototype record}...
+ *
+ * Strings are referenced by their index in the string table, -1 indicating
+ * a NULL. Structs are referenced by their index in the struct table and
+ * are ordered so that nested structs precede their containers. The header
+ * fields are checked on load so an image is only usable with the same
+ * image format, backend and data model it was created with.
+ *
+ * Images may also be published in memory under a name and attached by
+ * any interpreter in the process.
+ */
+
+#include "tclCffiInt.h"
+
+#define CFFI_IMAGE_MAGIC "CFFIIMG"
+#define CFFI_IMAGE_VERSION 1
+#define CFFI_IMAGE_BYTEORDER 0x01020304
+
+#ifdef CFFI_USE_LIBFFI
+# define CFFI_IMAGE_BACKEND 1
+#else
+# define CFFI_IMAGE_BACKEND 2
+#endif
+
+/* Struct: CffiImageWriter
+ * State used when saving an image.
+ */
+typedef struct CffiImageWriter {
+    CffiInterpCtx *ipCtxP;
+    Tcl_DString strings;   /* String table records */
+    Tcl_DString structs;   /* Struct records */
+    Tcl_DString body;      /* Alias, enum and prototype records */
+    Tcl_HashTable stringIds; /* string -> index into string table */
+    Tcl_HashTable structIds; /* CffiStruct* -> index into struct table */
+    int nStrings;
+    int nStructs;
+} CffiImageWriter;
+
+/* Struct: CffiImageReader
+ * State used when loading an image.
+ */
+typedef struct CffiImageReader {
+    CffiInterpCtx *ipCtxP;
+    Tcl_Obj *sourceObj;         /* Image file or name for error messages */
+    const unsigned char *p;     /* Current read position */
+    const unsigned char *end;   /* End of image data */
+    Tcl_Obj **strings;          /* String table */
+    int nStrings;
+    CffiStruct **structs;       /* Struct table */
+    int nStructs;
+} CffiImageReader;
+
+static void
+CffiImagePutInt(Tcl_DString *dsP, int value)
+{
+    Tcl_DStringAppend(dsP, (char *)&value, sizeof(value));
+}
+
+/* Function: CffiImagePutString
+ * Appends a reference to a string table entry to an image section.
+ *
+ * Parameters:
+ * wrP - image writer state
+ * dsP - section to append to
+ * objP - string to reference. May be NULL.
+ */
+static void
+CffiImagePutString(CffiImageWriter *wrP, Tcl_DString *dsP, Tcl_Obj *objP)
+{
+    Tcl_HashEntry *heP;
+    const char *s;
+    Tcl_Size len;
+    int isNew;
+
+    if (objP == NULL) {
+        CffiImagePutInt(dsP, -1);
+        return;
+    }
+    s   = Tcl_GetStringFromObj(objP, &len);
+    heP = Tcl_CreateHashEntry(&wrP->stringIds, s, &isNew);
+    if (isNew) {
+        Tcl_SetHashValue(heP, (ClientData)(intptr_t)wrP->nStrings);
+        CffiImagePutInt(&wrP->strings, (int)len);
+        Tcl_DStringAppend(&wrP->strings, s, len);
+        wrP->nStrings += 1;
+    }
+    CffiImagePutInt(dsP, (int)(intptr_t)Tcl_GetHashValue(heP));
+}
+
+static int CffiImageAddStruct(CffiImageWriter *wrP, CffiStruct *structP);
+
+/* Function: CffiImagePutTypeAndAttrs
+ * Appends a type descriptor to an image section.
+ *
+ * Parameters:
+ * wrP - image writer state
+ * dsP - section to append to
+ * typeAttrsP - type descriptor. Any referenced structs must already have
+ *   been added to the struct table.
+ */
+static void
+CffiImagePutTypeAndAttrs(CffiImageWriter *wrP,
+                         Tcl_DString *dsP,
+                         const CffiTypeAndAttrs *typeAttrsP)
+{
+    const CffiType *typeP = &typeAttrsP->dataType;
+    Tcl_Obj *encNameObj;
+
+    CffiImagePutInt(dsP, typeP->baseType);
+    CffiImagePutInt(dsP, typeP->arraySize);
+    CffiImagePutInt(dsP, typeP->baseTypeSize);
+    CffiImagePutInt(dsP, typeP->flags);
+    CffiImagePutInt(dsP, typeAttrsP->flags);
+    switch (typeP->baseType) {
+    case CFFI_K_TYPE_STRUCT:
+        CffiImagePutInt(dsP, CffiImageAddStruct(wrP, typeP->u.structP));
+        break;
+    case CFFI_K_TYPE_ASTRING:
+    case CFFI_K_TYPE_CHAR_ARRAY:
+        if (typeP->u.encoding) {
+            encNameObj =
+                Tcl_NewStringObj(Tcl_GetEncodingName(typeP->u.encoding), -1);
+            Tcl_IncrRefCount(encNameObj);
+            CffiImagePutString(wrP, dsP, encNameObj);
+            Tcl_DecrRefCount(encNameObj);
+        }
+        else
+            CffiImagePutInt(dsP, -1);
+        break;
+    default:
+        CffiImagePutString(wrP, dsP, typeP->u.tagNameObj);
+        break;
+    }
+    CffiImagePutString(wrP, dsP, typeP->countHolderObj);
+    CffiImagePutString(wrP, dsP, typeAttrsP->parseModeSpecificObj);
+}
+
+/* Function: CffiImageAddStruct
+ * Adds a struct and any structs nested within it to the struct table.
+ *
+ * Parameters:
+ * wrP - image writer state
+ * structP - struct descriptor
+ *
+ * Returns:
+ * The index of the struct in the struct table.
+ */
+static int
+CffiImageAddStruct(CffiImageWriter *wrP, CffiStruct *structP)
+{
+    Tcl_HashEntry *heP;
+    Tcl_DString *dsP = &wrP->structs;
+    int i;
+
+    heP = Tcl_FindHashEntry(&wrP->structIds, (char *)structP);
+    if (heP)
+        return (int)(intptr_t)Tcl_GetHashValue(heP);
+
+    /* Nested structs must precede this one in the table */
+    for (i = 0; i < structP->nFields; ++i) {
+        CffiType *typeP = &structP->fields[i].fieldType.dataType;
+        if (typeP->baseType == CFFI_K_TYPE_STRUCT)
+            (void)CffiImageAddStruct(wrP, typeP->u.structP);
+    }
+
+    heP = Tcl_CreateHashEntry(&wrP->structIds, (char *)structP, &i);
+    Tcl_SetHashValue(heP, (ClientData)(intptr_t)wrP->nStructs);
+
+    CffiImagePutString(wrP, dsP, structP->name);
+    CffiImagePutInt(dsP, structP->size);
+    CffiImagePutInt(dsP, structP->alignment);
+    CffiImagePutInt(dsP, structP->pack);
+    CffiImagePutInt(dsP, structP->flags);
+    CffiImagePutInt(dsP, structP->structSizeFieldIndex);
+    CffiImagePutInt(dsP, structP->dynamicCountFieldIndex);
+    CffiImagePutInt(dsP, structP->nFields);
+    for (i = 0; i < structP->nFields; ++i) {
+        CffiField *fieldP = &structP->fields[i];
+        CffiImagePutString(wrP, dsP, fieldP->nameObj);
+        CffiImagePutInt(dsP, (int)fieldP->offset);
+        CffiImagePutInt(dsP, (int)fieldP->size);
+        CffiImagePutTypeAndAttrs(wrP, dsP, &fieldP->fieldType);
+    }
+    return wrP->nStructs++;
+}
+
+/* Adds the structs referenced by a type to the struct table */
+static void
+CffiImageAddTypeStructs(CffiImageWriter *wrP, const CffiTypeAndAttrs *typeAttrsP)
+{
+    if (typeAttrsP->dataType.baseType == CFFI_K_TYPE_STRUCT)
+        (void)CffiImageAddStruct(wrP, typeAttrsP->dataType.u.structP);
+}
+
+/* Function: CffiImagePutProto
+ * Appends a prototype record to the image body.
+ *
+ * Parameters:
+ * wrP - image writer state
+ * nameObj - fully qualified prototype name
+ * protoP - prototype descriptor
+ */
+static void
+CffiImagePutProto(CffiImageWriter *wrP, Tcl_Obj *nameObj, CffiProto *protoP)
+{
+    Tcl_DString *dsP = &wrP->body;
+    int i;
+
+    CffiImagePutString(wrP, dsP, nameObj);
+    CffiImagePutInt(dsP, (int)protoP->abi);
+    CffiImagePutInt(dsP, protoP->flags);
+    CffiImagePutInt(dsP, protoP->nParams);
+    CffiImagePutTypeAndAttrs(wrP, dsP, &protoP->returnType.typeAttrs);
+    for (i = 0; i < protoP->nParams; ++i) {
+        CffiParam *paramP = &protoP->params[i];
+        CffiImagePutString(wrP, dsP, paramP->nameObj);
+        CffiImagePutInt(dsP, paramP->arraySizeParamIndex);
+        CffiImagePutTypeAndAttrs(wrP, dsP, &paramP->typeAttrs);
+    }
+}
+
+/* Function: CffiImageAssemble
+ * Assembles the sections of an image writer into a complete image.
+ *
+ * Parameters:
+ * wrP - image writer state
+ * imageP - uninitialized Tcl_DString to hold the image. Caller must
+ *   free it with Tcl_DStringFree.
+ */
+static void
+CffiImageAssemble(CffiImageWriter *wrP, Tcl_DString *imageP)
+{
+    Tcl_DStringInit(imageP);
+    Tcl_DStringAppend(imageP, CFFI_IMAGE_MAGIC, sizeof(CFFI_IMAGE_MAGIC));
+    CffiImagePutInt(imageP, CFFI_IMAGE_VERSION);
+    CffiImagePutInt(imageP, CFFI_IMAGE_BYTEORDER);
+    CffiImagePutInt(imageP, (int)sizeof(void *));
+    CffiImagePutInt(imageP, (int)sizeof(long));
+    CffiImagePutInt(imageP, CFFI_IMAGE_BACKEND);
+    CffiImagePutInt(imageP, (int)CffiDefaultABI());
+    CffiImagePutInt(imageP, CFFI_K_NUM_TYPES);
+    CffiImagePutInt(imageP, wrP->nStrings);
+    Tcl_DStringAppend(imageP,
+                      Tcl_DStringValue(&wrP->strings),
+                      Tcl_DStringLength(&wrP->strings));
+    CffiImagePutInt(imageP, wrP->nStructs);
+    Tcl_DStringAppend(imageP,
+                      Tcl_DStringValue(&wrP->structs),
+                      Tcl_DStringLength(&wrP->structs));
+    Tcl_DStringAppend(
+        imageP, Tcl_DStringValue(&wrP->body), Tcl_DStringLength(&wrP->body));
+}
+
+/* Function: CffiImageBuild
+ * Builds an image from the definitions in an interpreter.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image SUBCMD NAME ?-pattern PATTERN? ?-structs STRUCTLIST?*
+ * imageP - uninitialized Tcl_DString to hold the image on success. Caller
+ *   must free it with Tcl_DStringFree.
+ *
+ * Aliases, enums and prototypes whose names match *PATTERN* are included
+ * along with all structs and unions they reference and those listed in
+ * *STRUCTLIST*.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageBuild(CffiInterpCtx *ipCtxP,
+               int objc,
+               Tcl_Obj *const objv[],
+               Tcl_DString *imageP)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiImageWriter wr;
+    CffiScope *scopeP = &ipCtxP->scope;
+    Tcl_Obj *namesObj[3] = {NULL, NULL, NULL};
+    Tcl_Obj **nameObjs;
+    Tcl_Obj **structObjs = NULL;
+    CffiStruct **structPtrs = NULL;
+    Tcl_Size i, j, nNames, nStructObjs = 0;
+    const char *pattern = NULL;
+    int optIndex;
+    static const char *const opts[] = {"-pattern", "-structs", NULL};
+    enum OPT { PATTERN, STRUCTS };
+
+    for (i = 3; i < objc; ++i) {
+        CHECK(Tcl_GetIndexFromObj(ip, objv[i], opts, "option", 0, &optIndex));
+        if (i == objc - 1)
+            return Tclh_ErrorOptionValueMissing(ip, objv[i], NULL);
+        ++i;
+        switch (optIndex) {
+        case PATTERN:
+            pattern = Tcl_GetString(objv[i]);
+            break;
+        case STRUCTS:
+            CHECK(Tcl_ListObjGetElements(ip, objv[i], &nStructObjs, &structObjs));
+            break;
+        }
+    }
+
+    /* Resolve explicitly listed structs before generating any output */
+    if (nStructObjs) {
+        structPtrs = ckalloc(nStructObjs * sizeof(CffiStruct *));
+        for (i = 0; i < nStructObjs; ++i) {
+            if (CffiStructResolve(ip,
+                                  Tcl_GetString(structObjs[i]),
+                                  CFFI_K_TYPE_STRUCT,
+                                  &structPtrs[i])
+                    != TCL_OK
+                && CffiStructResolve(ip,
+                                     Tcl_GetString(structObjs[i]),
+                                     CFFI_K_TYPE_UNION,
+                                     &structPtrs[i])
+                       != TCL_OK) {
+                goto error_return;
+            }
+        }
+        Tcl_ResetResult(ip);
+    }
+
+    if (CffiNameListNames(ip, &scopeP->aliases, pattern, &namesObj[0])
+        != TCL_OK)
+        goto error_return;
+    Tcl_IncrRefCount(namesObj[0]);
+    if (CffiNameListNames(ip, &scopeP->enums, pattern, &namesObj[1])
+        != TCL_OK)
+        goto error_return;
+    Tcl_IncrRefCount(namesObj[1]);
+    if (CffiNameListNames(ip, &scopeP->prototypes, pattern, &namesObj[2])
+        != TCL_OK)
+        goto error_return;
+    Tcl_IncrRefCount(namesObj[2]);
+
+    wr.ipCtxP = ipCtxP;
+    wr.nStrings = 0;
+    wr.nStructs = 0;
+    Tcl_DStringInit(&wr.strings);
+    Tcl_DStringInit(&wr.structs);
+    Tcl_DStringInit(&wr.body);
+    Tcl_InitHashTable(&wr.stringIds, TCL_STRING_KEYS);
+    Tcl_InitHashTable(&wr.structIds, TCL_ONE_WORD_KEYS);
+
+    for (i = 0; i < nStructObjs; ++i)
+        (void)CffiImageAddStruct(&wr, structPtrs[i]);
+
+    /* Aliases */
+    Tcl_ListObjGetElements(NULL, namesObj[0], &nNames, &nameObjs);
+    CffiImagePutInt(&wr.body, (int)nNames);
+    for (i = 0; i < nNames; ++i) {
+        CffiTypeAndAttrs *typeAttrsP;
+        Tclh_HashLookup(&scopeP->aliases,
+                        Tcl_GetString(nameObjs[i]),
+                        (ClientData *)&typeAttrsP);
+        CffiImageAddTypeStructs(&wr, typeAttrsP);
+        CffiImagePutString(&wr, &wr.body, nameObjs[i]);
+        CffiImagePutTypeAndAttrs(&wr, &wr.body, typeAttrsP);
+    }
+
+    /* Enums */
+    Tcl_ListObjGetElements(NULL, namesObj[1], &nNames, &nameObjs);
+    CffiImagePutInt(&wr.body, (int)nNames);
+    for (i = 0; i < nNames; ++i) {
+        Tcl_Obj *membersObj;
+        Tclh_HashLookup(&scopeP->enums,
+                        Tcl_GetString(nameObjs[i]),
+                        (ClientData *)&membersObj);
+        CffiImagePutString(&wr, &wr.body, nameObjs[i]);
+        CffiImagePutString(&wr, &wr.body, membersObj);
+    }
+
+    /* Prototypes */
+    Tcl_ListObjGetElements(NULL, namesObj[2], &nNames, &nameObjs);
+    CffiImagePutInt(&wr.body, (int)nNames);
+    for (i = 0; i < nNames; ++i) {
+        CffiProto *protoP;
+        Tclh_HashLookup(&scopeP->prototypes,
+                        Tcl_GetString(nameObjs[i]),
+                        (ClientData *)&protoP);
+        CffiImageAddTypeStructs(&wr, &protoP->returnType.typeAttrs);
+        for (j = 0; j < protoP->nParams; ++j)
+            CffiImageAddTypeStructs(&wr, &protoP->params[j].typeAttrs);
+        CffiImagePutProto(&wr, nameObjs[i], protoP);
+    }
+
+    CffiImageAssemble(&wr, imageP);
+
+    Tcl_DStringFree(&wr.strings);
+    Tcl_DStringFree(&wr.structs);
+    Tcl_DStringFree(&wr.body);
+    Tcl_DeleteHashTable(&wr.stringIds);
+    Tcl_DeleteHashTable(&wr.structIds);
+    for (i = 0; i < 3; ++i)
+        Tcl_DecrRefCount(namesObj[i]);
+    if (structPtrs)
+        ckfree(structPtrs);
+    return TCL_OK;
+
+error_return:
+    for (i = 0; i < 3; ++i) {
+        if (namesObj[i])
+            Tcl_DecrRefCount(namesObj[i]);
+    }
+    if (structPtrs)
+        ckfree(structPtrs);
+    return TCL_ERROR;
+}
+
+/* Function: CffiImageSaveCmd
+ * Implements the *image save* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image save FILENAME ?-pattern PATTERN? ?-structs STRUCTLIST?*
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageSaveCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    Tcl_DString image;
+    Tcl_Channel chan;
+    int ok;
+
+    CHECK(CffiImageBuild(ipCtxP, objc, objv, &image));
+
+    chan = Tcl_FSOpenFileChannel(ip, objv[2], "w", 0666);
+    if (chan == NULL) {
+        Tcl_DStringFree(&image);
+        return TCL_ERROR;
+    }
+    ok = Tcl_SetChannelOption(ip, chan, "-translation", "binary") == TCL_OK
+      && Tcl_Write(chan, Tcl_DStringValue(&image), Tcl_DStringLength(&image)) >= 0;
+    Tcl_DStringFree(&image);
+    if (!ok) {
+        int err = Tcl_GetErrno();
+        Tcl_Close(NULL, chan);
+        return Tclh_ErrorErrnoError(ip, err, NULL);
+    }
+    return Tcl_Close(ip, chan);
+}
+
+static CffiResult
+CffiImageErrorCorrupt(CffiImageReader *rdP)
+{
+    return Tclh_ErrorInvalidValue(rdP->ipCtxP->interp,
+                                  rdP->sourceObj,
+                                  "Image file is truncated or corrupt.");
+}
+
+static CffiResult
+CffiImageGetInt(CffiImageReader *rdP, int *valueP)
+{
+    if ((rdP->end - rdP->p) < (ptrdiff_t)sizeof(int))
+        return CffiImageErrorCorrupt(rdP);
+    memcpy(valueP, rdP->p, sizeof(int));
+    rdP->p += sizeof(int);
+    return TCL_OK;
+}
+
+/* Function: CffiImageGetString
+ * Reads a string table reference from an image.
+ *
+ * Parameters:
+ * rdP - image reader state
+ * objPP - location to store the string. *NULL* is stored for a NULL string
+ *   reference. The reference count is not incremented.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageGetString(CffiImageReader *rdP, Tcl_Obj **objPP)
+{
+    int index;
+    CHECK(CffiImageGetInt(rdP, &index));
+    if (index == -1) {
+        *objPP = NULL;
+        return TCL_OK;
+    }
+    if (index < 0 || index >= rdP->nStrings)
+        return CffiImageErrorCorrupt(rdP);
+    *objPP = rdP->strings[index];
+    return TCL_OK;
+}
+
+/* Like CffiImageGetString but NULL references are treated as corruption */
+static CffiResult
+CffiImageGetName(CffiImageReader *rdP, Tcl_Obj **objPP)
+{
+    CHECK(CffiImageGetString(rdP, objPP));
+    if (*objPP == NULL || !Tclh_NsIsFQN(Tcl_GetString(*objPP)))
+        return CffiImageErrorCorrupt(rdP);
+    return TCL_OK;
+}
+
+/* Function: CffiImageGetTypeAndAttrs
+ * Reads a type descriptor from an image.
+ *
+ * Parameters:
+ * rdP - image reader state
+ * typeAttrsP - descriptor to initialize. On return it is always in a
+ *   consistent state and must be cleaned up by the caller with
+ *   <CffiTypeAndAttrsCleanup> even on errors.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageGetTypeAndAttrs(CffiImageReader *rdP, CffiTypeAndAttrs *typeAttrsP)
+{
+    CffiType *typeP = &typeAttrsP->dataType;
+    int baseType, arraySize, baseTypeSize, typeFlags, attrFlags, ref;
+    Tcl_Obj *objP;
+
+    CffiTypeAndAttrsInit(typeAttrsP, NULL);
+
+    CHECK(CffiImageGetInt(rdP, &baseType));
+    CHECK(CffiImageGetInt(rdP, &arraySize));
+    CHECK(CffiImageGetInt(rdP, &baseTypeSize));
+    CHECK(CffiImageGetInt(rdP, &typeFlags));
+    CHECK(CffiImageGetInt(rdP, &attrFlags));
+    if (baseType < 0 || baseType >= CFFI_K_NUM_TYPES || arraySize < -1)
+        return CffiImageErrorCorrupt(rdP);
+    /* Set before any resources are attached so the caller's cleanup frees them */
+    typeP->baseType = baseType;
+
+    switch (baseType) {
+    case CFFI_K_TYPE_STRUCT:
+        CHECK(CffiImageGetInt(rdP, &ref));
+        if (ref < 0 || ref >= rdP->nStructs)
+            return CffiImageErrorCorrupt(rdP);
+        typeP->u.structP = rdP->structs[ref];
+        CffiStructRef(typeP->u.structP);
+        if (baseTypeSize != typeP->u.structP->size)
+            return CffiImageErrorCorrupt(rdP);
+        break;
+    case CFFI_K_TYPE_ASTRING:
+    case CFFI_K_TYPE_CHAR_ARRAY:
+        CHECK(CffiImageGetString(rdP, &objP));
+        if (objP) {
+            typeP->u.encoding =
+                Tcl_GetEncoding(rdP->ipCtxP->interp, Tcl_GetString(objP));
+            if (typeP->u.encoding == NULL)
+                return TCL_ERROR;
+        }
+        break;
+    case CFFI_K_TYPE_POINTER:
+        CHECK(CffiImageGetString(rdP, &objP));
+        if (objP) {
+            typeP->u.tagNameObj = CffiMakePointerTagFromObj(rdP->ipCtxP, objP);
+            Tcl_IncrRefCount(typeP->u.tagNameObj);
+        }
+        break;
+    default:
+        CHECK(CffiImageGetString(rdP, &objP));
+        if (objP) {
+            /* Enum member dictionary */
+            Tcl_IncrRefCount(objP);
+            typeP->u.tagNameObj = objP;
+        }
+        break;
+    }
+    if (baseType != CFFI_K_TYPE_STRUCT
+        && baseTypeSize != cffiBaseTypes[baseType].size)
+        return CffiImageErrorCorrupt(rdP);
+    if (arraySize > 0 && baseTypeSize > 0
+        && arraySize > INT_MAX / baseTypeSize)
+        return CffiImageErrorCorrupt(rdP);
+    typeP->arraySize    = arraySize;
+    typeP->baseTypeSize = baseTypeSize;
+    typeP->flags        = typeFlags;
+    typeAttrsP->flags   = attrFlags;
+
+    CHECK(CffiImageGetString(rdP, &objP));
+    if (objP) {
+        Tcl_IncrRefCount(objP);
+        typeP->countHolderObj = objP;
+    }
+    CHECK(CffiImageGetString(rdP, &objP));
+    if (objP) {
+        Tcl_IncrRefCount(objP);
+        typeAttrsP->parseModeSpecificObj = objP;
+    }
+    return TCL_OK;
+}
+
+/* Function: CffiImageCheckStructLayout
+ * Verifies the layout of a struct read from an image.
+ *
+ * Parameters:
+ * rdP - image reader state
+ * structP - struct descriptor with all fields read
+ *
+ * Field offsets and sizes stored in the image are used as is when
+ * accessing native memory so they are checked against the field types
+ * and the struct size.
+ *
+ * Returns:
+ * *TCL_OK* if the layout is consistent, *TCL_ERROR* on failure with error
+ * in interpreter.
+ */
+static CffiResult
+CffiImageCheckStructLayout(CffiImageReader *rdP, const CffiStruct *structP)
+{
+    int isUnion = CffiStructIsUnion(structP);
+    int nFields = structP->nFields;
+    const CffiType *lastTypeP = &structP->fields[nFields - 1].fieldType.dataType;
+    int i;
+
+    if (structP->size <= 0
+        || (structP->alignment & (structP->alignment - 1)) != 0
+        || (structP->size % structP->alignment) != 0)
+        return CffiImageErrorCorrupt(rdP);
+
+    for (i = 0; i < nFields; ++i) {
+        const CffiField *fieldP = &structP->fields[i];
+        const CffiType *typeP   = &fieldP->fieldType.dataType;
+        int fieldSize, fieldAlignment;
+
+        if (typeP->baseType == CFFI_K_TYPE_VOID)
+            return CffiImageErrorCorrupt(rdP);
+        if (CffiTypeIsVariableSize(typeP)) {
+            /* Only the last field of a struct may be variable size */
+            if (isUnion || i != nFields - 1 || nFields == 1)
+                return CffiImageErrorCorrupt(rdP);
+            if (CffiTypeIsVLA(typeP) && typeP->baseType == CFFI_K_TYPE_STRUCT
+                && CffiStructIsVariableSize(typeP->u.structP))
+                return CffiImageErrorCorrupt(rdP);
+        }
+        if (fieldP->fieldType.flags & CFFI_F_ATTR_STRUCTSIZE) {
+            if (i != structP->structSizeFieldIndex
+                || !CffiTypeIsNotArray(typeP)
+                || !CffiTypeIsInteger(typeP->baseType))
+                return CffiImageErrorCorrupt(rdP);
+        }
+        CffiTypeLayoutInfo(
+            rdP->ipCtxP, typeP, 0, NULL, &fieldSize, &fieldAlignment);
+        if (structP->pack && structP->pack < fieldAlignment)
+            fieldAlignment = structP->pack;
+        if (fieldP->size != (unsigned int)fieldSize
+            || fieldAlignment > structP->alignment
+            || (fieldP->offset % (unsigned int)fieldAlignment) != 0
+            || (isUnion && fieldP->offset != 0)
+            || (Tcl_WideInt)fieldP->offset + fieldSize > structP->size)
+            return CffiImageErrorCorrupt(rdP);
+    }
+
+    if (structP->structSizeFieldIndex >= 0
+        && !(structP->fields[structP->structSizeFieldIndex].fieldType.flags
+             & CFFI_F_ATTR_STRUCTSIZE))
+        return CffiImageErrorCorrupt(rdP);
+
+    if (CffiTypeIsVariableSize(lastTypeP)) {
+        if (!(structP->flags & CFFI_F_STRUCT_VARSIZE)
+            || structP->structSizeFieldIndex >= 0)
+            return CffiImageErrorCorrupt(rdP);
+    }
+    else if (structP->flags & CFFI_F_STRUCT_VARSIZE)
+        return CffiImageErrorCorrupt(rdP);
+
+    if (CffiTypeIsVLA(lastTypeP)) {
+        /* Dynamic count must be held in a preceding scalar integer field */
+        const CffiType *countTypeP;
+        if (structP->dynamicCountFieldIndex < 0
+            || structP->dynamicCountFieldIndex >= nFields - 1)
+            return CffiImageErrorCorrupt(rdP);
+        countTypeP =
+            &structP->fields[structP->dynamicCountFieldIndex].fieldType.dataType;
+        if (!CffiTypeIsNotArray(countTypeP)
+            || !CffiTypeIsInteger(countTypeP->baseType))
+            return CffiImageErrorCorrupt(rdP);
+    }
+    else if (structP->dynamicCountFieldIndex >= 0)
+        return CffiImageErrorCorrupt(rdP);
+
+    return TCL_OK;
+}
+
+/* Function: CffiImageGetStruct
+ * Reads a struct record from an image.
+ *
+ * Parameters:
+ * rdP - image reader state
+ * structPP - location to store the struct descriptor. Its reference
+ *   count is 0.
+ *
+ * The field layout is taken as stored in the image and not recomputed
+ * but is verified with <CffiImageCheckStructLayout>.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageGetStruct(CffiImageReader *rdP, CffiStruct **structPP)
+{
+    CffiStruct *structP;
+    Tcl_Obj *nameObj;
+    int size, alignment, pack, flags, sizeIndex, countIndex, nFields, i;
+
+    CHECK(CffiImageGetName(rdP, &nameObj));
+    CHECK(CffiImageGetInt(rdP, &size));
+    CHECK(CffiImageGetInt(rdP, &alignment));
+    CHECK(CffiImageGetInt(rdP, &pack));
+    CHECK(CffiImageGetInt(rdP, &flags));
+    CHECK(CffiImageGetInt(rdP, &sizeIndex));
+    CHECK(CffiImageGetInt(rdP, &countIndex));
+    CHECK(CffiImageGetInt(rdP, &nFields));
+    /* Each field takes at least 11 integers. Guards against huge allocs */
+    if (size < 0 || alignment <= 0 || alignment > 255 || pack < 0
+        || pack > 255 || nFields <= 0
+        || nFields > (rdP->end - rdP->p) / (11 * (ptrdiff_t)sizeof(int))
+        || sizeIndex < -1 || sizeIndex >= nFields || countIndex < -1
+        || countIndex >= nFields) {
+        return CffiImageErrorCorrupt(rdP);
+    }
+
+    structP = CffiStructCkalloc(nFields);
+    Tcl_IncrRefCount(nameObj);
+    structP->name                   = nameObj;
+    structP->size                   = size;
+    structP->alignment              = (unsigned char)alignment;
+    structP->pack                   = (unsigned char)pack;
+    structP->flags                  = flags;
+    structP->structSizeFieldIndex   = sizeIndex;
+    structP->dynamicCountFieldIndex = countIndex;
+    structP->nFields                = 0; /* Updated as we go for cleanup */
+
+    for (i = 0; i < nFields; ++i) {
+        CffiField *fieldP = &structP->fields[i];
+        Tcl_Obj *fieldNameObj;
+        int offset, fieldSize;
+        CffiResult ret;
+
+        if (CffiImageGetString(rdP, &fieldNameObj) != TCL_OK
+            || CffiImageGetInt(rdP, &offset) != TCL_OK
+            || CffiImageGetInt(rdP, &fieldSize) != TCL_OK) {
+            CffiStructUnref(structP);
+            return TCL_ERROR;
+        }
+        if (fieldNameObj == NULL || offset < 0 || fieldSize < 0) {
+            CffiStructUnref(structP);
+            return CffiImageErrorCorrupt(rdP);
+        }
+        Tcl_IncrRefCount(fieldNameObj);
+        fieldP->nameObj = fieldNameObj;
+        fieldP->offset  = offset;
+        fieldP->size    = fieldSize;
+        ret = CffiImageGetTypeAndAttrs(rdP, &fieldP->fieldType);
+        structP->nFields += 1;
+        if (ret != TCL_OK) {
+            CffiStructUnref(structP);
+            return TCL_ERROR;
+        }
+        if (!CffiStructAddFieldIndex(structP, i)) {
+            CffiStructUnref(structP);
+            return CffiImageErrorCorrupt(rdP);
+        }
+    }
+    if (CffiImageCheckStructLayout(rdP, structP) != TCL_OK) {
+        CffiStructUnref(structP);
+        return TCL_ERROR;
+    }
+    *structPP = structP;
+    return TCL_OK;
+}
+
+/* Function: CffiImageGetProto
+ * Reads a prototype record from an image.
+ *
+ * Parameters:
+ * rdP - image reader state
+ * nameObjP - location to store the prototype name
+ * protoPP - location to store the prototype. Its reference count is 0.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageGetProto(CffiImageReader *rdP, Tcl_Obj **nameObjP, CffiProto **protoPP)
+{
+    CffiProto *protoP;
+    Tcl_Obj *nameObj;
+    int abi, flags, nParams, i;
+
+    CHECK(CffiImageGetName(rdP, &nameObj));
+    CHECK(CffiImageGetInt(rdP, &abi));
+    CHECK(CffiImageGetInt(rdP, &flags));
+    CHECK(CffiImageGetInt(rdP, &nParams));
+    if (nParams < 0
+        || nParams > (rdP->end - rdP->p) / (10 * (ptrdiff_t)sizeof(int)))
+        return CffiImageErrorCorrupt(rdP);
+
+    protoP        = CffiProtoAllocate(nParams);
+    protoP->abi   = (CffiABIProtocol)abi;
+    protoP->flags = flags;
+    Tcl_IncrRefCount(nameObj);
+    protoP->returnType.nameObj = nameObj;
+    if (CffiImageGetTypeAndAttrs(rdP, &protoP->returnType.typeAttrs)
+        != TCL_OK) {
+        CffiProtoUnref(protoP);
+        return TCL_ERROR;
+    }
+    for (i = 0; i < nParams; ++i) {
+        CffiParam *paramP = &protoP->params[i];
+        Tcl_Obj *paramNameObj;
+        CffiResult ret;
+        if (CffiImageGetString(rdP, &paramNameObj) != TCL_OK
+            || CffiImageGetInt(rdP, &paramP->arraySizeParamIndex) != TCL_OK) {
+            CffiProtoUnref(protoP);
+            return TCL_ERROR;
+        }
+        if (paramNameObj == NULL || paramP->arraySizeParamIndex < 0
+            || paramP->arraySizeParamIndex >= nParams) {
+            CffiProtoUnref(protoP);
+            return CffiImageErrorCorrupt(rdP);
+        }
+        Tcl_IncrRefCount(paramNameObj);
+        paramP->nameObj = paramNameObj;
+        ret = CffiImageGetTypeAndAttrs(rdP, &paramP->typeAttrs);
+        protoP->nParams += 1; /* Update incrementally for cleanup */
+        if (ret != TCL_OK) {
+            CffiProtoUnref(protoP);
+            return TCL_ERROR;
+        }
+    }
+    CffiCallPlanInit(protoP);
+    *nameObjP = nameObj;
+    *protoPP  = protoP;
+    return TCL_OK;
+}
+
+/* Returns 1 if the two type descriptors have the same definition */
+static int
+CffiImageTypeAndAttrsMatch(const CffiTypeAndAttrs *aP,
+                           const CffiTypeAndAttrs *bP)
+{
+    Tcl_Obj *aObj = CffiTypeAndAttrsUnparse(aP);
+    Tcl_Obj *bObj = CffiTypeAndAttrsUnparse(bP);
+    int match     = !strcmp(Tcl_GetString(aObj), Tcl_GetString(bObj));
+    Tcl_DecrRefCount(aObj);
+    Tcl_DecrRefCount(bObj);
+    return match;
+}
+
+/* Returns 1 if the two struct descriptors have the same layout */
+static int
+CffiImageStructMatch(const CffiStruct *aP, const CffiStruct *bP)
+{
+    int i;
+    if (aP->size != bP->size || aP->alignment != bP->alignment
+        || aP->pack != bP->pack || aP->flags != bP->flags
+        || aP->nFields != bP->nFields)
+        return 0;
+    for (i = 0; i < aP->nFields; ++i) {
+        const CffiField *aFieldP = &aP->fields[i];
+        const CffiField *bFieldP = &bP->fields[i];
+        if (aFieldP->offset != bFieldP->offset
+            || aFieldP->size != bFieldP->size
+            || strcmp(Tcl_GetString(aFieldP->nameObj),
+                      Tcl_GetString(bFieldP->nameObj))
+            || !CffiImageTypeAndAttrsMatch(&aFieldP->fieldType,
+                                           &bFieldP->fieldType))
+            return 0;
+    }
+    return 1;
+}
+
+/* Returns 1 if the two prototypes have the same definition */
+static int
+CffiImageProtoMatch(const CffiProto *aP, const CffiProto *bP)
+{
+    int i;
+    if (aP->abi != bP->abi || aP->flags != bP->flags
+        || aP->nParams != bP->nParams
+        || !CffiImageTypeAndAttrsMatch(&aP->returnType.typeAttrs,
+                                       &bP->returnType.typeAttrs))
+        return 0;
+    for (i = 0; i < aP->nParams; ++i) {
+        if (strcmp(Tcl_GetString(aP->params[i].nameObj),
+                   Tcl_GetString(bP->params[i].nameObj))
+            || !CffiImageTypeAndAttrsMatch(&aP->params[i].typeAttrs,
+                                           &bP->params[i].typeAttrs))
+            return 0;
+    }
+    return 1;
+}
+
+/* Function: CffiImageCheckHeader
+ * Verifies an image header is compatible with the running process.
+ *
+ * Parameters:
+ * rdP - image reader state positioned at the start of the image
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageCheckHeader(CffiImageReader *rdP)
+{
+    Tcl_Interp *ip = rdP->ipCtxP->interp;
+    int version, byteOrder, pointerSize, longSize, backend, abi, nTypes;
+
+    if ((rdP->end - rdP->p) < (ptrdiff_t)sizeof(CFFI_IMAGE_MAGIC)
+        || memcmp(rdP->p, CFFI_IMAGE_MAGIC, sizeof(CFFI_IMAGE_MAGIC))) {
+        return Tclh_ErrorInvalidValue(
+            ip, rdP->sourceObj, "File is not a cffi image.");
+    }
+    rdP->p += sizeof(CFFI_IMAGE_MAGIC);
+    CHECK(CffiImageGetInt(rdP, &version));
+    if (version != CFFI_IMAGE_VERSION) {
+        return Tclh_ErrorInvalidValue(
+            ip, rdP->sourceObj, "Unsupported image format version.");
+    }
+    CHECK(CffiImageGetInt(rdP, &byteOrder));
+    CHECK(CffiImageGetInt(rdP, &pointerSize));
+    CHECK(CffiImageGetInt(rdP, &longSize));
+    CHECK(CffiImageGetInt(rdP, &backend));
+    CHECK(CffiImageGetInt(rdP, &abi));
+    CHECK(CffiImageGetInt(rdP, &nTypes));
+    if (byteOrder != CFFI_IMAGE_BYTEORDER || pointerSize != sizeof(void *)
+        || longSize != sizeof(long) || backend != CFFI_IMAGE_BACKEND
+        || abi != (int)CffiDefaultABI() || nTypes != CFFI_K_NUM_TYPES) {
+        return Tclh_ErrorInvalidValue(
+            ip,
+            rdP->sourceObj,
+            "Image was created for a different platform, ABI or cffi build.");
+    }
+    return TCL_OK;
+}
+
+/* Function: CffiImageLoad
+ * Defines the contents of an image in an interpreter.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * sourceObj - file or shared image name used in error messages
+ * bytes - image contents
+ * nbytes - size of image
+ *
+ * The whole image is decoded and checked against existing definitions
+ * before anything is registered so a failure leaves the interpreter
+ * definitions unchanged. Existing definitions identical to those in the
+ * image are retained.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageLoad(CffiInterpCtx *ipCtxP,
+              Tcl_Obj *sourceObj,
+              const unsigned char *bytes,
+              Tcl_Size nbytes)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiScope *scopeP = &ipCtxP->scope;
+    CffiImageReader rd;
+    CffiResult ret = TCL_ERROR;
+    int i, n;
+    int nAliases = 0, nEnums = 0, nProtos = 0;
+    char *newStructs = NULL;   /* Whether struct commands are to be created */
+    Tcl_Obj **aliasNames = NULL;
+    CffiTypeAndAttrs **aliases = NULL;
+    Tcl_Obj **enumNames = NULL;
+    Tcl_Obj **enums = NULL;
+    Tcl_Obj **protoNames = NULL;
+    CffiProto **protos = NULL;
+    ClientData existing;
+
+    rd.ipCtxP   = ipCtxP;
+    rd.sourceObj = sourceObj;
+    rd.p        = bytes;
+    rd.end      = bytes + nbytes;
+    rd.strings  = NULL;
+    rd.nStrings = 0;
+    rd.structs  = NULL;
+    rd.nStructs = 0;
+
+    if (CffiImageCheckHeader(&rd) != TCL_OK
+        || CffiImageGetInt(&rd, &n) != TCL_OK)
+        goto vamoose;
+
+    /* String table. Each entry is at least one integer */
+    if (n < 0 || n > (rd.end - rd.p) / (ptrdiff_t)sizeof(int)) {
+        CffiImageErrorCorrupt(&rd);
+        goto vamoose;
+    }
+    rd.strings = ckalloc(n * sizeof(Tcl_Obj *) + 1);
+    for (i = 0; i < n; ++i) {
+        int len;
+        if (CffiImageGetInt(&rd, &len) != TCL_OK)
+            goto vamoose;
+        if (len < 0 || len > (rd.end - rd.p)) {
+            CffiImageErrorCorrupt(&rd);
+            goto vamoose;
+        }
+        rd.strings[i] = Tcl_NewStringObj((const char *)rd.p, len);
+        Tcl_IncrRefCount(rd.strings[i]);
+        rd.nStrings += 1;
+        rd.p += len;
+    }
+
+    /* Struct table. Nested structs precede their containers */
+    if (CffiImageGetInt(&rd, &n) != TCL_OK)
+        goto vamoose;
+    if (n < 0 || n > (rd.end - rd.p) / (ptrdiff_t)sizeof(int)) {
+        CffiImageErrorCorrupt(&rd);
+        goto vamoose;
+    }
+    rd.structs = ckalloc(n * sizeof(CffiStruct *) + 1);
+    newStructs = ckalloc(n + 1);
+    for (i = 0; i < n; ++i) {
+        CffiStruct *structP;
+        CffiStruct *oldP;
+        const char *name;
+        Tcl_CmdInfo tci;
+        if (CffiImageGetStruct(&rd, &structP) != TCL_OK)
+            goto vamoose;
+        name = Tcl_GetString(structP->name);
+        newStructs[i] = 1;
+        if (Tcl_GetCommandInfo(ip, name, &tci)) {
+            if (CffiStructResolve(ip,
+                                  name,
+                                  CffiStructIsUnion(structP)
+                                      ? CFFI_K_TYPE_UNION
+                                      : CFFI_K_TYPE_STRUCT,
+                                  &oldP)
+                    != TCL_OK
+                || !CffiImageStructMatch(oldP, structP)) {
+                /* Name is held by the string table so safe after unref */
+                Tcl_Obj *nameObj = structP->name;
+                CffiStructUnref(structP);
+                Tclh_ErrorExists(ip,
+                                 "Command",
+                                 nameObj,
+                                 "A command of the same name but different "
+                                 "definition exists.");
+                goto vamoose;
+            }
+            /* Identical definition. Use existing one */
+            CffiStructUnref(structP);
+            structP = oldP;
+            newStructs[i] = 0;
+        }
+        CffiStructRef(structP);
+        rd.structs[i] = structP;
+        rd.nStructs += 1;
+    }
+
+    /* Aliases */
+    if (CffiImageGetInt(&rd, &n) != TCL_OK)
+        goto vamoose;
+    if (n < 0 || n > (rd.end - rd.p) / (ptrdiff_t)sizeof(int)) {
+        CffiImageErrorCorrupt(&rd);
+        goto vamoose;
+    }
+    aliasNames = ckalloc(n * sizeof(Tcl_Obj *) + 1);
+    aliases    = ckalloc(n * sizeof(CffiTypeAndAttrs *) + 1);
+    for (i = 0; i < n; ++i) {
+        CffiTypeAndAttrs *typeAttrsP;
+        if (CffiImageGetName(&rd, &aliasNames[i]) != TCL_OK)
+            goto vamoose;
+        typeAttrsP = ckalloc(sizeof(*typeAttrsP));
+        aliases[i] = typeAttrsP;
+        nAliases += 1;
+        if (CffiImageGetTypeAndAttrs(&rd, typeAttrsP) != TCL_OK)
+            goto vamoose;
+        if (Tclh_HashLookup(&scopeP->aliases,
+                            Tcl_GetString(aliasNames[i]),
+                            &existing)
+            == TCL_OK) {
+            if (!CffiImageTypeAndAttrsMatch((CffiTypeAndAttrs *)existing,
+                                            typeAttrsP)) {
+                Tclh_ErrorExists(ip,
+                                 "Alias",
+                                 aliasNames[i],
+                                 "Alias exists with a different definition.");
+                goto vamoose;
+            }
+            CffiTypeAndAttrsCleanup(typeAttrsP);
+            ckfree(typeAttrsP);
+            aliases[i] = NULL;
+        }
+    }
+
+    /* Enums */
+    if (CffiImageGetInt(&rd, &n) != TCL_OK)
+        goto vamoose;
+    if (n < 0 || n > (rd.end - rd.p) / (ptrdiff_t)sizeof(int)) {
+        CffiImageErrorCorrupt(&rd);
+        goto vamoose;
+    }
+    enumNames = ckalloc(n * sizeof(Tcl_Obj *) + 1);
+    enums     = ckalloc(n * sizeof(Tcl_Obj *) + 1);
+    for (i = 0; i < n; ++i) {
+        if (CffiImageGetName(&rd, &enumNames[i]) != TCL_OK
+            || CffiImageGetString(&rd, &enums[i]) != TCL_OK)
+            goto vamoose;
+        if (enums[i] == NULL) {
+            CffiImageErrorCorrupt(&rd);
+            goto vamoose;
+        }
+        nEnums += 1;
+        if (Tclh_HashLookup(&scopeP->enums,
+                            Tcl_GetString(enumNames[i]),
+                            &existing)
+            == TCL_OK) {
+            if (strcmp(Tcl_GetString((Tcl_Obj *)existing),
+                       Tcl_GetString(enums[i]))) {
+                Tclh_ErrorExists(ip,
+                                 "Enum",
+                                 enumNames[i],
+                                 "Enum exists with a different definition.");
+                goto vamoose;
+            }
+            enums[i] = NULL;
+        }
+    }
+
+    /* Prototypes */
+    if (CffiImageGetInt(&rd, &n) != TCL_OK)
+        goto vamoose;
+    if (n < 0 || n > (rd.end - rd.p) / (ptrdiff_t)sizeof(int)) {
+        CffiImageErrorCorrupt(&rd);
+        goto vamoose;
+    }
+    protoNames = ckalloc(n * sizeof(Tcl_Obj *) + 1);
+    protos     = ckalloc(n * sizeof(CffiProto *) + 1);
+    for (i = 0; i < n; ++i) {
+        if (CffiImageGetProto(&rd, &protoNames[i], &protos[i]) != TCL_OK)
+            goto vamoose;
+        CffiProtoRef(protos[i]);
+        nProtos += 1;
+        if (Tclh_HashLookup(&scopeP->prototypes,
+                            Tcl_GetString(protoNames[i]),
+                            &existing)
+            == TCL_OK) {
+            if (!CffiImageProtoMatch((CffiProto *)existing, protos[i])) {
+                Tclh_ErrorExists(
+                    ip,
+                    "Prototype",
+                    protoNames[i],
+                    "Prototype exists with a different definition.");
+                goto vamoose;
+            }
+            CffiProtoUnref(protos[i]);
+            protos[i] = NULL;
+        }
+    }
+
+    if (rd.p != rd.end) {
+        CffiImageErrorCorrupt(&rd);
+        goto vamoose;
+    }
+
+    /*
+     * Everything decoded and checked. Register the definitions. Ownership
+     * passes to the name tables and struct commands.
+     */
+    for (i = 0; i < rd.nStructs; ++i) {
+        if (newStructs[i])
+            CffiStructCreateCommand(ipCtxP, rd.structs[i]->name, rd.structs[i]);
+    }
+    for (i = 0; i < nAliases; ++i) {
+        if (aliases[i]) {
+            CffiNameObjAdd(
+                ip, &scopeP->aliases, aliasNames[i], "Alias", aliases[i], NULL);
+            aliases[i] = NULL;
+        }
+    }
+    for (i = 0; i < nEnums; ++i) {
+        if (enums[i]) {
+            CffiNameObjAdd(
+                ip, &scopeP->enums, enumNames[i], "Enum", enums[i], NULL);
+            Tcl_IncrRefCount(enums[i]);
+        }
+    }
+    for (i = 0; i < nProtos; ++i) {
+        if (protos[i]) {
+            CffiNameObjAdd(ip,
+                           &scopeP->prototypes,
+                           protoNames[i],
+                           "Prototype",
+                           protos[i],
+                           NULL);
+            protos[i] = NULL;
+        }
+    }
+    CffiDefinitionsChanged(ipCtxP);
+    Tcl_ResetResult(ip);
+    ret = TCL_OK;
+
+vamoose:
+    for (i = 0; i < nAliases; ++i) {
+        if (aliases[i]) {
+            CffiTypeAndAttrsCleanup(aliases[i]);
+            ckfree(aliases[i]);
+        }
+    }
+    for (i = 0; i < nProtos; ++i) {
+        if (protos[i])
+            CffiProtoUnref(protos[i]);
+    }
+    for (i = 0; i < rd.nStructs; ++i)
+        CffiStructUnref(rd.structs[i]);
+    for (i = 0; i < rd.nStrings; ++i)
+        Tcl_DecrRefCount(rd.strings[i]);
+    if (rd.strings)
+        ckfree(rd.strings);
+    if (rd.structs)
+        ckfree(rd.structs);
+    if (newStructs)
+        ckfree(newStructs);
+    if (aliasNames)
+        ckfree(aliasNames);
+    if (aliases)
+        ckfree(aliases);
+    if (enumNames)
+        ckfree(enumNames);
+    if (enums)
+        ckfree(enums);
+    if (protoNames)
+        ckfree(protoNames);
+    if (protos)
+        ckfree(protos);
+    return ret;
+}
+
+/* Function: CffiImageLoadCmd
+ * Implements the *image load* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image load FILENAME*
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageLoadCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    Tcl_Channel chan;
+    Tcl_Obj *dataObj;
+    const unsigned char *bytes;
+    Tcl_Size nbytes;
+    CffiResult ret;
+
+    chan = Tcl_FSOpenFileChannel(ip, objv[2], "r", 0);
+    if (chan == NULL)
+        return TCL_ERROR;
+    if (Tcl_SetChannelOption(ip, chan, "-translation", "binary") != TCL_OK) {
+        Tcl_Close(NULL, chan);
+        return TCL_ERROR;
+    }
+    dataObj = Tcl_NewObj();
+    Tcl_IncrRefCount(dataObj);
+    if (Tcl_ReadChars(chan, dataObj, -1, 0) < 0) {
+        int err = Tcl_GetErrno();
+        Tcl_Close(NULL, chan);
+        Tcl_DecrRefCount(dataObj);
+        return Tclh_ErrorErrnoError(ip, err, NULL);
+    }
+    Tcl_Close(NULL, chan);
+
+    bytes = Tcl_GetByteArrayFromObj(dataObj, &nbytes);
+    ret   = CffiImageLoad(ipCtxP, objv[2], bytes, nbytes);
+    Tcl_DecrRefCount(dataObj);
+    return ret;
+}
+
+/*
+ * Process-wide registry of published images. Parsed descriptors hold
+ * Tcl_Obj references and so cannot be shared between threads. What is
+ * shared instead is the immutable image from which each interpreter
+ * instantiates its own descriptors without parsing. Entries are reference
+ * counted so an image may be withdrawn while other threads are loading it.
+ */
+typedef struct CffiSharedImage {
+    int nRefs;
+    Tcl_Size nbytes;
+    unsigned char bytes[1]; /* Actually nbytes in size */
+} CffiSharedImage;
+
+TCL_DECLARE_MUTEX(cffiSharedImagesLock)
+static Tcl_HashTable cffiSharedImages; /* name -> CffiSharedImage */
+static int cffiSharedImagesInitialized;
+
+/* Caller must hold cffiSharedImagesLock */
+static void
+CffiSharedImageUnref(CffiSharedImage *imageP)
+{
+    if (imageP->nRefs <= 1)
+        ckfree(imageP);
+    else
+        imageP->nRefs -= 1;
+}
+
+static void
+CffiSharedImagesFinalize(ClientData clientData)
+{
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+
+    Tcl_MutexLock(&cffiSharedImagesLock);
+    if (cffiSharedImagesInitialized) {
+        for (heP = Tcl_FirstHashEntry(&cffiSharedImages, &hSearch);
+             heP != NULL;
+             heP = Tcl_NextHashEntry(&hSearch)) {
+            CffiSharedImageUnref((CffiSharedImage *)Tcl_GetHashValue(heP));
+        }
+        Tcl_DeleteHashTable(&cffiSharedImages);
+        cffiSharedImagesInitialized = 0;
+    }
+    Tcl_MutexUnlock(&cffiSharedImagesLock);
+}
+
+/* Function: CffiImagePublishCmd
+ * Implements the *image publish* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image publish NAME ?-pattern PATTERN? ?-structs STRUCTLIST?*
+ *
+ * Publishing an image under an existing name is permitted only if the
+ * contents are identical.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImagePublishCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_DString image;
+    Tcl_HashEntry *heP;
+    CffiSharedImage *imageP;
+    Tcl_Size nbytes;
+    int isNew;
+    CffiResult ret = TCL_OK;
+
+    CHECK(CffiImageBuild(ipCtxP, objc, objv, &image));
+    nbytes = Tcl_DStringLength(&image);
+
+    Tcl_MutexLock(&cffiSharedImagesLock);
+    if (!cffiSharedImagesInitialized) {
+        Tcl_InitHashTable(&cffiSharedImages, TCL_STRING_KEYS);
+        Tcl_CreateExitHandler(CffiSharedImagesFinalize, NULL);
+        cffiSharedImagesInitialized = 1;
+    }
+    heP = Tcl_CreateHashEntry(&cffiSharedImages, Tcl_GetString(objv[2]), &isNew);
+    if (isNew) {
+        imageP = ckalloc(offsetof(CffiSharedImage, bytes) + nbytes);
+        imageP->nRefs  = 1;
+        imageP->nbytes = nbytes;
+        memcpy(imageP->bytes, Tcl_DStringValue(&image), nbytes);
+        Tcl_SetHashValue(heP, imageP);
+    }
+    else {
+        imageP = (CffiSharedImage *)Tcl_GetHashValue(heP);
+        if (imageP->nbytes != nbytes
+            || memcmp(imageP->bytes, Tcl_DStringValue(&image), nbytes)) {
+            ret = Tclh_ErrorExists(ipCtxP->interp,
+                                   "Image",
+                                   objv[2],
+                                   "Image exists with different contents.");
+        }
+    }
+    Tcl_MutexUnlock(&cffiSharedImagesLock);
+    Tcl_DStringFree(&image);
+    return ret;
+}
+
+/* Function: CffiImageAttachCmd
+ * Implements the *image attach* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image attach NAME*
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* on failure with error in interpreter.
+ */
+static CffiResult
+CffiImageAttachCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_HashEntry *heP;
+    CffiSharedImage *imageP = NULL;
+    CffiResult ret;
+
+    Tcl_MutexLock(&cffiSharedImagesLock);
+    if (cffiSharedImagesInitialized) {
+        heP = Tcl_FindHashEntry(&cffiSharedImages, Tcl_GetString(objv[2]));
+        if (heP) {
+            imageP = (CffiSharedImage *)Tcl_GetHashValue(heP);
+            imageP->nRefs += 1;
+        }
+    }
+    Tcl_MutexUnlock(&cffiSharedImagesLock);
+    if (imageP == NULL)
+        return Tclh_ErrorNotFound(ipCtxP->interp, "Image", objv[2], NULL);
+
+    /* Image contents are immutable so no lock needed while loading */
+    ret = CffiImageLoad(ipCtxP, objv[2], imageP->bytes, imageP->nbytes);
+
+    Tcl_MutexLock(&cffiSharedImagesLock);
+    CffiSharedImageUnref(imageP);
+    Tcl_MutexUnlock(&cffiSharedImagesLock);
+    return ret;
+}
+
+/* Function: CffiImageWithdrawCmd
+ * Implements the *image withdraw* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image withdraw NAME*
+ *
+ * Definitions already attached by interpreters are not affected. It is
+ * not an error if the image does not exist.
+ *
+ * Returns:
+ * *TCL_OK*.
+ */
+static CffiResult
+CffiImageWithdrawCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_HashEntry *heP;
+
+    Tcl_MutexLock(&cffiSharedImagesLock);
+    if (cffiSharedImagesInitialized) {
+        heP = Tcl_FindHashEntry(&cffiSharedImages, Tcl_GetString(objv[2]));
+        if (heP) {
+            CffiSharedImageUnref((CffiSharedImage *)Tcl_GetHashValue(heP));
+            Tcl_DeleteHashEntry(heP);
+        }
+    }
+    Tcl_MutexUnlock(&cffiSharedImagesLock);
+    return TCL_OK;
+}
+
+/* Function: CffiImagePublishedCmd
+ * Implements the *image published* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments
+ * objv - *image published ?PATTERN?*
+ *
+ * Returns:
+ * *TCL_OK* with the list of published image names matching *PATTERN*
+ * in the interpreter result.
+ */
+static CffiResult
+CffiImagePublishedCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+    Tcl_Obj *resultObj = Tcl_NewListObj(0, NULL);
+    const char *pattern = objc > 2 ? Tcl_GetString(objv[2]) : NULL;
+
+    Tcl_MutexLock(&cffiSharedImagesLock);
+    if (cffiSharedImagesInitialized) {
+        for (heP = Tcl_FirstHashEntry(&cffiSharedImages, &hSearch);
+             heP != NULL;
+             heP = Tcl_NextHashEntry(&hSearch)) {
+            const char *name = Tcl_GetHashKey(&cffiSharedImages, heP);
+            if (pattern == NULL || Tcl_StringMatch(name, pattern)) {
+                Tcl_ListObjAppendElement(
+                    NULL, resultObj, Tcl_NewStringObj(name, -1));
+            }
+        }
+    }
+    Tcl_MutexUnlock(&cffiSharedImagesLock);
+    Tcl_SetObjResult(ipCtxP->interp, resultObj);
+    return TCL_OK;
+}
+
+CffiResult
+CffiImageObjCmd(ClientData cdata,
+                Tcl_Interp *ip,
+                int objc,
+                Tcl_Obj *const objv[])
+{
+    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
+    int cmdIndex;
+    static const Tclh_SubCommand subCommands[] = {
+        {"attach", 1, 1, "NAME", CffiImageAttachCmd},
+        {"load", 1, 1, "FILENAME", CffiImageLoadCmd},
+        {"publish", 1, 5, "NAME ?-pattern PATTERN? ?-structs STRUCTLIST?", CffiImagePublishCmd},
+        {"published", 0, 1, "?PATTERN?", CffiImagePublishedCmd},
+        {"save", 1, 5, "FILENAME ?-pattern PATTERN? ?-structs STRUCTLIST?", CffiImageSaveCmd},
+        {"withdraw", 1, 1, "NAME", CffiImageWithdrawCmd},
+        {NULL}};
+
+    CHECK(Tclh_SubCommandLookup(ip, subCommands, objc, objv, &cmdIndex));
+    return subCommands[cmdIndex].cmdFn(ipCtxP, objc, objv);
+}
@@ -243,6 +243,8 @@ typedef enum CffiAttrFlags {
     CFFI_F_ATTR_MULTISZ          = 0x02000000, /* Windows multisz */
     CFFI_F_ATTR_SAVEERROR        = 0x04000000, /* Save error codes after call */
     CFFI_F_ATTR_PINNED           = 0x08000000, /* Pinned pointer*/
+    CFFI_F_ATTR_LIST             = 0x10000000, /* Struct as positional list */
+    CFFI_F_ATTR_VECTOR           = 0x20000000, /* Numeric array as vector */
 } CffiAttrFlags;
 
 /*
@@ -326,6 +328,25 @@ typedef struct CffiLibffiStruct {
     ffi_type ffiType;
     ffi_type *ffiFieldTypes[1]; /* Actually variable size */
 } CffiLibffiStruct;
+
+/*
+ * Libffi call descriptor prepared for one combination of vararg types.
+ * Varargs prototypes keep a short list of these in most recently used order
+ * so repeated calls with the same vararg types do not rebuild the cif.
+ */
+typedef struct CffiLibffiVarargsCif {
+    struct CffiLibffiVarargsCif *nextP; /* Next less recently used entry */
+    int nVarArgs;                       /* Number of varargs */
+    int *varArgKeys;       /* Identifies vararg types. Points to storage
+                              following ffiTypes[] */
+    ffi_cif cif;           /* Prepared call descriptor */
+    ffi_type *ffiTypes[1]; /* Fixed params, varargs and return type.
+                              Actually variable size */
+} CffiLibffiVarargsCif;
+#ifndef CFFI_VARARGS_CIF_CACHE_SIZE
+/* Max number of prepared cifs per varargs prototype */
+# define CFFI_VARARGS_CIF_CACHE_SIZE 8
+#endif
 #endif
 
 /* Struct: CffiField
@@ -343,6 +364,9 @@ typedef enum CffiStructFlags {
     CFFI_F_STRUCT_VARSIZE      = 0x0002, /* Variable size struct */
     CFFI_F_STRUCT_UNION        = 0x0004, /* Is a union */
     CFFI_F_STRUCT_HASSIZEFIELD = 0x0008, /* Has field with structsize */
+    CFFI_F_STRUCT_CACHEABLE    = 0x0010, /* Native value depends only on the
+                                            script level value. See
+                                            CffiStructFromObj */
 } CffiStructFlags;
 
 /* Struct: CffiStruct
@@ -370,6 +394,8 @@ struct CffiStruct {
     int dynamicCountFieldIndex; /* Index into fields[] of field holding
                                    array size of variable-sized last field.
                                    -1 if not variable size */
+    Tcl_HashTable fieldIndex; /* Field name -> index into fields[]. See
+                                 CffiStructAddFieldIndex */
     int nFields;              /* Cardinality of fields[] */
     CffiField fields[1];      /* Actual count given by nFields */
     /* !!!DO NOT ADD FIELDS HERE!!! */
@@ -401,6 +427,66 @@ typedef struct CffiScope {
     Tcl_HashTable prototypes; /* prototype name -> CffiProto */
 } CffiScope;
 
+/* Struct: CffiPointerCacheEntry
+ * Records a pointer value and tag that passed type and registration checks
+ * against a target tag. See <CffiPointerFromObj>.
+ */
+typedef struct CffiPointerCacheEntry {
+    void *pv;               /* Pointer value. NULL for unused entries */
+    Tcl_Obj *tagObj;        /* Tag of the pointer. Reference held. */
+    Tcl_Obj *targetTagObj;  /* Tag validated against. Reference held. */
+    Tcl_WideUInt epoch;     /* pointerRegistryEpoch at time of validation */
+} CffiPointerCacheEntry;
+#ifndef CFFI_POINTER_CACHE_SIZE
+# define CFFI_POINTER_CACHE_SIZE 64 /* Must be a power of 2 */
+#endif
+
+/* Struct: CffiPointerRange
+ * Address range registered as a single unit. Any pointer within the range
+ * is treated as a registered (derived) pointer. See <CffiPointerRangeRegister>.
+ */
+typedef struct CffiPointerRange {
+    char *startP; /* First byte of the range */
+    char *endP;   /* One past the last byte of the range */
+} CffiPointerRange;
+
+/* Struct: CffiMemoryView
+ * Internal representation of Tcl_Obj values returned by *memory view*.
+ * Shared between duplicates of the Tcl_Obj. See <CffiMemoryViewCmd>.
+ */
+typedef struct CffiMemoryView {
+    struct CffiMemoryView *nextP; /* Links in list of attached views */
+    struct CffiMemoryView *prevP;
+    struct CffiInterpCtx *ipCtxP; /* NULL once detached from native memory */
+    void *basePv;                 /* Pointer the view was created from */
+    unsigned char *bytesP;        /* Viewed bytes. Private copy if detached */
+    Tcl_Size size;                /* Number of bytes in view */
+    int nRefs;                    /* Number of Tcl_Obj sharing the view */
+} CffiMemoryView;
+
+/* Struct: CffiMemoryMapping
+ * Describes a file or shared memory mapping created by *memory map* or
+ * *memory shm*. See <CffiMemoryMapRegion>.
+ */
+typedef struct CffiMemoryMapping {
+    struct CffiMemoryMapping *nextP; /* Next mapping for the interpreter */
+    void *pv;                        /* Address returned to the script */
+    void *baseP;      /* Start of mapping. Differs from pv when the offset
+                         is not aligned to the system mapping granularity */
+    size_t mappedSize; /* Size of the mapping starting at baseP */
+    int readonly;      /* Non-0 if mapped without write access */
+} CffiMemoryMapping;
+
+/* Struct: CffiAllocOptions
+ * Options controlling allocation of memory by script level commands.
+ * See <CffiAllocOptionsParse> and <CffiMemoryAlloc>.
+ */
+typedef struct CffiAllocOptions {
+    struct CffiPool *poolP; /* Pool to allocate from. NULL if none. */
+    Tcl_Size align;         /* Required alignment. 0 for default. */
+    int hugepages;          /* If non-0, allocate using huge pages */
+} CffiAllocOptions;
+
 /* Struct: CffiInterpCtx
  * Holds the CFFI related context for an interpreter.
  *
@@ -429,12 +515,85 @@ typedef struct CffiInterpCtx {
 
     Tclh_LibContext *tclhCtxP;
 
+    Tcl_HashTable callCache;  /* Maps function pointer strings passed to
+                                 cffi::call to a CffiFunction. Only pointers
+                                 with fully qualified tags are cached. */
+#define CFFI_CALL_CACHE_MAX_ENTRIES 256
+    Tcl_WideUInt definitionsEpoch; /* Changed whenever aliases, enums or
+                                      structs are defined or deleted. See
+                                      CffiDefinitionsChanged */
+    unsigned int pointerTagEpoch; /* Incremented whenever pointer subtag
+                                     relationships change. Used to
+                                     invalidate cached tag relations. */
+    Tcl_WideUInt pointerRegistryEpoch; /* Incremented whenever pointers are
+                                          unregistered or invalidated or
+                                          tag relationships change. See
+                                          CffiPointerRegistryChanged */
+    CffiPointerCacheEntry pointerCache[CFFI_POINTER_CACHE_SIZE];
+    CffiPointerRange *pointerRangesP; /* Registered address ranges sorted
+                                         by start address */
+    Tcl_Size nPointerRanges;          /* Number of ranges in use */
+    Tcl_Size nPointerRangesAllocated; /* Capacity of pointerRangesP */
+    CffiMemoryView *memoryViewsP;     /* Views attached to native memory */
+    CffiMemoryMapping *memoryMappingsP; /* Mapped files and shared memory */
+    struct CffiPool *poolsP;          /* Memory pools. See tclCffiPool.c */
+    Tcl_HashTable alignedAllocations; /* Aligned or huge page allocation
+                                         address -> CffiAlignedAllocation */
+    unsigned int poolId;              /* Used to generate pool names */
+
+    Tcl_HashTable callStats; /* Function name -> CffiCallStats. Entries
+                                are never deleted while the interpreter
+                                exists as CffiFunction caches them. */
+    int callStatsEnabled;    /* Whether call statistics are collected */
+
+#ifdef CFFI_USE_LIBFFI
+    struct CffiAsyncCall *asyncCallsP; /* Outstanding asynchronous calls.
+                                          See CffiFunctionCallAsync */
+#endif
+
     int savedErrno;
 #ifdef _WIN32
     DWORD savedWinError;
 #endif
 } CffiInterpCtx;
 
+/* Function: CffiPointerRegistryChanged
+ * Invalidates pointer validation results cached by <CffiPointerFromObj>.
+ *
+ * Must be called whenever a pointer is unregistered or invalidated or
+ * pointer tag relationships are changed. Registrations need only call
+ * <CffiPointerRegistering>.
+ */
+CFFI_INLINE void CffiPointerRegistryChanged(CffiInterpCtx *ipCtxP) {
+    ipCtxP->pointerRegistryEpoch += 1;
+}
+
+int CffiPointerRangeLookup(CffiInterpCtx *ipCtxP, const void *pv);
+int CffiPointerRangeBounds(CffiInterpCtx *ipCtxP, const void *pv, char **endPP);
+
+/* Function: CffiPointerRangeCheckRegistration
+ * Checks registered address ranges for pointers not registered individually.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - pointer value
+ * registration - registration status of *pv* in the pointer registry
+ *
+ * Returns:
+ * *TCLH_POINTER_REGISTRATION_DERIVED* if *pv* is not registered but lies
+ * within a registered address range, *registration* otherwise.
+ */
+CFFI_INLINE Tclh_PointerRegistrationStatus
+CffiPointerRangeCheckRegistration(CffiInterpCtx *ipCtxP,
+                                  const void *pv,
+                                  Tclh_PointerRegistrationStatus registration)
+{
+    if (registration == TCLH_POINTER_REGISTRATION_MISSING
+        && ipCtxP->nPointerRanges && CffiPointerRangeLookup(ipCtxP, pv))
+        return TCLH_POINTER_REGISTRATION_DERIVED;
+    return registration;
+}
+
 /* Context for dll commands. */
 #ifdef CFFI_USE_TCLLOAD
 typedef Tcl_LoadHandle CffiLoadHandle;
@@ -471,6 +630,47 @@ typedef struct CffiParam {
                                 the array size. */
 } CffiParam;
 
+struct CffiCall;
+/* Typedef: CffiArgPrepareProc
+ * Signature of functions that convert a script level argument into its
+ * native form for a call. See <CffiCallPlan>.
+ */
+typedef CffiResult CffiArgPrepareProc(struct CffiCall *callP,
+                                      int arg_index,
+                                      Tcl_Obj *valueObj);
+
+/*
+ * Maximum number of parameters for a function to be eligible for the fast
+ * call path where argument storage is allocated on the C stack.
+ */
+#define CFFI_FASTCALL_MAX_PARAMS 8
+
+/* Struct: CffiCallPlan
+ * Precompiled information about a prototype's parameters. This is computed
+ * once when the prototype is defined so that function calls do not need to
+ * recompute it on every invocation. The index arrays only cover the fixed
+ * parameters of the prototype, not varargs.
+ */
+typedef struct CffiCallPlan {
+    int flags;
+#define CFFI_F_PLAN_FASTCALL 0x1 /* Prototype eligible for fast call path */
+#define CFFI_F_PLAN_ASYNC    0x2 /* Prototype can be called asynchronously */
+    int minArgs;        /* Minimum number of script level arguments */
+    int maxArgs;        /* Maximum number of script level arguments excluding
+                           varargs */
+    int retvalIndex;    /* Index of the retval parameter or -1 */
+    int nDispose;       /* Number of elements in disposeIndices */
+    int nOutput;        /* Number of elements in outputIndices */
+    int nVLA;           /* Number of elements in vlaIndices */
+    int *disposeIndices; /* Input pointer params with dispose annotations */
+    int *outputIndices;  /* Output params excluding the retval param */
+    int *vlaIndices;     /* Params that are dynamically sized arrays */
+    CffiArgPrepareProc **argPrepareProcs; /* Argument converter for each
+                                             parameter. NULL for dynamically
+                                             sized arrays which are set up
+                                             in a second pass. */
+} CffiCallPlan;
+
 /* Struct: CffiProto
  * Descriptor for a function prototype including parameters and return
  * types. Note this is a variable size structure as the number of
@@ -484,8 +684,12 @@ typedef struct CffiProto {
     CffiABIProtocol abi;  /* cdecl, stdcall etc. */
     CffiParam returnType; /* Name and return type of function */
 #ifdef CFFI_USE_LIBFFI
-    ffi_cif *cifP; /* Descriptor used by cffi */
+    ffi_cif *cifP; /* Descriptor used by cffi. For varargs prototypes,
+                      points into the head of varargsCifs. */
+    CffiLibffiVarargsCif *varargsCifs; /* Most recently used first */
 #endif
+    CffiCallPlan *planP;  /* Precompiled call information. Allocated as
+                             a single block. */
     CffiParam params[1]; /* Real size depends on nparams which
                              may even be 0!*/
     /* !!!DO NOT ADD FIELDS HERE AT END OF STRUCT!!! */
@@ -497,6 +701,20 @@ CFFI_INLINE int CffiProtoIsVarargs(CffiProto *protoP) {
     return (protoP->flags & CFFI_F_PROTO_VARARGS);
 }
 
+/* Struct: CffiCallStats
+ * Call statistics for a function. Times are in nanoseconds.
+ */
+typedef struct CffiCallStats {
+    Tcl_WideUInt nCalls;        /* Number of calls */
+    Tcl_WideUInt nErrors;       /* Number of calls that raised errors */
+    Tcl_WideUInt totalTime;     /* Cumulative time for all calls */
+    Tcl_WideUInt maxTime;       /* Longest single call */
+    Tcl_WideUInt marshalTime;   /* Time converting arguments */
+    Tcl_WideUInt nativeTime;    /* Time in the native function */
+    Tcl_WideUInt unmarshalTime; /* Time converting results and output
+                                   parameters */
+} CffiCallStats;
+
 /* Struct: CffiFunction
  * Descriptor for a callable function including its address, prototype
  * and other optional information
@@ -508,6 +726,8 @@ typedef struct CffiFunction {
     CffiLibCtx *libCtxP;   /* Containing library for bound functions or
                               NULL for free standing functions */
     Tcl_Obj *cmdNameObj;   /* Name of Tcl command. May be NULL */
+    CffiCallStats *statsP; /* Entry in ipCtxP->callStats. Lazily set when
+                              statistics are first collected. */
     int nRefs;             /* Reference count */
 } CffiFunction;
 
@@ -555,6 +775,11 @@ typedef struct CffiInterface {
     int nMethods; /* Size of vtable[] */
     int nInheritedMethods; /* Number of inherited methods in vtable */
     CffiInterfaceMember *vtable;
+    Tcl_Obj *cachedTagObj; /* Pointer tag last passed to a method. May be NULL */
+    Tclh_PointerTagRelation cachedTagRelation; /* Relation of cachedTagObj
+                                                  to nameObj */
+    unsigned int cachedTagEpoch; /* Value of ipCtxP->pointerTagEpoch when
+                                    cachedTagRelation was computed */
 } CffiInterface;
 CFFI_INLINE void CffiInterfaceRef(CffiInterface *ifcP) {
     ifcP->nRefs += 1;
@@ -567,6 +792,11 @@ typedef struct CffiMethod {
     CffiInterface *ifcP;   /* Containing interface */
     Tcl_Obj *cmdNameObj;   /* Name of Tcl command. May be NULL */
     int vtableSlot;        /* Method slot in interface vtable */
+#define CFFI_METHOD_DISPATCH_CACHE_SIZE 4
+    CffiFunction *dispatchCache[CFFI_METHOD_DISPATCH_CACHE_SIZE];
+                           /* Functions previously dispatched through this
+                              method, indexed by hash of function address
+                              from the instance vtable. Entries may be NULL */
 } CffiMethod;
 
 /* Struct: CffiCall
@@ -613,6 +843,8 @@ typedef enum CffiFlags {
     CFFI_F_ALLOW_UNSAFE        = 0x1, /* No pointer validity check */
     CFFI_F_PRESERVE_ON_ERROR   = 0x2, /* Preserve original content on error */
     CFFI_F_SKIP_ERROR_MESSAGES = 0x4, /* Don't store error in interp */
+    CFFI_F_ALLOW_OVERLAP       = 0x8, /* Memory regions may overlap */
+    CFFI_F_AS_LIST             = 0x10, /* Struct values are positional lists */
 } CffiFlags;
 
 /*
@@ -648,6 +880,11 @@ CffiResult CffiTypeAndAttrsParse(CffiInterpCtx *ipCtxP,
                                  Tcl_Obj *typeAttrObj,
                                  CffiTypeParseMode parseMode,
                                  CffiTypeAndAttrs *typeAttrsP);
+CffiResult CffiTypeAndAttrsParseCached(CffiInterpCtx *ipCtxP,
+                                       Tcl_Obj *typeAttrObj,
+                                       CffiTypeParseMode parseMode,
+                                       CffiTypeAndAttrs *typeAttrsP);
+void CffiDefinitionsChanged(CffiInterpCtx *ipCtxP);
 void CffiTypeAndAttrsCleanup(CffiTypeAndAttrs *typeAttrsP);
 Tcl_Obj *CffiTypeUnparse(const CffiType *typeP);
 Tcl_Obj *CffiTypeAndAttrsUnparse(const CffiTypeAndAttrs *typeAttrsP);
@@ -661,6 +898,11 @@ CffiResult CffiParseAllocationSize(CffiInterpCtx *ipCtxP,
                                    Tcl_Size *sizeP);
 
 void CffiStructUnref(CffiStruct *structP);
+CffiStruct *CffiStructCkalloc(Tcl_Size nfields);
+int CffiStructAddFieldIndex(CffiStruct *structP, int fieldIndex);
+void CffiStructCreateCommand(CffiInterpCtx *ipCtxP,
+                             Tcl_Obj *cmdNameObj,
+                             CffiStruct *structP);
 CffiResult CffiErrorStructIsVariableSize(Tcl_Interp *ip, CffiStruct *structP, const char *oper);
 CffiResult CffiErrorMissingVLACountOption(Tcl_Interp *ip);
 CffiResult CffiErrorStructCountField(Tcl_Interp *ip, Tcl_Obj *fldNameObj);
@@ -681,10 +923,55 @@ CffiResult CffiStructSizeForVLACount(CffiInterpCtx *ipCtxP,
                                      int *sizeP,
                                      int *fixedSizeP);
 void CffiStructInitSizeField(const CffiStruct *structP, void *structAddress);
+CffiResult CffiStructObjDictSize(Tcl_Interp *ip,
+                                 Tcl_Obj *structValueObj,
+                                 Tcl_Size *sizeP);
 CffiResult CffiStructResolve(Tcl_Interp *ip,
                              const char *nameP,
                              CffiBaseType baseType,
                              CffiStruct **structPP);
+unsigned char *CffiGetByteArrayFromObj(Tcl_Obj *objP, Tcl_Size *lenP);
+int CffiIsMemoryViewObj(Tcl_Obj *objP);
+const void *
+CffiVectorValues(Tcl_Obj *objP, CffiBaseType baseType, Tcl_Size *countP);
+Tcl_Obj *CffiVectorNew(CffiBaseType baseType,
+                       int elemSize,
+                       Tcl_Size count,
+                       void **valuesPP);
+void CffiMemoryViewsRelease(CffiInterpCtx *ipCtxP,
+                            void *pv,
+                            Tcl_Size len,
+                            int copy);
+void CffiMemoryViewsCleanup(CffiInterpCtx *ipCtxP);
+void CffiMemoryMappingsCleanup(CffiInterpCtx *ipCtxP);
+void CffiMemoryMappingRelease(CffiInterpCtx *ipCtxP, void *pv);
+CffiResult CffiMemoryCheckWritable(CffiInterpCtx *ipCtxP,
+                                   Tcl_Obj *ptrObj,
+                                   const void *pv);
+CffiResult CffiMemoryPoolCmd(CffiInterpCtx *ipCtxP,
+                             int objc,
+                             Tcl_Obj *const objv[],
+                             CffiFlags flags);
+CffiResult CffiPoolFromObj(CffiInterpCtx *ipCtxP,
+                           Tcl_Obj *nameObj,
+                           struct CffiPool **poolPP);
+CffiResult CffiAlignmentFromObj(Tcl_Interp *ip,
+                                Tcl_Obj *alignObj,
+                                Tcl_Size *alignP);
+CffiResult CffiAllocOptionsParse(CffiInterpCtx *ipCtxP,
+                                 int objc,
+                                 Tcl_Obj *const objv[],
+                                 int *indexP,
+                                 CffiAllocOptions *optsP);
+CffiResult CffiMemoryAlloc(CffiInterpCtx *ipCtxP,
+                           Tcl_Size size,
+                           const CffiAllocOptions *optsP,
+                           void **pvP);
+void CffiMemoryFree(CffiInterpCtx *ipCtxP, void *pv);
+void CffiAlignedAllocationsCleanup(CffiInterpCtx *ipCtxP);
+void *CffiPoolAllocate(struct CffiPool *poolP, Tcl_Size size);
+int CffiPoolFree(CffiInterpCtx *ipCtxP, void *pv);
+void CffiPoolsCleanup(CffiInterpCtx *ipCtxP);
 CffiResult CffiBytesFromObjSafe(Tcl_Interp *ip,
                                 Tcl_Obj *fromObj,
                                 unsigned char *toP,
@@ -732,6 +1019,7 @@ CffiResult CffiStructFromObj(CffiInterpCtx *ipCtxP,
 CffiResult CffiStructToObj(CffiInterpCtx *ipCtxP,
                            const CffiStruct *structP,
                            void *valueP,
+                           CffiFlags flags,
                            Tcl_Obj **valueObjP);
 CffiResult
 CffiStructObjDefault(CffiInterpCtx *ipCtxP, CffiStruct *structP, void *valueP);
@@ -763,6 +1051,20 @@ CffiResult CffiNativeValueToObj(CffiInterpCtx *ipCtxP,
                                 int count,
                                 Tcl_Obj **valueObjP);
 Tcl_Obj *CffiMakePointerTagFromObj(CffiInterpCtx *ipCtxP, Tcl_Obj *tagObj);
+void CffiPointerCacheReset(CffiInterpCtx *ipCtxP);
+CffiResult
+CffiPointerRangeRegister(CffiInterpCtx *ipCtxP, void *pv, Tcl_Size size);
+int CffiPointerRangeExtend(CffiInterpCtx *ipCtxP, void *pv, void *endP);
+void CffiPointerRangeRecordAllocation(CffiInterpCtx *ipCtxP,
+                                      void *pv,
+                                      Tcl_Size size);
+void CffiPointerRangeUnregister(CffiInterpCtx *ipCtxP, void *pv);
+void CffiPointerReleased(CffiInterpCtx *ipCtxP, void *pv, int copy);
+void CffiPointerRegistering(CffiInterpCtx *ipCtxP, void *pv);
+void CffiPointerViewsSnapshot(CffiInterpCtx *ipCtxP, void *pv);
+void CffiPointerRangesCleanup(CffiInterpCtx *ipCtxP);
+CffiResult
+CffiPointerObjVerify(CffiInterpCtx *ipCtxP, Tcl_Obj *ptrObj, void **pvP);
 Tcl_Obj *
 CffiMakePointerTag(CffiInterpCtx *, const char *tagP, Tcl_Size tagLen);
 CffiResult CffiMakePointerObj(CffiInterpCtx *ipCtxP,
@@ -820,7 +1122,9 @@ CffiResult CffiPrototypeParse(CffiInterpCtx *ipCtxP,
                               Tcl_Size nparams,
                               Tcl_Obj **paramObjs,
                               CffiProto **protoPP);
+CffiProto *CffiProtoAllocate(Tcl_Size nparams);
 void CffiProtoUnref(CffiProto *protoP);
+void CffiCallCacheReset(CffiInterpCtx *ipCtxP);
 void CffiPrototypesCleanup(CffiInterpCtx *ipCtxP);
 CffiProto *
 CffiProtoGet(CffiInterpCtx *ipCtxP, Tcl_Obj *protoNameObj);
@@ -992,6 +1296,7 @@ CffiResult CffiLibffiInitProtoCif(CffiInterpCtx *ipCtxP,
                                   int numVarArgs,
                                   Tcl_Obj * const *varArgObjs,
                                   CffiTypeAndAttrs *typeAttrsP);
+void CffiLibffiVarargsCifsFree(CffiProto *protoP);
 
 # ifdef CFFI_HAVE_CALLBACKS
 void CffiLibffiCallback(ffi_cif *cifP, void *retP, void **args, void *userdata);
@@ -1082,7 +1387,25 @@ CffiResult CffiFunctionCall(ClientData cdata,
                             int objc,
                             Tcl_Obj *const objv[]);
 Tcl_ObjCmdProc CffiFunctionInstanceCmd;
+Tcl_ObjCmdProc CffiLazyFunctionInstanceCmd;
+CffiResult CffiFunctionFromCommand(Tcl_Interp *ip,
+                                   Tcl_Obj *cmdNameObj,
+                                   CffiFunction **fnPP);
+#ifdef CFFI_USE_LIBFFI
+CffiResult CffiFunctionCallAsync(CffiFunction *fnP,
+                                 Tcl_Interp *ip,
+                                 int objArgIndex,
+                                 int objc,
+                                 Tcl_Obj *const objv[],
+                                 Tcl_Obj *cmdObj);
+void CffiAsyncCallsCleanup(CffiInterpCtx *ipCtxP);
+#endif
+void CffiCallPlanInit(CffiProto *protoP);
 void CffiFunctionCleanup(CffiFunction *fnP);
+void CffiCallStatsInit(CffiInterpCtx *ipCtxP);
+void CffiCallStatsCleanup(CffiInterpCtx *ipCtxP);
+Tcl_ObjCmdProc CffiStatsObjCmd;
+Tcl_ObjCmdProc CffiImageObjCmd;
 CFFI_INLINE void CffiFunctionRef(CffiFunction *fnP) {
     fnP->nRefs += 1;
 }
@@ -1094,6 +1417,9 @@ CFFI_INLINE void CffiFunctionUnref(CffiFunction *fnP) {
         ckfree(fnP);
     }
 }
+/* Flags for CffiDefineOneFunctionFromLib */
+#define CFFI_F_DEFINE_IGNOREMISSING 0x1 /* Ignore missing symbols */
+#define CFFI_F_DEFINE_LAZY          0x2 /* Defer definition to first call */
 CffiResult CffiDefineOneFunctionFromLib(Tcl_Interp *ip,
                                         CffiLibCtx *libCtxP,
                                         Tcl_Obj *nameObj,
@@ -1117,6 +1443,7 @@ Tcl_ObjCmdProc CffiPrototypeObjCmd;
 Tcl_ObjCmdProc CffiStructObjCmd;
 Tcl_ObjCmdProc CffiTypeObjCmd;
 Tcl_ObjCmdProc CffiUnionObjCmd;
+Tcl_ObjCmdProc CffiVectorObjCmd;
 Tcl_ObjCmdProc CffiWrapperObjCmd;
 
 #ifdef CFFI_HAVE_CALLBACKS
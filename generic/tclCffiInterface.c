@@ -18,6 +18,8 @@ void CffiInterfaceUnref(CffiInterface *ifcP)
             Tcl_DecrRefCount(ifcP->nameObj);
         if (ifcP->idObj)
             Tcl_DecrRefCount(ifcP->idObj);
+        if (ifcP->cachedTagObj)
+            Tcl_DecrRefCount(ifcP->cachedTagObj);
         if (ifcP->baseIfcP)
             CffiInterfaceUnref(ifcP->baseIfcP);
         if (ifcP->vtable) {
@@ -72,6 +74,106 @@ notfound:
     return TCL_ERROR;
 }
 
+/* Function: CffiInterfaceTagRelation
+ * Returns the relation of a pointer tag to an interface.
+ *
+ * Parameters:
+ * ip - interpreter
+ * ifcP - the interface
+ * ptrObj - the pointer object whose tag is to be checked
+ * tagObj - the tag of *ptrObj* as returned by Tclh_PointerObjDissect
+ * tagRelationP - location to store the relation
+ *
+ * The relation for the last tag seen is cached in the interface and reused
+ * as long as no pointer subtag definitions have been changed since.
+ *
+ * Returns:
+ * *TCL_OK* on success with the relation stored in *tagRelationP*, or
+ * *TCL_ERROR* on error with message in interpreter.
+ */
+static CffiResult
+CffiInterfaceTagRelation(Tcl_Interp *ip,
+                         CffiInterface *ifcP,
+                         Tcl_Obj *ptrObj,
+                         Tcl_Obj *tagObj,
+                         Tclh_PointerTagRelation *tagRelationP)
+{
+    CffiInterpCtx *ipCtxP = ifcP->ipCtxP;
+    Tclh_PointerTagRelation tagRelation;
+    CffiResult ret;
+    void *pv;
+
+    if (tagObj && ifcP->cachedTagObj
+        && ifcP->cachedTagEpoch == ipCtxP->pointerTagEpoch
+        && (tagObj == ifcP->cachedTagObj
+            || !strcmp(Tcl_GetString(tagObj),
+                       Tcl_GetString(ifcP->cachedTagObj)))) {
+        *tagRelationP = ifcP->cachedTagRelation;
+        return TCL_OK;
+    }
+
+    ret = Tclh_PointerObjDissect(ip,
+                                 ipCtxP->tclhCtxP,
+                                 ptrObj,
+                                 ifcP->nameObj,
+                                 &pv,
+                                 NULL,
+                                 &tagRelation,
+                                 NULL);
+    if (ret != TCL_OK)
+        return ret;
+
+    if (tagObj) {
+        Tcl_IncrRefCount(tagObj);
+        if (ifcP->cachedTagObj)
+            Tcl_DecrRefCount(ifcP->cachedTagObj);
+        ifcP->cachedTagObj      = tagObj;
+        ifcP->cachedTagRelation = tagRelation;
+        ifcP->cachedTagEpoch    = ipCtxP->pointerTagEpoch;
+    }
+    *tagRelationP = tagRelation;
+    return TCL_OK;
+}
+
+/* Function: CffiMethodDispatchLookup
+ * Returns a function definition for calling a method implementation.
+ *
+ * Parameters:
+ * methodP - the method being invoked
+ * fnAddr - address of the implementation taken from the instance vtable
+ *
+ * Function definitions are cached in the method so that repeated calls
+ * through the same vtable do not allocate a new <CffiFunction> each time.
+ *
+ * *NOTE:* The reference count on the returned structure is *not* incremented.
+ * The caller should do that if it wishes to hold on to it across a call.
+ *
+ * Returns:
+ * Pointer to a <CffiFunction> for *fnAddr*.
+ */
+static CffiFunction *
+CffiMethodDispatchLookup(CffiMethod *methodP, void *fnAddr)
+{
+    CffiFunction *fnP;
+    int i;
+
+    i = (int)(((uintptr_t)fnAddr >> 4) % CFFI_METHOD_DISPATCH_CACHE_SIZE);
+    fnP = methodP->dispatchCache[i];
+    if (fnP && fnP->fnAddr == fnAddr)
+        return fnP;
+
+    if (fnP)
+        CffiFunctionUnref(fnP);
+    fnP = CffiFunctionNew(methodP->ifcP->ipCtxP,
+                          methodP->ifcP->vtable[methodP->vtableSlot].protoP,
+                          NULL,
+                          NULL,
+                          fnAddr);
+    CffiFunctionRef(fnP);
+    methodP->dispatchCache[i] = fnP;
+    return fnP;
+}
+
 CffiResult
 CffiMethodInstanceCmd(ClientData cdata,
                       Tcl_Interp *ip,
@@ -83,6 +185,7 @@ CffiMethodInstanceCmd(ClientData cdata,
     CffiFunction *fnP;
     CffiResult ret;
     void *instanceP;
+    Tcl_Obj *tagObj;
     Tclh_PointerTagRelation tagRelation;
     Tclh_PointerRegistrationStatus registration;
 
@@ -94,19 +197,27 @@ CffiMethodInstanceCmd(ClientData cdata,
         return TCL_ERROR;
     }
 
+    /*
+     * Registration has to be checked on every call but the relation of
+     * the pointer tag to the interface is computed only if not cached.
+     */
     ret = Tclh_PointerObjDissect(ip,
                            ipCtxP->tclhCtxP,
                            objv[1],
-                           methodP->ifcP->nameObj,
+                           NULL,
                            &instanceP,
+                           &tagObj,
                            NULL,
-                           &tagRelation,
                            &registration);
     if (ret != TCL_OK)
         return ret;
     if (instanceP == NULL)
         return Tclh_ErrorPointerNull(ip);
+    registration =
+        CffiPointerRangeCheckRegistration(ipCtxP, instanceP, registration);
 
+    CHECK(CffiInterfaceTagRelation(
+        ip, methodP->ifcP, objv[1], tagObj, &tagRelation));
     switch (tagRelation) {
     case TCLH_TAG_RELATION_EQUAL:
     case TCLH_TAG_RELATION_IMPLICITLY_CASTABLE:
@@ -135,11 +246,9 @@ CffiMethodInstanceCmd(ClientData cdata,
     typedef int (*fnptr)();
     typedef fnptr *vtableptr;
     vtableptr instanceVtablePtr = *(vtableptr *)instanceP;
-    fnP = CffiFunctionNew(ipCtxP,
-                          methodP->ifcP->vtable[methodP->vtableSlot].protoP,
-                          NULL,
-                          NULL,
-                          instanceVtablePtr[methodP->vtableSlot]);
+    fnP = CffiMethodDispatchLookup(methodP,
+                                   instanceVtablePtr[methodP->vtableSlot]);
+    /* Guard against the cache entry being replaced by a recursive call */
     CffiFunctionRef(fnP);
     ret = CffiFunctionCall(fnP, ip, 1, objc, objv);
     CffiFunctionUnref(fnP);
@@ -167,6 +276,11 @@ static void
 CffiMethodInstanceDeleter(ClientData cdata)
 {
     CffiMethod *methodP = (CffiMethod *)cdata;
+    int i;
+    for (i = 0; i < CFFI_METHOD_DISPATCH_CACHE_SIZE; ++i) {
+        if (methodP->dispatchCache[i])
+            CffiFunctionUnref(methodP->dispatchCache[i]);
+    }
     CffiInterfaceUnref(methodP->ifcP);
     Tcl_DecrRefCount(methodP->cmdNameObj);
 }
@@ -304,6 +418,7 @@ CffiInterfaceMethodsHelper(Tcl_Interp *ip,
         methodP->cmdNameObj = methodNameObj; /* Already incr ref-ed */
         methodP->ifcP       = ifcP;
         methodP->vtableSlot = (int) methodSlot;
+        memset(methodP->dispatchCache, 0, sizeof(methodP->dispatchCache));
         CffiInterfaceRef(ifcP);
 
         Tcl_CreateObjCommand(ip,
@@ -472,6 +587,7 @@ CffiInterfaceCreateCmd(ClientData cdata,
     ifcP->nMethods          = 0;
     ifcP->nInheritedMethods = 0;
     ifcP->vtable            = NULL;
+    ifcP->cachedTagObj      = NULL;
 
     ifcP->nameObj = Tclh_NsQualifyNameObj(ip, objv[2], NULL);
     Tcl_IncrRefCount(ifcP->nameObj);
@@ -484,6 +600,8 @@ CffiInterfaceCreateCmd(ClientData cdata,
     if (baseIfcP) {
         Tclh_PointerSubtagDefine(
             ip, ifcP->ipCtxP->tclhCtxP, ifcP->nameObj, baseIfcP->nameObj);
+        ifcP->ipCtxP->pointerTagEpoch += 1;
+        CffiPointerRegistryChanged(ifcP->ipCtxP);
         CffiInterfaceRef(baseIfcP);
     }
     Tcl_CreateObjCommand(ip,
@@ -180,6 +180,143 @@ invalid_type:
         ip, NULL, "Unknown type or invalid type for context.");
 }
 
+/* Function: CffiLibffiVarargKey
+ * Returns a key identifying the libffi type that a vararg maps to.
+ *
+ * Parameters:
+ * typeAttrsP - parsed vararg type
+ *
+ * Arrays passed by value are not supported by libffi and are mapped to a
+ * key that never matches a prepared cif so the error is reported.
+ *
+ * Returns:
+ * An integer key.
+ */
+CFFI_INLINE int
+CffiLibffiVarargKey(const CffiTypeAndAttrs *typeAttrsP)
+{
+    if (typeAttrsP->flags & CFFI_F_ATTR_BYREF)
+        return -1;
+    if (CffiTypeIsArray(&typeAttrsP->dataType))
+        return -2;
+    return typeAttrsP->dataType.baseType;
+}
+
+/* Function: CffiLibffiVarargsCifsFree
+ * Frees the prepared call descriptors for a varargs prototype.
+ *
+ * Parameters:
+ * protoP - the prototype
+ */
+void
+CffiLibffiVarargsCifsFree(CffiProto *protoP)
+{
+    CffiLibffiVarargsCif *entryP = protoP->varargsCifs;
+    while (entryP) {
+        CffiLibffiVarargsCif *nextP = entryP->nextP;
+        ckfree(entryP);
+        entryP = nextP;
+    }
+    protoP->varargsCifs = NULL;
+    protoP->cifP        = NULL;
+}
+
+/* Function: CffiLibffiVarargsCifLookup
+ * Looks up a prepared call descriptor matching the vararg types of a call.
+ *
+ * Parameters:
+ * protoP - the varargs prototype
+ * numVarArgs - number of varargs
+ * varArgTypesP - parsed types of the varargs
+ *
+ * On a match, the entry is moved to the front of the prototype's list and
+ * *protoP->cifP* is set to point to its descriptor.
+ *
+ * Returns:
+ * 1 if a matching descriptor was found, 0 otherwise.
+ */
+static int
+CffiLibffiVarargsCifLookup(CffiProto *protoP,
+                           int numVarArgs,
+                           const CffiTypeAndAttrs *varArgTypesP)
+{
+    CffiLibffiVarargsCif *entryP;
+    CffiLibffiVarargsCif **prevPP;
+    int i;
+
+    for (prevPP = &protoP->varargsCifs, entryP = *prevPP; entryP;
+         prevPP = &entryP->nextP, entryP = *prevPP) {
+        if (entryP->nVarArgs != numVarArgs)
+            continue;
+        for (i = 0; i < numVarArgs; ++i) {
+            if (entryP->varArgKeys[i] != CffiLibffiVarargKey(&varArgTypesP[i]))
+                break;
+        }
+        if (i == numVarArgs) {
+            /* Match. Move to front */
+            *prevPP             = entryP->nextP;
+            entryP->nextP       = protoP->varargsCifs;
+            protoP->varargsCifs = entryP;
+            protoP->cifP        = &entryP->cif;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Function: CffiLibffiVarargsCifAdd
+ * Adds a call descriptor to the front of a varargs prototype's list.
+ *
+ * Parameters:
+ * protoP - the varargs prototype
+ * newP - the new entry. Ownership passes to the prototype.
+ *
+ * The least recently used entry is freed if the list is full.
+ */
+static void
+CffiLibffiVarargsCifAdd(CffiProto *protoP, CffiLibffiVarargsCif *newP)
+{
+    CffiLibffiVarargsCif *entryP;
+    int n;
+
+    newP->nextP         = protoP->varargsCifs;
+    protoP->varargsCifs = newP;
+    protoP->cifP        = &newP->cif;
+
+    for (n = 1, entryP = newP; entryP->nextP; ++n, entryP = entryP->nextP) {
+        if (n == CFFI_VARARGS_CIF_CACHE_SIZE) {
+            CffiLibffiVarargsCif *lruP = entryP->nextP;
+            entryP->nextP = NULL;
+            while (lruP) {
+                CffiLibffiVarargsCif *nextP = lruP->nextP;
+                ckfree(lruP);
+                lruP = nextP;
+            }
+            break;
+        }
+    }
+}
+
+/* Function: CffiLibffiInitProtoCif
+ * Initializes the libffi call descriptor for a prototype.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * protoP - the prototype
+ * numVarArgs - number of varargs passed in call. Must be 0 for
+ *   prototypes that do not take varargs.
+ * varArgObjs - the vararg type and value pairs
+ * varArgTypesP - location to store parsed vararg types. On success, caller
+ *   is responsible for cleaning these up.
+ *
+ * For prototypes with fixed parameters, the descriptor is constructed once.
+ * For varargs prototypes, the vararg types may differ on every call so
+ * descriptors are cached per prototype keyed by the vararg types.
+ *
+ * Returns:
+ * *TCL_OK* on success with *protoP->cifP* pointing to the descriptor,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
 CffiResult
 CffiLibffiInitProtoCif(CffiInterpCtx *ipCtxP,
                        CffiProto *protoP,
@@ -190,6 +327,9 @@ CffiLibffiInitProtoCif(CffiInterpCtx *ipCtxP,
     Tcl_Interp *ip = ipCtxP->interp;
     ffi_cif *cifP;
     ffi_type **ffiTypePP;
+    CffiLibffiVarargsCif *varargsCifP;
+    void *allocP;
+    ffi_status ffiStatus;
     CffiResult ret;
     int i;
     int totalSlots;
@@ -198,23 +338,64 @@ CffiLibffiInitProtoCif(CffiInterpCtx *ipCtxP,
     CFFI_ASSERT(numVarArgs == 0 || varArgObjs);
     CFFI_ASSERT(numVarArgs == 0 || varArgTypesP);
 
+    if (protoP->cifP && !(protoP->flags & CFFI_F_PROTO_VARARGS))
+        return TCL_OK; /* Not a varargs function, and already init'ed */
+
     /*
-     * For varargs, arguments may keep changing so we have to regenerate the
-     * libffi argument descriptors on every call.
+     * Gather up the vararg types. Unlike the fixed parameters, here the
+     * types are specified at call time so need to parse those
      */
-    if (protoP->cifP) {
-        if (! (protoP->flags & CFFI_F_PROTO_VARARGS))
-            return TCL_OK; /* Not a varargs function, and already init'ed */
-        ckfree(protoP->cifP);
-        protoP->cifP = NULL;
+    int numVarArgTypesInited;
+    ret = TCL_OK;
+    for (numVarArgTypesInited = 0, i = 0; i < numVarArgs; ++i) {
+        /* The varargs arguments are pairs consisting of type and value. */
+        Tcl_Obj **argObjs;
+        Tcl_Size n;
+        if (Tcl_ListObjGetElements(NULL, varArgObjs[i], &n, &argObjs) != TCL_OK
+            || n != 2) {
+            ret = Tclh_ErrorInvalidValue(
+                ip, varArgObjs[i], "A vararg must be a type and value pair.");
+            break;
+        }
+        ret = CffiTypeAndAttrsParseCached(
+            ipCtxP, argObjs[0], CFFI_F_TYPE_PARSE_PARAM, &varArgTypesP[i]);
+        if (ret != TCL_OK)
+            break;
+        ++numVarArgTypesInited; /* So correct number is cleaned on error */
+
+        ret = CffiCheckVarargType(ip, &varArgTypesP[i], argObjs[0]);
+        if (ret != TCL_OK)
+            break;
     }
+    if (ret != TCL_OK)
+        goto cleanup_varargs;
 
-    /* Need space for cif itself, fixed params, varargs, return value */
-    totalSlots = protoP->nParams + numVarArgs + 1;
-    cifP       = ckalloc(sizeof(*cifP) + (sizeof(ffi_type *) * totalSlots));
+    if (protoP->flags & CFFI_F_PROTO_VARARGS) {
+        /* Reuse a descriptor prepared for the same vararg types if any */
+        if (CffiLibffiVarargsCifLookup(protoP, numVarArgs, varArgTypesP))
+            return TCL_OK;
+        /* Need space for entry, fixed params, varargs, return value, keys */
+        totalSlots  = protoP->nParams + numVarArgs + 1;
+        varargsCifP = ckalloc(sizeof(*varargsCifP)
+                              + (sizeof(ffi_type *) * (totalSlots - 1))
+                              + (sizeof(int) * numVarArgs));
+        varargsCifP->nextP      = NULL;
+        varargsCifP->nVarArgs   = numVarArgs;
+        varargsCifP->varArgKeys = (int *)&varargsCifP->ffiTypes[totalSlots];
+        cifP      = &varargsCifP->cif;
+        ffiTypePP = varargsCifP->ffiTypes;
+        allocP    = varargsCifP;
+    }
+    else {
+        /* Need space for cif itself, fixed params, return value */
+        totalSlots  = protoP->nParams + 1;
+        cifP        = ckalloc(sizeof(*cifP) + (sizeof(ffi_type *) * totalSlots));
+        ffiTypePP   = (ffi_type **)(cifP + 1);
+        varargsCifP = NULL;
+        allocP      = cifP;
+    }
 
     /* Map fixed argument CFFI types to libffi types */
-    ffiTypePP = (ffi_type **)(cifP + 1);
     for (i = 0; i < protoP->nParams; ++i) {
         ret = CffiTypeToLibffiType(ip,
                                    protoP->abi,
@@ -233,72 +414,51 @@ CffiLibffiInitProtoCif(CffiInterpCtx *ipCtxP,
     if (ret != TCL_OK)
         goto error_handler;
 
-    /*
-     * Finally, gather up the vararg types. Unlike the fixed parameters,
-     * here the types are specified at call time so need to parse those
-     */
-    int numVarArgTypesInited;
-    for (numVarArgTypesInited = 0, i = 0; i < numVarArgs; ++i) {
-        /* The varargs arguments are pairs consisting of type and value. */
-        Tcl_Obj **argObjs;
-        Tcl_Size n;
-        if (Tcl_ListObjGetElements(NULL, varArgObjs[i], &n, &argObjs) != TCL_OK
-            || n != 2) {
-            Tclh_ErrorInvalidValue(
-                ip, varArgObjs[i], "A vararg must be a type and value pair.");
-            goto error_handler;
-        }
-        ret = CffiTypeAndAttrsParse(
-            ipCtxP, argObjs[0], CFFI_F_TYPE_PARSE_PARAM, &varArgTypesP[i]);
-        if (ret != TCL_OK)
-            break;
-        ++numVarArgTypesInited; /* So correct number is cleaned on error */
-
-        ret = CffiCheckVarargType(ip, &varArgTypesP[i], argObjs[0]);
-        if (ret != TCL_OK)
-            break;
-
+    for (i = 0; i < numVarArgs; ++i) {
         ret = CffiTypeToLibffiType(ip,
                                    protoP->abi,
                                    CFFI_F_TYPE_PARSE_PARAM,
                                    &varArgTypesP[i],
                                    &ffiTypePP[protoP->nParams + i]);
         if (ret != TCL_OK)
-            break;
+            goto error_handler;
+        varargsCifP->varArgKeys[i] = CffiLibffiVarargKey(&varArgTypesP[i]);
     }
-    if (ret == TCL_OK) {
-        ffi_status ffiStatus;
-        if (protoP->flags & CFFI_F_PROTO_VARARGS) {
-            ffiStatus = ffi_prep_cif_var(cifP,
+
+    if (protoP->flags & CFFI_F_PROTO_VARARGS) {
+        ffiStatus = ffi_prep_cif_var(cifP,
                                      protoP->abi,
                                      protoP->nParams,
                                      numVarArgs+protoP->nParams,
                                      ffiTypePP[numVarArgs+protoP->nParams],
                                      ffiTypePP);
-        }
-        else {
-            ffiStatus = ffi_prep_cif(cifP,
-                                     protoP->abi,
-                                     protoP->nParams,
-                                     ffiTypePP[protoP->nParams],
-                                     ffiTypePP);
-        }
-        if (ffiStatus == FFI_OK) {
+    }
+    else {
+        ffiStatus = ffi_prep_cif(cifP,
+                                 protoP->abi,
+                                 protoP->nParams,
+                                 ffiTypePP[protoP->nParams],
+                                 ffiTypePP);
+    }
+    if (ffiStatus == FFI_OK) {
+        if (varargsCifP)
+            CffiLibffiVarargsCifAdd(protoP, varargsCifP);
+        else
             protoP->cifP = cifP;
-            return TCL_OK;
-        }
-
-        /* Fall through for error handling */
-        CffiMapLibffiError(ip, ffiStatus, NULL);
+        return TCL_OK;
     }
 
+    /* Fall through for error handling */
+    CffiMapLibffiError(ip, ffiStatus, NULL);
+
+error_handler:
+    ckfree(allocP);
+
+cleanup_varargs:
     /* Error in vararg type conversion or cif prep. Clean any varargs types */
     for (i = 0; i < numVarArgTypesInited; ++i) {
         CffiTypeAndAttrsCleanup(&varArgTypesP[i]);
     }
-
-error_handler:
-    ckfree(cifP);
     return TCL_ERROR;
 }
 
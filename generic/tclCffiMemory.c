@@ -7,6 +7,24 @@
 
 #include "tclCffiInt.h"
 
+#ifndef _WIN32
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+static struct CffiMemoryMapping *
+CffiMemoryMappingRemove(CffiInterpCtx *ipCtxP, void *pv);
+static void CffiMemoryMappingFree(struct CffiMemoryMapping *mapP);
+static CffiResult CffiMemoryRegionFromObjs(CffiInterpCtx *ipCtxP,
+                                           Tcl_Obj *ptrObj,
+                                           Tcl_Obj *offObj,
+                                           Tcl_WideInt size,
+                                           CffiFlags flags,
+                                           char **regionPP);
+
 /* Function: CffiMemoryAddressFromObj
  * Calculates the memory address for an object in memory
  *
@@ -31,7 +49,9 @@ CffiMemoryAddressFromObj(CffiInterpCtx *ipCtxP,
 {
     void *pv;
     CHECK(Tclh_PointerUnwrap(ipCtxP->interp, ptrObj, &pv));
-    if (!allowUnsafe) {
+    if (!allowUnsafe
+        && !(pv && ipCtxP->nPointerRanges
+             && CffiPointerRangeLookup(ipCtxP, pv))) {
         CHECK(Tclh_PointerVerify(
             ipCtxP->interp, ipCtxP->tclhCtxP, pv));
     }
@@ -43,19 +63,307 @@ CffiMemoryAddressFromObj(CffiInterpCtx *ipCtxP,
     return TCL_OK;
 }
 
+/*
+ * Aligned and huge page allocations.
+ *
+ * Allocations with an alignment greater than that guaranteed by ckalloc, or
+ * using huge pages, return an address that differs from the one returned by
+ * the underlying allocator. The latter is recorded in the interpreter's
+ * alignedAllocations table, keyed by the returned address, so that
+ * <CffiMemoryFree> can release it.
+ */
+#define CFFI_DEFAULT_ALIGNMENT sizeof(double) /* Guaranteed by ckalloc */
+#define CFFI_MAX_ALIGNMENT     (1 << 24)
+#define CFFI_HUGEPAGE_SIZE     (2 * 1024 * 1024) /* Used where not queryable */
+
+/* Struct: CffiAlignedAllocation
+ * Records the underlying allocation for an aligned or huge page allocation.
+ */
+typedef struct CffiAlignedAllocation {
+    void *baseP;   /* Address returned by the underlying allocator */
+    size_t size;   /* Size of the underlying allocation */
+    int hugepages; /* If non-0, allocated from the system page allocator */
+} CffiAlignedAllocation;
+
+/* Function: CffiAlignmentFromObj
+ * Parses an alignment value.
+ *
+ * Parameters:
+ * ip - interpreter
+ * alignObj - alignment value. Must be a power of 2.
+ * alignP - location to store the alignment
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+CffiResult
+CffiAlignmentFromObj(Tcl_Interp *ip, Tcl_Obj *alignObj, Tcl_Size *alignP)
+{
+    Tcl_WideInt align;
+
+    CHECK(Tclh_ObjToRangedInt(ip, alignObj, 1, CFFI_MAX_ALIGNMENT, &align));
+    if (align & (align - 1)) {
+        return Tclh_ErrorInvalidValue(
+            ip, alignObj, "Alignment must be a power of 2.");
+    }
+    *alignP = (Tcl_Size)align;
+    return TCL_OK;
+}
+
+/* Function: CffiAllocOptionsParse
+ * Parses leading allocation options in a command argument array.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments in objv[]
+ * objv - argument array
+ * indexP - on entry, index of the first possible option in objv[]. On
+ *          return, index of the first argument following the options.
+ * optsP - location to store the parsed options
+ *
+ * The options recognized are *-align ALIGNMENT*, *-hugepages* and
+ * *-pool POOL*. Parsing stops at the first argument that is not exactly
+ * one of the option names.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+CffiResult
+CffiAllocOptionsParse(CffiInterpCtx *ipCtxP,
+                      int objc,
+                      Tcl_Obj *const objv[],
+                      int *indexP,
+                      CffiAllocOptions *optsP)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    int i;
+
+    optsP->poolP     = NULL;
+    optsP->align     = 0;
+    optsP->hugepages = 0;
+
+    for (i = *indexP; i < objc; ++i) {
+        const char *opt = Tcl_GetString(objv[i]);
+        if (!strcmp(opt, "-hugepages")) {
+            optsP->hugepages = 1;
+            continue;
+        }
+        if (strcmp(opt, "-align") && strcmp(opt, "-pool"))
+            break;
+        if (i == objc - 1)
+            return Tclh_ErrorOptionValueMissing(ip, objv[i], NULL);
+        ++i;
+        if (opt[1] == 'a') {
+            CHECK(CffiAlignmentFromObj(ip, objv[i], &optsP->align));
+        }
+        else {
+            CHECK(CffiPoolFromObj(ipCtxP, objv[i], &optsP->poolP));
+        }
+    }
+
+    if (optsP->poolP && (optsP->align || optsP->hugepages)) {
+        return Tclh_ErrorGeneric(
+            ip,
+            NULL,
+            "The -pool option cannot be used with -align or -hugepages.");
+    }
+    *indexP = i;
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryAlloc
+ * Allocates memory as per allocation options.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * size - number of bytes to allocate. Must be positive.
+ * optsP - allocation options. May be NULL for default allocation.
+ * pvP - location to store address of allocated memory
+ *
+ * The allocated memory is not registered as a pointer and must be freed
+ * with <CffiMemoryFree>. Huge pages are requested from the system on a best
+ * effort basis. If not available, the allocation is made with normal pages.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+CffiResult
+CffiMemoryAlloc(CffiInterpCtx *ipCtxP,
+                Tcl_Size size,
+                const CffiAllocOptions *optsP,
+                void **pvP)
+{
+    CffiAlignedAllocation *allocP;
+    Tcl_HashEntry *heP;
+    Tcl_Size align;
+    size_t allocSize;
+    void *baseP;
+    int isNew;
+
+    if (optsP == NULL
+        || (!optsP->hugepages && optsP->align <= CFFI_DEFAULT_ALIGNMENT)) {
+        if (optsP && optsP->poolP)
+            *pvP = CffiPoolAllocate(optsP->poolP, size);
+        else
+            *pvP = ckalloc(size);
+        return TCL_OK;
+    }
+
+    align = optsP->align;
+    if (optsP->hugepages) {
+#ifdef _WIN32
+        SIZE_T pageSize = GetLargePageMinimum();
+        baseP           = NULL;
+        if (pageSize) {
+            /* Only succeeds if the process holds SeLockMemoryPrivilege */
+            allocSize = (size + align + pageSize - 1) & ~(pageSize - 1);
+            baseP     = VirtualAlloc(NULL,
+                                 allocSize,
+                                 MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                 PAGE_READWRITE);
+        }
+        if (baseP == NULL) {
+            allocSize = size + align;
+            baseP     = VirtualAlloc(
+                NULL, allocSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            if (baseP == NULL) {
+                return Tclh_ErrorWindowsError(
+                    ipCtxP->interp, GetLastError(), NULL);
+            }
+        }
+#else
+        /*
+         * Transparent huge pages need the region to be aligned to the huge
+         * page size. Over-allocate so the returned address can be aligned.
+         */
+        if (align < CFFI_HUGEPAGE_SIZE)
+            align = CFFI_HUGEPAGE_SIZE;
+        allocSize = (size + CFFI_HUGEPAGE_SIZE - 1)
+                  & ~(size_t)(CFFI_HUGEPAGE_SIZE - 1);
+        allocSize += align;
+        baseP = mmap(NULL,
+                     allocSize,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0);
+        if (baseP == MAP_FAILED) {
+            return Tclh_ErrorAllocation(
+                ipCtxP->interp, "Memory", Tcl_ErrnoMsg(Tcl_GetErrno()));
+        }
+# ifdef MADV_HUGEPAGE
+        (void)madvise(baseP, allocSize, MADV_HUGEPAGE); /* Best effort */
+# endif
+#endif
+    }
+    else {
+        allocSize = size + align - 1;
+        baseP     = ckalloc(allocSize);
+    }
+
+    if (align > 1) {
+        *pvP = (void *)(((uintptr_t)baseP + align - 1)
+                        & ~(uintptr_t)(align - 1));
+    }
+    else
+        *pvP = baseP;
+
+    allocP            = ckalloc(sizeof(*allocP));
+    allocP->baseP     = baseP;
+    allocP->size      = allocSize;
+    allocP->hugepages = optsP->hugepages;
+    heP = Tcl_CreateHashEntry(&ipCtxP->alignedAllocations, *pvP, &isNew);
+    CFFI_ASSERT(isNew);
+    Tcl_SetHashValue(heP, allocP);
+    return TCL_OK;
+}
+
+/* Function: CffiAlignedAllocationFree
+ * Releases the underlying allocation for an aligned allocation.
+ *
+ * Parameters:
+ * allocP - the aligned allocation descriptor. Freed on return.
+ */
+static void
+CffiAlignedAllocationFree(CffiAlignedAllocation *allocP)
+{
+    if (allocP->hugepages) {
+#ifdef _WIN32
+        VirtualFree(allocP->baseP, 0, MEM_RELEASE);
+#else
+        munmap(allocP->baseP, allocP->size);
+#endif
+    }
+    else
+        ckfree(allocP->baseP);
+    ckfree(allocP);
+}
+
+/* Function: CffiMemoryFree
+ * Frees memory allocated with <CffiMemoryAlloc>.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address returned by <CffiMemoryAlloc>. Caller is responsible for
+ *      unregistering it.
+ *
+ * Memory allocated from pools is returned to the pool and the underlying
+ * allocation released for aligned and huge page allocations.
+ */
+void
+CffiMemoryFree(CffiInterpCtx *ipCtxP, void *pv)
+{
+    if (ipCtxP->alignedAllocations.numEntries) {
+        Tcl_HashEntry *heP =
+            Tcl_FindHashEntry(&ipCtxP->alignedAllocations, pv);
+        if (heP) {
+            CffiAlignedAllocationFree(Tcl_GetHashValue(heP));
+            Tcl_DeleteHashEntry(heP);
+            return;
+        }
+    }
+    if (ipCtxP->poolsP && CffiPoolFree(ipCtxP, pv))
+        return;
+    ckfree(pv);
+}
+
+/* Function: CffiAlignedAllocationsCleanup
+ * Releases the table of aligned allocations for an interpreter.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * As for other memory allocated through script level commands, the
+ * allocations themselves are not freed since they may still be in use
+ * by native code.
+ */
+void
+CffiAlignedAllocationsCleanup(CffiInterpCtx *ipCtxP)
+{
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+
+    for (heP = Tcl_FirstHashEntry(&ipCtxP->alignedAllocations, &hSearch);
+         heP; heP = Tcl_NextHashEntry(&hSearch)) {
+        ckfree(Tcl_GetHashValue(heP));
+    }
+    Tcl_DeleteHashTable(&ipCtxP->alignedAllocations);
+}
+
 /* Function: CffiMemoryAllocateCmd
  * Implements the *memory allocate* script level command.
  *
  * Parameters:
  * ipCtxP - interpreter context
- * objc - count of elements in objv[]. Should be 3 or 4 including command
+ * objc - count of elements in objv[]. Should be 3-9 including command
  *        and subcommand.
  * objv - argument array.
  * flags - unused
  *
- * Allocated memory using *ckalloc* and returns a wrapped pointer to it. The
- * *objv[2]* argument contains the allocation size or a type specification.
- * Optionally, the *objv[3]* argument may be passed as the pointer type tag.
+ * Allocates memory as per the leading allocation options, if any, and
+ * returns a wrapped pointer to it. The first argument following the
+ * options contains the allocation size or a type specification.
+ * Optionally, the next argument may be passed as the pointer type tag.
  *
  * Returns:
  * *TCL_OK* on success with wrapped pointer as interpreter result,
@@ -68,19 +376,31 @@ CffiMemoryAllocateCmd(CffiInterpCtx *ipCtxP,
                       CffiFlags flags)
 {
     Tcl_Interp *ip = ipCtxP->interp;
+    CffiAllocOptions opts;
     Tcl_Size size;
     CffiResult ret;
     Tcl_Obj *ptrObj;
     void *p;
+    int i = 2;
+
+    CHECK(CffiAllocOptionsParse(ipCtxP, objc, objv, &i, &opts));
+    if (objc - i < 1 || objc - i > 2) {
+        Tcl_WrongNumArgs(
+            ip, 2, objv, "?-align ALIGNMENT? ?-hugepages? ?-pool POOL? SIZE ?TAG?");
+        return TCL_ERROR;
+    }
 
-    CHECK(CffiParseAllocationSize(ipCtxP, objv[2], &size));
-    p = Tcl_Alloc(size);
+    CHECK(CffiParseAllocationSize(ipCtxP, objv[i], &size));
+    CHECK(CffiMemoryAlloc(ipCtxP, size, &opts, &p));
 
-    ret = CffiMakePointerObj(ipCtxP, p, objc == 4 ? objv[3] : NULL, 0, &ptrObj);
-    if (ret == TCL_OK)
+    ret = CffiMakePointerObj(
+        ipCtxP, p, objc == i + 2 ? objv[i + 1] : NULL, 0, &ptrObj);
+    if (ret == TCL_OK) {
+        CffiPointerRangeRecordAllocation(ipCtxP, p, size);
         Tcl_SetObjResult(ip, ptrObj);
+    }
     else
-        ckfree(p);
+        CffiMemoryFree(ipCtxP, p);
     return ret;
 }
 
@@ -93,14 +413,15 @@ CffiMemoryAllocateCmd(CffiInterpCtx *ipCtxP,
  * objv - argument array.
  * flags - unused
  *
- * The command arguments given in objv[] are
+ * The command arguments given in objv[] are optional allocation options
+ * followed by
  *
- * objv[2] - type declaration
- * objv[3] - initialization value
- * objv[4] - optional tag for returned pointer
+ * - type declaration
+ * - initialization value
+ * - optional tag for returned pointer
  *
- * Allocated memory using *ckalloc*, initializes it and returns a wrapped
- * pointer to it.
+ * Allocates memory as per the options, initializes it and returns a
+ * wrapped pointer to it.
  *
  * Returns:
  * *TCL_OK* on success with wrapped safe pointer as interpreter result,
@@ -113,30 +434,47 @@ CffiMemoryNewCmd(CffiInterpCtx *ipCtxP,
                  CffiFlags flags)
 {
     Tcl_Interp *ip = ipCtxP->interp;
+    CffiAllocOptions opts;
     CffiTypeAndAttrs typeAttrs;
     CffiResult ret;
     Tcl_Size size;
     void *pv;
-
-    CFFI_ASSERT(objc >= 4);
+    int i = 2;
+
+    CHECK(CffiAllocOptionsParse(ipCtxP, objc, objv, &i, &opts));
+    if (objc - i < 2 || objc - i > 3) {
+        Tcl_WrongNumArgs(ip,
+                         2,
+                         objv,
+                         "?-align ALIGNMENT? ?-hugepages? ?-pool POOL? TYPE "
+                         "INITIALIZER ?TAG?");
+        return TCL_ERROR;
+    }
 
     CHECK(CffiTypeSizeForValue(
-        ipCtxP, objv[2], objv[3], &typeAttrs, &size));
+        ipCtxP, objv[i], objv[i + 1], &typeAttrs, &size));
     /* Note typeAttrs needs to be cleaned up beyond this point */
 
-    pv = ckalloc(size);
+    ret = CffiMemoryAlloc(ipCtxP, size, &opts, &pv);
+    if (ret != TCL_OK) {
+        CffiTypeAndAttrsCleanup(&typeAttrs);
+        return ret;
+    }
 
-    ret = CffiNativeValueFromObj(ipCtxP, &typeAttrs, 0, objv[3], 0, pv, 0, NULL);
+    ret = CffiNativeValueFromObj(
+        ipCtxP, &typeAttrs, 0, objv[i + 1], 0, pv, 0, NULL);
     if (ret == TCL_OK) {
         Tcl_Obj *ptrObj;
-        ret =
-            CffiMakePointerObj(ipCtxP, pv, objc == 5 ? objv[4] : NULL, 0, &ptrObj);
-        if (ret == TCL_OK)
+        ret = CffiMakePointerObj(
+            ipCtxP, pv, objc == i + 3 ? objv[i + 2] : NULL, 0, &ptrObj);
+        if (ret == TCL_OK) {
+            CffiPointerRangeRecordAllocation(ipCtxP, pv, size);
             Tcl_SetObjResult(ip, ptrObj);
+        }
     }
 
     if (ret != TCL_OK)
-        ckfree(pv);
+        CffiMemoryFree(ipCtxP, pv);
     CffiTypeAndAttrsCleanup(&typeAttrs);
     return ret;
 }
@@ -153,7 +491,9 @@ CffiMemoryNewCmd(CffiInterpCtx *ipCtxP,
  *
  * Unregisters the wrapped pointer in *objv[2]* and frees the memory.
  * The pointer must have been previously allocated with one of
- * the extensions allocation calls.
+ * the extensions allocation calls. Pointers returned by *memory map* and
+ * *memory shm* are unmapped and other allocations released with
+ * <CffiMemoryFree>.
  *
  * The function will take no action if the pointer is NULL.
  *
@@ -173,9 +513,22 @@ CffiMemoryFreeCmd(CffiInterpCtx *ipCtxP,
     CHECK(Tclh_PointerUnwrap(ip, objv[2], &pv));
     if (pv == NULL)
         return TCL_OK;
+    CffiPointerRegistryChanged(ipCtxP);
     ret = Tclh_PointerUnregister(ip, ipCtxP->tclhCtxP, pv);
-    if (ret == TCL_OK)
-        ckfree(pv);
+    if (ret == TCL_OK) {
+        /* In case it was a struct array, also registered as a range */
+        CffiPointerRangeUnregister(ipCtxP, pv);
+        if (ipCtxP->memoryViewsP)
+            CffiMemoryViewsRelease(ipCtxP, pv, 1, 1);
+        if (ipCtxP->memoryMappingsP) {
+            CffiMemoryMapping *mapP = CffiMemoryMappingRemove(ipCtxP, pv);
+            if (mapP) {
+                CffiMemoryMappingFree(mapP);
+                return TCL_OK;
+            }
+        }
+        CffiMemoryFree(ipCtxP, pv);
+    }
     return ret;
 }
 
@@ -211,7 +564,7 @@ CffiMemoryFromBinaryCmd(CffiInterpCtx *ipCtxP,
     void *p;
     Tcl_Size len;
 
-    bytes = Tcl_GetByteArrayFromObj(objv[2], &len);
+    bytes = CffiGetByteArrayFromObj(objv[2], &len);
     p = ckalloc(len);
     memmove(p, bytes, len);
     if (objc == 4) {
@@ -220,11 +573,15 @@ CffiMemoryFromBinaryCmd(CffiInterpCtx *ipCtxP,
     }
     else
         tagObj = NULL;
+    /* Registration may replace tag of a stale registration */
+    CffiPointerRegistering(ipCtxP, p);
     ret = Tclh_PointerRegister(ip, ipCtxP->tclhCtxP, p, tagObj, &ptrObj);
     if (tagObj)
         Tcl_DecrRefCount(tagObj);
-    if (ret == TCL_OK)
+    if (ret == TCL_OK) {
+        CffiPointerRangeRecordAllocation(ipCtxP, p, len);
         Tcl_SetObjResult(ip, ptrObj);
+    }
     else
         ckfree(p);
     return ret;
@@ -264,8 +621,7 @@ CffiMemoryToBinaryCmd(CffiInterpCtx *ipCtxP,
     if (flags & CFFI_F_ALLOW_UNSAFE)
         CHECK(Tclh_PointerUnwrap(ip, objv[2], &pv));
     else
-        CHECK(Tclh_PointerObjVerify(
-            ip, ipCtxP->tclhCtxP, objv[2], &pv, NULL, NULL));
+        CHECK(CffiPointerObjVerify(ipCtxP, objv[2], &pv));
 
     if (pv == NULL)
         return Tclh_ErrorPointerNull(ip);
@@ -288,6 +644,279 @@ CffiMemoryToBinaryCmd(CffiInterpCtx *ipCtxP,
     return TCL_OK;
 }
 
+/*
+ * Tcl_ObjType for memory views. The internal representation references
+ * native memory without copying it. Commands that take binary values
+ * use the native memory directly through <CffiGetByteArrayFromObj>. Any
+ * other access as a Tcl value generates the string representation. For
+ * views still attached to native memory, this discards the internal
+ * representation so the value is then a snapshot of the bytes and no
+ * longer tracks the native memory.
+ *
+ * Views are attached to the interpreter context so they can be detached
+ * before the native memory is released. See <CffiMemoryViewsRelease>.
+ */
+static void CffiMemoryViewFreeIntRep(Tcl_Obj *objP);
+static void CffiMemoryViewDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj);
+static void CffiMemoryViewUpdateString(Tcl_Obj *objP);
+
+static const Tcl_ObjType cffiMemoryViewObjType = {
+    "cffi-memoryview",
+    CffiMemoryViewFreeIntRep,
+    CffiMemoryViewDupIntRep,
+    CffiMemoryViewUpdateString,
+    NULL,
+};
+
+static void
+CffiMemoryViewUnlink(CffiMemoryView *viewP)
+{
+    CffiInterpCtx *ipCtxP = viewP->ipCtxP;
+    CFFI_ASSERT(ipCtxP);
+    if (viewP->prevP)
+        viewP->prevP->nextP = viewP->nextP;
+    else
+        ipCtxP->memoryViewsP = viewP->nextP;
+    if (viewP->nextP)
+        viewP->nextP->prevP = viewP->prevP;
+    viewP->nextP  = NULL;
+    viewP->prevP  = NULL;
+    viewP->ipCtxP = NULL;
+}
+
+static void
+CffiMemoryViewFreeIntRep(Tcl_Obj *objP)
+{
+    CffiMemoryView *viewP =
+        (CffiMemoryView *)objP->internalRep.twoPtrValue.ptr1;
+    if (--viewP->nRefs <= 0) {
+        if (viewP->ipCtxP)
+            CffiMemoryViewUnlink(viewP);
+        else if (viewP->bytesP)
+            ckfree(viewP->bytesP); /* Private copy */
+        ckfree(viewP);
+    }
+    objP->typePtr = NULL;
+}
+
+static void
+CffiMemoryViewDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj)
+{
+    CffiMemoryView *viewP =
+        (CffiMemoryView *)srcObj->internalRep.twoPtrValue.ptr1;
+    viewP->nRefs += 1;
+    dstObj->internalRep.twoPtrValue.ptr1 = viewP;
+    dstObj->internalRep.twoPtrValue.ptr2 = NULL;
+    dstObj->typePtr = &cffiMemoryViewObjType;
+}
+
+static void
+CffiMemoryViewUpdateString(Tcl_Obj *objP)
+{
+    CffiMemoryView *viewP =
+        (CffiMemoryView *)objP->internalRep.twoPtrValue.ptr1;
+    Tcl_Size i, len;
+    char *p;
+
+    /* Same representation as Tcl byte arrays. NUL and bytes >= 0x80 take 2 */
+    len = viewP->size;
+    for (i = 0; i < viewP->size; ++i) {
+        if (viewP->bytesP[i] == 0 || viewP->bytesP[i] >= 0x80)
+            ++len;
+    }
+    p = ckalloc(len + 1);
+    objP->bytes  = p;
+    objP->length = len;
+    for (i = 0; i < viewP->size; ++i) {
+        unsigned char b = viewP->bytesP[i];
+        if (b == 0 || b >= 0x80) {
+            *p++ = (char)(0xC0 | (b >> 6));
+            *p++ = (char)(0x80 | (b & 0x3F));
+        }
+        else
+            *p++ = (char)b;
+    }
+    *p = '\0';
+
+    /*
+     * The string is a snapshot. Drop an attached view so binary access does
+     * not see later changes to native memory that the string does not
+     * reflect. A detached view holds a private copy that cannot change and
+     * is kept as its bytes may be in use by a function call in progress.
+     */
+    if (viewP->ipCtxP)
+        CffiMemoryViewFreeIntRep(objP);
+}
+
+/* Function: CffiGetByteArrayFromObj
+ * Returns the bytes of a binary value.
+ *
+ * Parameters:
+ * objP - binary value
+ * lenP - location to store number of bytes. May be NULL.
+ *
+ * This is a replacement for *Tcl_GetByteArrayFromObj* that does not
+ * shimmer memory views but returns the viewed bytes directly. The returned
+ * memory must be treated as read-only.
+ *
+ * Returns:
+ * Pointer to the bytes.
+ */
+unsigned char *
+CffiGetByteArrayFromObj(Tcl_Obj *objP, Tcl_Size *lenP)
+{
+    if (objP->typePtr == &cffiMemoryViewObjType) {
+        CffiMemoryView *viewP =
+            (CffiMemoryView *)objP->internalRep.twoPtrValue.ptr1;
+        static unsigned char empty;
+        if (lenP)
+            *lenP = viewP->size;
+        return viewP->bytesP ? viewP->bytesP : &empty;
+    }
+    return Tcl_GetByteArrayFromObj(objP, lenP);
+}
+
+/* Function: CffiIsMemoryViewObj
+ * Returns non-0 if the passed Tcl_Obj is a memory view, 0 otherwise.
+ */
+int
+CffiIsMemoryViewObj(Tcl_Obj *objP)
+{
+    return objP->typePtr == &cffiMemoryViewObjType;
+}
+
+/* Function: CffiMemoryViewsRelease
+ * Detaches memory views from native memory that is being released.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - start of the memory being released
+ * len - size of the memory. Views created from pointers in the range
+ *       *pv* to *pv+len* are detached.
+ * copy - if non-0, detached views are given a private copy of the viewed
+ *        bytes. Otherwise, they become empty. The latter must be used
+ *        when the native memory may already have been freed.
+ */
+void
+CffiMemoryViewsRelease(CffiInterpCtx *ipCtxP,
+                       void *pv,
+                       Tcl_Size len,
+                       int copy)
+{
+    CffiMemoryView *viewP;
+    CffiMemoryView *nextP;
+
+    for (viewP = ipCtxP->memoryViewsP; viewP; viewP = nextP) {
+        nextP = viewP->nextP;
+        if ((char *)viewP->basePv < (char *)pv
+            || (char *)viewP->basePv >= len + (char *)pv)
+            continue;
+        CffiMemoryViewUnlink(viewP);
+        if (copy && viewP->size) {
+            unsigned char *bytesP = ckalloc(viewP->size);
+            memcpy(bytesP, viewP->bytesP, viewP->size);
+            viewP->bytesP = bytesP;
+        }
+        else {
+            viewP->bytesP = NULL;
+            viewP->size   = 0;
+        }
+    }
+}
+
+/* Function: CffiMemoryViewsCleanup
+ * Detaches all memory views of an interpreter context.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * Views are given a private copy of their bytes so they remain usable
+ * after the interpreter context is deleted.
+ */
+void
+CffiMemoryViewsCleanup(CffiInterpCtx *ipCtxP)
+{
+    while (ipCtxP->memoryViewsP) {
+        CffiMemoryViewsRelease(
+            ipCtxP, ipCtxP->memoryViewsP->basePv, 1, 1);
+    }
+}
+
+/* Function: CffiMemoryViewCmd
+ * Implements the *memory view* script level command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * objc - count of elements in objv[]. Should be 4 or 5 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - unused
+ *
+ * Returns a read-only binary value that references the *objv[3]* bytes of
+ * memory at offset *objv[4]* from the safe pointer in *objv[2]* without
+ * copying them. The view is detached, with a private copy of the bytes,
+ * when the pointer is freed or disposed. If the pointer lies in a
+ * registered address range, the viewed bytes must lie within it.
+ *
+ * Returns:
+ * *TCL_OK* on success with the view as interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemoryViewCmd(CffiInterpCtx *ipCtxP,
+                  int objc,
+                  Tcl_Obj *const objv[],
+                  CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiMemoryView *viewP;
+    Tcl_Obj *viewObj;
+    void *pv;
+    char *endP;
+    unsigned int len;
+    Tcl_WideInt off;
+
+    CHECK(CffiPointerObjVerify(ipCtxP, objv[2], &pv));
+    if (pv == NULL)
+        return Tclh_ErrorPointerNull(ip);
+
+    CHECK(Tclh_ObjToUInt(ip, objv[3], &len));
+
+    if (objc < 5)
+        off = 0;
+    else {
+        CHECK(Tclh_ObjToRangedInt(ip, objv[4], 0, INT_MAX, &off));
+    }
+
+    if (ipCtxP->nPointerRanges && CffiPointerRangeBounds(ipCtxP, pv, &endP)
+        && (endP - (char *)pv) < (off + len)) {
+        return Tclh_ErrorInvalidValue(
+            ip,
+            objv[2],
+            "Memory region extends beyond the end of the allocation.");
+    }
+
+    viewP         = ckalloc(sizeof(*viewP));
+    viewP->ipCtxP = ipCtxP;
+    viewP->basePv = pv;
+    viewP->bytesP = off + (unsigned char *)pv;
+    viewP->size   = len;
+    viewP->nRefs  = 1;
+    viewP->prevP  = NULL;
+    viewP->nextP  = ipCtxP->memoryViewsP;
+    if (viewP->nextP)
+        viewP->nextP->prevP = viewP;
+    ipCtxP->memoryViewsP = viewP;
+
+    viewObj = Tcl_NewObj();
+    Tcl_InvalidateStringRep(viewObj);
+    viewObj->internalRep.twoPtrValue.ptr1 = viewP;
+    viewObj->internalRep.twoPtrValue.ptr2 = NULL;
+    viewObj->typePtr = &cffiMemoryViewObjType;
+    Tcl_SetObjResult(ip, viewObj);
+    return TCL_OK;
+}
+
 /* Function: CffiMemoryFromUniStringCmd
  * Implements the *memory fromunistring* script level command.
  *
@@ -322,9 +951,13 @@ CffiMemoryFromUniStringCmd(CffiInterpCtx *ipCtxP,
     p   = ckalloc(sizeof(Tcl_UniChar) * (len+1));
     memmove(p, uniP, sizeof(Tcl_UniChar)*(len+1));
 
+    CffiPointerRegistering(ipCtxP, p);
     ret = Tclh_PointerRegister(ip, ipCtxP->tclhCtxP, p, NULL, &ptrObj);
-    if (ret == TCL_OK)
+    if (ret == TCL_OK) {
+        CffiPointerRangeRecordAllocation(
+            ipCtxP, p, sizeof(Tcl_UniChar) * (len + 1));
         Tcl_SetObjResult(ip, ptrObj);
+    }
     else
         ckfree(p);
     return ret;
@@ -364,9 +997,13 @@ CffiMemoryFromWinStringCmd(CffiInterpCtx *ipCtxP,
     if (wsP == NULL) {
         return Tclh_ErrorGeneric(ip, NULL, "Could not convert to winstring");
     }
+    CffiPointerRegistering(ipCtxP, wsP);
     ret = Tclh_PointerRegister(ip, ipCtxP->tclhCtxP, wsP, NULL, &ptrObj);
-    if (ret == TCL_OK)
+    if (ret == TCL_OK) {
+        CffiPointerRangeRecordAllocation(
+            ipCtxP, wsP, sizeof(WCHAR) * (len + 1));
         Tcl_SetObjResult(ip, ptrObj);
+    }
     else
         ckfree(wsP);
     return ret;
@@ -429,9 +1066,12 @@ CffiMemoryFromStringCmd(CffiInterpCtx *ipCtxP,
     }
     Tcl_DStringFree(&ds);
 
+    CffiPointerRegistering(ipCtxP, p);
     ret = Tclh_PointerRegister(ip, ipCtxP->tclhCtxP, p, NULL, &ptrObj);
-    if (ret == TCL_OK)
+    if (ret == TCL_OK) {
+        CffiPointerRangeRecordAllocation(ipCtxP, p, len + 4);
         Tcl_SetObjResult(ip, ptrObj);
+    }
     else
         ckfree(p);
     return ret;
@@ -472,8 +1112,7 @@ CffiMemoryToUniStringCmd(CffiInterpCtx *ipCtxP,
     if (flags & CFFI_F_ALLOW_UNSAFE)
         CHECK(Tclh_PointerUnwrap(ip, objv[2], &pv));
     else
-        CHECK(Tclh_PointerObjVerify(
-            ip, ipCtxP->tclhCtxP, objv[2], &pv, NULL, NULL));
+        CHECK(CffiPointerObjVerify(ipCtxP, objv[2], &pv));
 
     if (pv == NULL)
         return Tclh_ErrorPointerNull(ip);
@@ -528,8 +1167,7 @@ CffiMemoryToWinStringCmd(CffiInterpCtx *ipCtxP,
     if (flags & CFFI_F_ALLOW_UNSAFE)
         CHECK(Tclh_PointerUnwrap(ip, objv[2], &pv));
     else
-        CHECK(Tclh_PointerObjVerify(
-            ip, ipCtxP->tclhCtxP, objv[2], &pv, NULL, NULL));
+        CHECK(CffiPointerObjVerify(ipCtxP, objv[2], &pv));
 
     if (pv == NULL)
         return Tclh_ErrorPointerNull(ip);
@@ -587,8 +1225,7 @@ CffiMemoryToStringCmd(CffiInterpCtx *ipCtxP,
     if (flags & CFFI_F_ALLOW_UNSAFE)
         CHECK(Tclh_PointerUnwrap(ip, objv[2], &pv));
     else
-        CHECK(Tclh_PointerObjVerify(
-            ip, ipCtxP->tclhCtxP, objv[2], &pv, NULL, NULL));
+        CHECK(CffiPointerObjVerify(ipCtxP, objv[2], &pv));
 
     if (pv == NULL)
         return Tclh_ErrorPointerNull(ip);
@@ -633,6 +1270,48 @@ CffiMemoryToStringCmd(CffiInterpCtx *ipCtxP,
     return TCL_OK;
 }
 
+/* Function: CffiMemoryCheckTypeBounds
+ * Checks an indexed value of a type lies within the registered address
+ * range, if any, containing a pointer.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * ptrObj - wrapped pointer for error messages
+ * pv - the pointer value
+ * indx - index into an array of values of the type starting at *pv*
+ * typeAttrsP - type of the value
+ *
+ * Pointers that do not lie in a registered address range, such as those
+ * returned by C functions, are not checked as their size is not known.
+ *
+ * Returns:
+ * *TCL_OK* if in bounds or bounds are not known, *TCL_ERROR* with error
+ * message in interpreter otherwise.
+ */
+static CffiResult
+CffiMemoryCheckTypeBounds(CffiInterpCtx *ipCtxP,
+                          Tcl_Obj *ptrObj,
+                          void *pv,
+                          unsigned int indx,
+                          const CffiTypeAndAttrs *typeAttrsP)
+{
+    char *endP;
+    Tcl_WideInt size;
+
+    if (ipCtxP->nPointerRanges == 0
+        || CffiTypeIsVariableSize(&typeAttrsP->dataType)
+        || !CffiPointerRangeBounds(ipCtxP, pv, &endP))
+        return TCL_OK;
+    size = CffiTypeActualSize(&typeAttrsP->dataType);
+    if ((endP - (char *)pv) < (indx + 1) * size) {
+        return Tclh_ErrorInvalidValue(
+            ipCtxP->interp,
+            ptrObj,
+            "Memory region extends beyond the end of the allocation.");
+    }
+    return TCL_OK;
+}
+
 /* Function: CffiMemoryGetCmd
  * Implements the *memory get* script level command.
  *
@@ -651,6 +1330,8 @@ CffiMemoryToStringCmd(CffiInterpCtx *ipCtxP,
  *
  * The passed in pointer should be registered unless the CFFI_F_ALLOW_UNSAFE of *flags*
  * is set. A *NULL* pointer will raise an error.
+ * For safe pointers lying in a registered address range, such as memory
+ * mappings, the value must lie within the range.
  *
  * Returns:
  * *TCL_OK* on success with Tcl string value as interpreter result,
@@ -677,16 +1358,22 @@ CffiMemoryGetCmd(CffiInterpCtx *ipCtxP,
 
     CHECK(CffiMemoryAddressFromObj(ipCtxP, objv[2], flags & CFFI_F_ALLOW_UNSAFE, &pv));
 
-    CHECK(CffiTypeAndAttrsParse(
+    CHECK(CffiTypeAndAttrsParseCached(
         ipCtxP, objv[3], CFFI_F_TYPE_PARSE_FIELD, &typeAttrs));
     /* Note typeAttrs needs to be cleaned up beyond this point */
 
-    ret = CffiNativeValueToObj(ipCtxP,
-                               &typeAttrs,
-                               pv,
-                               indx,
-                               typeAttrs.dataType.arraySize,
-                               &resultObj);
+    if (flags & CFFI_F_ALLOW_UNSAFE)
+        ret = TCL_OK;
+    else
+        ret = CffiMemoryCheckTypeBounds(ipCtxP, objv[2], pv, indx, &typeAttrs);
+    if (ret == TCL_OK) {
+        ret = CffiNativeValueToObj(ipCtxP,
+                                   &typeAttrs,
+                                   pv,
+                                   indx,
+                                   typeAttrs.dataType.arraySize,
+                                   &resultObj);
+    }
     if (ret == TCL_OK)
         Tcl_SetObjResult(ipCtxP->interp, resultObj);
     CffiTypeAndAttrsCleanup(&typeAttrs);
@@ -711,6 +1398,8 @@ CffiMemoryGetCmd(CffiInterpCtx *ipCtxP,
  *
  * The passed in pointer should be registered unless the CFFI_F_ALLOW_UNSAFE of *flags*
  * is set. A *NULL* pointer will raise an error.
+ * For safe pointers lying in a registered address range, such as memory
+ * mappings, the value must lie within the range.
  *
  * Returns:
  * *TCL_OK* on success with Tcl string value as interpreter result,
@@ -736,13 +1425,26 @@ CffiMemorySetCmd(CffiInterpCtx *ipCtxP,
 
     CHECK(CffiMemoryAddressFromObj(
         ipCtxP, objv[2], flags & CFFI_F_ALLOW_UNSAFE, &pv));
+    CHECK(CffiMemoryCheckWritable(ipCtxP, objv[2], pv));
 
-    CHECK(CffiTypeAndAttrsParse(
+    CHECK(CffiTypeAndAttrsParseCached(
         ipCtxP, objv[3], CFFI_F_TYPE_PARSE_FIELD, &typeAttrs));
     /* Note typeAttrs needs to be cleaned up beyond this point */
 
-    ret = CffiNativeValueFromObj(
-        ipCtxP, &typeAttrs, 0, objv[4], CFFI_F_PRESERVE_ON_ERROR, pv, indx, NULL);
+    if (flags & CFFI_F_ALLOW_UNSAFE)
+        ret = TCL_OK;
+    else
+        ret = CffiMemoryCheckTypeBounds(ipCtxP, objv[2], pv, indx, &typeAttrs);
+    if (ret == TCL_OK) {
+        ret = CffiNativeValueFromObj(ipCtxP,
+                                     &typeAttrs,
+                                     0,
+                                     objv[4],
+                                     CFFI_F_PRESERVE_ON_ERROR,
+                                     pv,
+                                     indx,
+                                     NULL);
+    }
 
     CffiTypeAndAttrsCleanup(&typeAttrs);
     return ret;
@@ -756,7 +1458,9 @@ CffiMemorySetCmd(CffiInterpCtx *ipCtxP,
  * objc - count of elements in objv[]. Should be 5 or 6 including command
  *        and subcommand.
  * objv - argument array.
- * flags - unused
+ * flags - CFFI_F_ALLOW_UNSAFE if the pointer is not to be verified.
+ *
+ * The region is resolved and bounds checked as for *memory copy*.
  *
  * Returns:
  * *TCL_OK* on success with an empty string value as interpreter result,
@@ -769,37 +1473,886 @@ CffiMemoryFillCmd(CffiInterpCtx *ipCtxP,
                   CffiFlags flags)
 {
     Tcl_Interp *ip = ipCtxP->interp;
-    void *pv;
+    char *regionP;
     Tcl_WideInt len;
-    Tcl_WideInt off;
     unsigned char val;
 
-    if (flags & CFFI_F_ALLOW_UNSAFE) {
-        CHECK(Tclh_PointerUnwrap(ip, objv[2], &pv));
-    }
-    else
-        CHECK(Tclh_PointerObjVerify(
-            ip, ipCtxP->tclhCtxP, objv[2], &pv, NULL, NULL));
+    CHECK(Tclh_ObjToUChar(ip, objv[3], &val));
+    CHECK(Tclh_ObjToRangedInt(ip, objv[4], 0, INT_MAX, &len));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[2], objc > 5 ? objv[5] : NULL, len, flags, &regionP));
+    CHECK(CffiMemoryCheckWritable(ipCtxP, objv[2], regionP));
+    memset(regionP, val, (int) len);
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryRegionFromObjs
+ * Resolves a pointer, offset and size to a memory region.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * ptrObj - wrapped pointer
+ * offObj - offset from pointer. May be NULL in which case offset is 0.
+ * size - size of the region
+ * flags - if CFFI_F_ALLOW_UNSAFE is set, the pointer is not verified
+ *         and negative offsets are permitted
+ * regionPP - location to store address of the region
+ *
+ * For safe pointers that lie within a registered address range, such as
+ * memory allocated by the extension, the region must lie within the range.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in the interpreter.
+ */
+static CffiResult
+CffiMemoryRegionFromObjs(CffiInterpCtx *ipCtxP,
+                         Tcl_Obj *ptrObj,
+                         Tcl_Obj *offObj,
+                         Tcl_WideInt size,
+                         CffiFlags flags,
+                         char **regionPP)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    void *pv;
+    Tcl_WideInt off;
+    char *endP;
 
+    if (flags & CFFI_F_ALLOW_UNSAFE)
+        CHECK(Tclh_PointerUnwrap(ip, ptrObj, &pv));
+    else
+        CHECK(CffiPointerObjVerify(ipCtxP, ptrObj, &pv));
     if (pv == NULL)
         return Tclh_ErrorPointerNull(ip);
 
-    CHECK(Tclh_ObjToUChar(ip, objv[3], &val));
-    CHECK(Tclh_ObjToRangedInt(ip, objv[4], 0, INT_MAX, &len));
-
-    if (objc < 6)
+    if (offObj == NULL)
         off = 0;
     else {
-        CHECK(Tclh_ObjToRangedInt(ip, objv[5], INT_MIN, INT_MAX, &off));
+        CHECK(Tclh_ObjToRangedInt(ip, offObj, INT_MIN, INT_MAX, &off));
         if (off < 0 && !(flags & CFFI_F_ALLOW_UNSAFE)) {
+            return Tclh_ErrorInvalidValue(
+                ip, offObj, "Negative offsets are not allowed for safe pointers.");
+        }
+    }
+
+    if (!(flags & CFFI_F_ALLOW_UNSAFE) && ipCtxP->nPointerRanges
+        && CffiPointerRangeBounds(ipCtxP, pv, &endP)
+        && (endP - (char *)pv) < (off + size)) {
+        return Tclh_ErrorInvalidValue(
+            ip,
+            ptrObj,
+            "Memory region extends beyond the end of the allocation.");
+    }
+
+    *regionPP = off + (char *)pv;
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryCopyCmd
+ * Implements the *memory copy* and *memory move* script level commands.
+ *
+ * Parameters:
+ * ip - interpreter
+ * objc - count of elements in objv[]. Should be 5 to 7 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - CFFI_F_ALLOW_UNSAFE if pointers are not to be verified. Also
+ *         CFFI_F_ALLOW_OVERLAP if source and destination may overlap.
+ *
+ * Copies *objv[4]* bytes from the pointer *objv[3]* at optional offset
+ * *objv[6]* to the pointer *objv[2]* at optional offset *objv[5]*.
+ *
+ * Returns:
+ * *TCL_OK* on success with an empty string value as interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemoryCopyCmd(CffiInterpCtx *ipCtxP,
+                  int objc,
+                  Tcl_Obj *const objv[],
+                  CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    char *dstP;
+    char *srcP;
+    Tcl_WideInt len;
+
+    CHECK(Tclh_ObjToRangedInt(ip, objv[4], 0, TCL_SIZE_MAX, &len));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[2], objc > 5 ? objv[5] : NULL, len, flags, &dstP));
+    CHECK(CffiMemoryCheckWritable(ipCtxP, objv[2], dstP));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[3], objc > 6 ? objv[6] : NULL, len, flags, &srcP));
+
+    if (flags & CFFI_F_ALLOW_OVERLAP)
+        memmove(dstP, srcP, len);
+    else {
+        if (dstP < srcP + len && srcP < dstP + len) {
             return Tclh_ErrorInvalidValue(
                 ip,
-                objv[5],
-                "Negative offsets are not allowed for safe pointers.");
+                NULL,
+                "Source and destination regions overlap. Use memory move "
+                "instead.");
+        }
+        memcpy(dstP, srcP, len);
+    }
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryCompareCmd
+ * Implements the *memory compare* script level command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * objc - count of elements in objv[]. Should be 5 to 7 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - CFFI_F_ALLOW_UNSAFE if pointers are not to be verified.
+ *
+ * Compares *objv[4]* bytes at the pointers *objv[2]* and *objv[3]* at
+ * optional offsets *objv[5]* and *objv[6]* respectively.
+ *
+ * Returns:
+ * *TCL_OK* on success with -1, 0 or 1 as the interpreter result depending on
+ * whether the first memory region is less, equal or greater than the second,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemoryCompareCmd(CffiInterpCtx *ipCtxP,
+                     int objc,
+                     Tcl_Obj *const objv[],
+                     CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    char *p1;
+    char *p2;
+    Tcl_WideInt len;
+    int cmp;
+
+    CHECK(Tclh_ObjToRangedInt(ip, objv[4], 0, TCL_SIZE_MAX, &len));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[2], objc > 5 ? objv[5] : NULL, len, flags, &p1));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[3], objc > 6 ? objv[6] : NULL, len, flags, &p2));
+
+    cmp = memcmp(p1, p2, len);
+    Tcl_SetObjResult(ip, Tcl_NewIntObj(cmp < 0 ? -1 : (cmp > 0 ? 1 : 0)));
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryFindCmd
+ * Implements the *memory find* script level command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * objc - count of elements in objv[]. Should be 5 or 6 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - CFFI_F_ALLOW_UNSAFE if pointers are not to be verified.
+ *
+ * Searches *objv[3]* bytes at pointer *objv[2]*, starting at the optional
+ * offset *objv[5]*, for the binary value *objv[4]*.
+ *
+ * Returns:
+ * *TCL_OK* on success with the offset of the first match from the
+ * pointer or -1 if there was no match as the interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemoryFindCmd(CffiInterpCtx *ipCtxP,
+                  int objc,
+                  Tcl_Obj *const objv[],
+                  CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    char *regionP;
+    char *endP;
+    char *p;
+    const unsigned char *patP;
+    Tcl_Size patLen;
+    Tcl_WideInt len;
+    Tcl_WideInt off;
+
+    CHECK(Tclh_ObjToRangedInt(ip, objv[3], 0, TCL_SIZE_MAX, &len));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[2], objc > 5 ? objv[5] : NULL, len, flags, &regionP));
+    if (objc > 5)
+        CHECK(Tclh_ObjToRangedInt(ip, objv[5], INT_MIN, INT_MAX, &off));
+    else
+        off = 0;
+
+    patP = CffiGetByteArrayFromObj(objv[4], &patLen);
+    if (patLen == 0) {
+        Tcl_SetObjResult(ip, Tcl_NewWideIntObj(off));
+        return TCL_OK;
+    }
+
+    if (patLen > len) {
+        Tcl_SetObjResult(ip, Tcl_NewIntObj(-1));
+        return TCL_OK;
+    }
+
+    /* Scan for the first byte and then compare the rest */
+    endP = regionP + len - patLen; /* Last possible match position */
+    for (p = regionP; p <= endP; ++p) {
+        p = memchr(p, patP[0], endP - p + 1);
+        if (p == NULL)
+            break;
+        if (memcmp(p + 1, patP + 1, patLen - 1) == 0) {
+            Tcl_SetObjResult(ip, Tcl_NewWideIntObj(off + (p - regionP)));
+            return TCL_OK;
+        }
+    }
+    Tcl_SetObjResult(ip, Tcl_NewIntObj(-1));
+    return TCL_OK;
+}
+
+/* CRC-32C (Castagnoli) table for reflected polynomial 0x82F63B78 */
+static const unsigned int cffiCrc32cTable[256] = {
+    0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+    0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+    0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+    0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+    0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+    0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+    0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+    0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+    0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+    0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+    0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+    0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+    0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+    0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+    0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+    0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+    0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+    0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+    0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+    0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+    0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+    0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+    0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+    0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+    0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+    0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+    0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+    0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+    0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+    0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+    0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+    0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+    0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+    0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+    0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+    0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+    0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+    0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+    0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+    0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+    0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+    0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+    0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351,
+};
+
+/* Function: CffiMemoryHashCmd
+ * Implements the *memory hash* script level command.
+ *
+ * Parameters:
+ * ip - interpreter
+ * objc - count of elements in objv[]. Should be 4 or 5 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - CFFI_F_ALLOW_UNSAFE if pointers are not to be verified.
+ *
+ * Computes the CRC-32C checksum of *objv[3]* bytes at pointer *objv[2]* at
+ * the optional offset *objv[4]*.
+ *
+ * Returns:
+ * *TCL_OK* on success with the checksum as an unsigned integer value
+ * as the interpreter result, *TCL_ERROR* on failure with error message
+ * in interpreter.
+ */
+static CffiResult
+CffiMemoryHashCmd(CffiInterpCtx *ipCtxP,
+                  int objc,
+                  Tcl_Obj *const objv[],
+                  CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    const unsigned char *p;
+    char *regionP;
+    Tcl_WideInt len;
+    Tcl_WideInt i;
+    unsigned int crc = 0xFFFFFFFF;
+
+    CHECK(Tclh_ObjToRangedInt(ip, objv[3], 0, TCL_SIZE_MAX, &len));
+    CHECK(CffiMemoryRegionFromObjs(
+        ipCtxP, objv[2], objc > 4 ? objv[4] : NULL, len, flags, &regionP));
+
+    p = (const unsigned char *)regionP;
+    for (i = 0; i < len; ++i)
+        crc = cffiCrc32cTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    crc ^= 0xFFFFFFFF;
+
+    Tcl_SetObjResult(ip, Tcl_NewWideIntObj((Tcl_WideInt)crc));
+    return TCL_OK;
+}
+
+/*
+ * Memory mapped files and shared memory.
+ *
+ * Mappings are returned to the script as safe pointers that are also
+ * registered as address ranges so the memory commands can bounds check
+ * accesses and *memory size* can return the mapped length. The mapping is
+ * released by *memory free*.
+ */
+#ifdef _WIN32
+typedef HANDLE CffiMapSource; /* File mapping object handle */
+#else
+typedef int CffiMapSource;    /* File descriptor */
+#endif
+
+/* Function: CffiMemoryMappingFree
+ * Unmaps a memory mapping and frees its descriptor.
+ *
+ * Parameters:
+ * mapP - mapping descriptor. Must not be linked into the interpreter list.
+ */
+static void
+CffiMemoryMappingFree(CffiMemoryMapping *mapP)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(mapP->baseP);
+#else
+    munmap(mapP->baseP, mapP->mappedSize);
+#endif
+    ckfree(mapP);
+}
+
+/* Function: CffiMemoryMappingRemove
+ * Removes the mapping for an address from the interpreter's mapping list.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address returned by *memory map* or *memory shm*
+ *
+ * Returns:
+ * The mapping descriptor or *NULL* if *pv* is not a mapped address.
+ */
+static CffiMemoryMapping *
+CffiMemoryMappingRemove(CffiInterpCtx *ipCtxP, void *pv)
+{
+    CffiMemoryMapping **prevPP;
+    for (prevPP = &ipCtxP->memoryMappingsP; *prevPP;
+         prevPP = &(*prevPP)->nextP) {
+        CffiMemoryMapping *mapP = *prevPP;
+        if (mapP->pv == pv) {
+            *prevPP = mapP->nextP;
+            return mapP;
         }
     }
+    return NULL;
+}
 
-    memset(off + (char *)pv, val, (int) len);
+/* Function: CffiMemoryMappingsCleanup
+ * Unmaps all mappings for an interpreter.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ *
+ * Called at interpreter deletion. Pointer and range registrations are not
+ * removed as the registries are themselves being deleted.
+ */
+void
+CffiMemoryMappingsCleanup(CffiInterpCtx *ipCtxP)
+{
+    while (ipCtxP->memoryMappingsP) {
+        CffiMemoryMapping *mapP = ipCtxP->memoryMappingsP;
+        ipCtxP->memoryMappingsP = mapP->nextP;
+        CffiMemoryMappingFree(mapP);
+    }
+}
+
+/* Function: CffiMemoryMappingRelease
+ * Unmaps the mapping for an address if there is one.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address whose registration has been removed other than through
+ *   *memory free*, for example by *pointer dispose*
+ *
+ * The mapping can no longer be released by the script once the pointer
+ * is no longer registered so it is unmapped here. The caller must have
+ * already removed the address range and detached any memory views.
+ */
+void
+CffiMemoryMappingRelease(CffiInterpCtx *ipCtxP, void *pv)
+{
+    CffiMemoryMapping *mapP = CffiMemoryMappingRemove(ipCtxP, pv);
+    if (mapP)
+        CffiMemoryMappingFree(mapP);
+}
+
+/* Function: CffiMemoryCheckWritable
+ * Verifies an address does not lie in a read-only memory mapping.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * ptrObj - wrapped pointer for error messages
+ * pv - address to be written
+ *
+ * Writes to a mapping created with *-readonly* would fault so script level
+ * commands that write native memory must check the target address.
+ *
+ * Returns:
+ * *TCL_OK* if the address may be written, *TCL_ERROR* with error message
+ * in the interpreter otherwise.
+ */
+CffiResult
+CffiMemoryCheckWritable(CffiInterpCtx *ipCtxP,
+                        Tcl_Obj *ptrObj,
+                        const void *pv)
+{
+    CffiMemoryMapping *mapP;
+    for (mapP = ipCtxP->memoryMappingsP; mapP; mapP = mapP->nextP) {
+        if (mapP->readonly && (const char *)pv >= (char *)mapP->baseP
+            && (const char *)pv < mapP->mappedSize + (char *)mapP->baseP) {
+            return Tclh_ErrorInvalidValue(
+                ipCtxP->interp, ptrObj, "Memory is mapped read-only.");
+        }
+    }
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryMapRegion
+ * Maps a region of a file or shared memory object and returns a safe
+ * pointer to it.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * sourceObj - file path or shared memory name for error messages
+ * source - file descriptor or file mapping handle. Not closed by the
+ *          function.
+ * offset - offset of the region within the mapped object
+ * size - size of the region. Must be positive.
+ * readonly - if non-zero, the region is mapped read-only
+ * tagObj - tag for the returned pointer. May be NULL.
+ *
+ * Returns:
+ * *TCL_OK* on success with the wrapped pointer as the interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemoryMapRegion(CffiInterpCtx *ipCtxP,
+                    Tcl_Obj *sourceObj,
+                    CffiMapSource source,
+                    Tcl_WideInt offset,
+                    Tcl_WideInt size,
+                    int readonly,
+                    Tcl_Obj *tagObj)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiMemoryMapping *mapP;
+    Tcl_Obj *ptrObj;
+    Tcl_WideInt delta;
+    void *baseP;
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    ULONGLONG mapOffset;
+
+    /* View offsets must be a multiple of the allocation granularity */
+    GetSystemInfo(&si);
+    delta     = offset % si.dwAllocationGranularity;
+    mapOffset = (ULONGLONG)(offset - delta);
+    baseP     = MapViewOfFile(source,
+                          readonly ? FILE_MAP_READ : FILE_MAP_WRITE,
+                          (DWORD)(mapOffset >> 32),
+                          (DWORD)mapOffset,
+                          (SIZE_T)(size + delta));
+    if (baseP == NULL)
+        return Tclh_ErrorWindowsError(ip, GetLastError(), NULL);
+#else
+    /* mmap offsets must be a multiple of the page size */
+    delta = offset % sysconf(_SC_PAGESIZE);
+    baseP = mmap(NULL,
+                 (size_t)(size + delta),
+                 readonly ? PROT_READ : (PROT_READ | PROT_WRITE),
+                 MAP_SHARED,
+                 source,
+                 (off_t)(offset - delta));
+    if (baseP == MAP_FAILED) {
+        return Tclh_ErrorOperFailed(
+            ip, "map", sourceObj, Tcl_ErrnoMsg(Tcl_GetErrno()));
+    }
+#endif
+
+    mapP             = ckalloc(sizeof(*mapP));
+    mapP->baseP      = baseP;
+    mapP->mappedSize = (size_t)(size + delta);
+    mapP->pv         = delta + (char *)baseP;
+    mapP->readonly   = readonly;
+
+    if (CffiPointerRangeRegister(ipCtxP, mapP->pv, (Tcl_Size)size) != TCL_OK)
+        goto error_return;
+    if (CffiMakePointerObj(ipCtxP, mapP->pv, tagObj, 0, &ptrObj) != TCL_OK) {
+        CffiPointerRangeUnregister(ipCtxP, mapP->pv);
+        goto error_return;
+    }
+
+    mapP->nextP             = ipCtxP->memoryMappingsP;
+    ipCtxP->memoryMappingsP = mapP;
+    Tcl_SetObjResult(ip, ptrObj);
+    return TCL_OK;
+
+error_return:
+    CffiMemoryMappingFree(mapP);
+    return TCL_ERROR;
+}
+
+/* Function: CffiMemoryMapCmd
+ * Implements the *memory map* script level command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - count of elements in objv[]. At least 3 including command
+ *        and subcommand.
+ * objv - argument array. *objv[2]* is the file path followed by options.
+ * flags - unused
+ *
+ * Maps a region of a file into memory. The region defaults to the whole
+ * file from the offset specified with *-offset*. Changes made through the
+ * returned pointer are written to the file unless *-readonly* is specified.
+ *
+ * Returns:
+ * *TCL_OK* on success with a wrapped safe pointer as the interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemoryMapCmd(CffiInterpCtx *ipCtxP,
+                 int objc,
+                 Tcl_Obj *const objv[],
+                 CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    Tcl_Obj *tagObj = NULL;
+    Tcl_WideInt offset = 0;
+    Tcl_WideInt length = -1;
+    Tcl_WideInt fileSize;
+    int readonly = 0;
+    int i;
+    int optIndex;
+    CffiResult ret;
+    static const char *const opts[] = {
+        "-length", "-offset", "-readonly", "-tag", NULL};
+    enum OPT { LENGTH, OFFSET, READONLY, TAG };
+#ifdef _WIN32
+    const WCHAR *pathP;
+    HANDLE fileH;
+    HANDLE mapH;
+    LARGE_INTEGER li;
+#else
+    const char *pathP;
+    struct stat st;
+    int fd;
+#endif
+
+    for (i = 3; i < objc; ++i) {
+        CHECK(Tcl_GetIndexFromObj(ip, objv[i], opts, "option", 0, &optIndex));
+        if (optIndex == READONLY) {
+            readonly = 1;
+            continue;
+        }
+        if (i == objc - 1)
+            return Tclh_ErrorOptionValueMissing(ip, objv[i], NULL);
+        ++i;
+        switch (optIndex) {
+        case LENGTH:
+            CHECK(Tclh_ObjToRangedInt(ip, objv[i], 1, TCL_SIZE_MAX, &length));
+            break;
+        case OFFSET:
+            CHECK(Tcl_GetWideIntFromObj(ip, objv[i], &offset));
+            if (offset < 0) {
+                return Tclh_ErrorInvalidValue(
+                    ip, objv[i], "Offset must not be negative.");
+            }
+            break;
+        case TAG:
+            tagObj = objv[i];
+            break;
+        }
+    }
+
+    pathP = Tcl_FSGetNativePath(objv[2]);
+    if (pathP == NULL)
+        return Tclh_ErrorInvalidValue(ip, objv[2], "Invalid file path.");
+
+#ifdef _WIN32
+    fileH = CreateFileW(pathP,
+                        readonly ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE),
+                        FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        NULL,
+                        OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL,
+                        NULL);
+    if (fileH == INVALID_HANDLE_VALUE)
+        return Tclh_ErrorWindowsError(ip, GetLastError(), NULL);
+    if (!GetFileSizeEx(fileH, &li)) {
+        ret = Tclh_ErrorWindowsError(ip, GetLastError(), NULL);
+        goto vamoose;
+    }
+    fileSize = li.QuadPart;
+#else
+    fd = open(pathP, readonly ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+        return Tclh_ErrorOperFailed(
+            ip, "open", objv[2], Tcl_ErrnoMsg(Tcl_GetErrno()));
+    }
+    if (fstat(fd, &st) != 0) {
+        ret = Tclh_ErrorOperFailed(
+            ip, "stat", objv[2], Tcl_ErrnoMsg(Tcl_GetErrno()));
+        goto vamoose;
+    }
+    fileSize = st.st_size;
+#endif
+
+    if (length < 0) {
+        length = offset < fileSize ? fileSize - offset : 0;
+        if (length == 0) {
+            ret = Tclh_ErrorInvalidValue(
+                ip, objv[2], "No data to map at the specified offset.");
+            goto vamoose;
+        }
+        if (length > TCL_SIZE_MAX) {
+            ret = Tclh_ErrorInvalidValue(
+                ip, objv[2], "File is too large to map. Specify -length.");
+            goto vamoose;
+        }
+    }
+    else if (offset > fileSize || length > (fileSize - offset)) {
+        ret = Tclh_ErrorInvalidValue(
+            ip, objv[2], "Region extends beyond the end of the file.");
+        goto vamoose;
+    }
+
+#ifdef _WIN32
+    mapH = CreateFileMappingW(
+        fileH, NULL, readonly ? PAGE_READONLY : PAGE_READWRITE, 0, 0, NULL);
+    if (mapH == NULL) {
+        ret = Tclh_ErrorWindowsError(ip, GetLastError(), NULL);
+        goto vamoose;
+    }
+    /* Views keep the mapping object alive so handle can be closed */
+    ret = CffiMemoryMapRegion(
+        ipCtxP, objv[2], mapH, offset, length, readonly, tagObj);
+    CloseHandle(mapH);
+#else
+    ret = CffiMemoryMapRegion(
+        ipCtxP, objv[2], fd, offset, length, readonly, tagObj);
+#endif
+
+vamoose:
+#ifdef _WIN32
+    CloseHandle(fileH);
+#else
+    close(fd); /* Mapping stays valid after close */
+#endif
+    return ret;
+}
+
+/* Function: CffiMemoryShmCmd
+ * Implements the *memory shm* script level command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - count of elements in objv[]. Should be 4-6 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - unused
+ *
+ * The *objv[2]* element is one of *create*, *open* or *unlink* and
+ * *objv[3]* is the name of the shared memory object. For *create* and *open*
+ * *objv[4]* is the size to map and the optional *objv[5]* the pointer tag.
+ *
+ * On POSIX systems a leading slash is added to the name if not present.
+ * On Windows the name is that of a named file mapping object backed by
+ * the paging file and *unlink* is a no-op since the object is deleted
+ * when the last mapping to it is closed.
+ *
+ * Returns:
+ * *TCL_OK* on success with a wrapped safe pointer as the interpreter result
+ * for *create* and *open*, *TCL_ERROR* on failure with error message in
+ * interpreter.
+ */
+static CffiResult
+CffiMemoryShmCmd(CffiInterpCtx *ipCtxP,
+                 int objc,
+                 Tcl_Obj *const objv[],
+                 CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    Tcl_WideInt size = 0;
+    Tcl_DString ds;
+    CffiResult ret;
+    int opIndex;
+    static const char *const ops[] = {"create", "open", "unlink", NULL};
+    enum OP { CREATE, OPEN, UNLINK };
+#ifdef _WIN32
+    HANDLE mapH;
+#else
+    const char *nameP;
+    struct stat st;
+    int fd;
+#endif
+
+    CHECK(Tcl_GetIndexFromObj(ip, objv[2], ops, "operation", 0, &opIndex));
+    if (opIndex == UNLINK) {
+        if (objc != 4) {
+            Tcl_WrongNumArgs(ip, 3, objv, "NAME");
+            return TCL_ERROR;
+        }
+    }
+    else {
+        if (objc < 5 || objc > 6) {
+            Tcl_WrongNumArgs(ip, 3, objv, "NAME SIZE ?TAG?");
+            return TCL_ERROR;
+        }
+        CHECK(Tclh_ObjToRangedInt(ip, objv[4], 1, TCL_SIZE_MAX, &size));
+    }
+
+#ifdef _WIN32
+    if (opIndex == UNLINK)
+        return TCL_OK;
+    Tcl_UtfToExternalDString(NULL, Tcl_GetString(objv[3]), -1, &ds);
+    if (opIndex == CREATE) {
+        mapH = CreateFileMappingA(INVALID_HANDLE_VALUE,
+                                  NULL,
+                                  PAGE_READWRITE,
+                                  (DWORD)((ULONGLONG)size >> 32),
+                                  (DWORD)size,
+                                  Tcl_DStringValue(&ds));
+        if (mapH != NULL && GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(mapH);
+            Tcl_DStringFree(&ds);
+            return Tclh_ErrorExists(ip, "Shared memory object", objv[3], NULL);
+        }
+    }
+    else {
+        mapH = OpenFileMappingA(FILE_MAP_WRITE, FALSE, Tcl_DStringValue(&ds));
+    }
+    Tcl_DStringFree(&ds);
+    if (mapH == NULL)
+        return Tclh_ErrorWindowsError(ip, GetLastError(), NULL);
+    ret = CffiMemoryMapRegion(
+        ipCtxP, objv[3], mapH, 0, size, 0, objc > 5 ? objv[5] : NULL);
+    CloseHandle(mapH);
+    return ret;
+#else
+    Tcl_DStringInit(&ds);
+    nameP = Tcl_GetString(objv[3]);
+    if (nameP[0] != '/')
+        Tcl_DStringAppend(&ds, "/", 1);
+    Tcl_DStringAppend(&ds, nameP, -1);
+    nameP = Tcl_DStringValue(&ds);
+
+    switch (opIndex) {
+    case UNLINK:
+        if (shm_unlink(nameP) != 0 && Tcl_GetErrno() != ENOENT) {
+            ret = Tclh_ErrorOperFailed(
+                ip, "unlink", objv[3], Tcl_ErrnoMsg(Tcl_GetErrno()));
+        }
+        else
+            ret = TCL_OK;
+        Tcl_DStringFree(&ds);
+        return ret;
+    case CREATE:
+        fd = shm_open(nameP, O_RDWR | O_CREAT | O_EXCL, 0600);
+        break;
+    default:
+        fd = shm_open(nameP, O_RDWR, 0);
+        break;
+    }
+    if (fd < 0) {
+        int err = Tcl_GetErrno();
+        if (err == EEXIST)
+            ret = Tclh_ErrorExists(ip, "Shared memory object", objv[3], NULL);
+        else if (err == ENOENT)
+            ret = Tclh_ErrorNotFound(ip, "Shared memory object", objv[3], NULL);
+        else
+            ret = Tclh_ErrorOperFailed(ip, "open", objv[3], Tcl_ErrnoMsg(err));
+        Tcl_DStringFree(&ds);
+        return ret;
+    }
+
+    if (opIndex == CREATE) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            ret = Tclh_ErrorOperFailed(
+                ip, "resize", objv[3], Tcl_ErrnoMsg(Tcl_GetErrno()));
+            goto vamoose;
+        }
+    }
+    else {
+        if (fstat(fd, &st) != 0) {
+            ret = Tclh_ErrorOperFailed(
+                ip, "stat", objv[3], Tcl_ErrnoMsg(Tcl_GetErrno()));
+            goto vamoose;
+        }
+        if (st.st_size < size) {
+            ret = Tclh_ErrorInvalidValue(
+                ip,
+                objv[4],
+                "Size exceeds the size of the shared memory object.");
+            goto vamoose;
+        }
+    }
+
+    ret = CffiMemoryMapRegion(
+        ipCtxP, objv[3], fd, 0, size, 0, objc > 5 ? objv[5] : NULL);
+
+vamoose:
+    if (ret != TCL_OK && opIndex == CREATE)
+        shm_unlink(nameP);
+    close(fd);
+    Tcl_DStringFree(&ds);
+    return ret;
+#endif
+}
+
+/* Function: CffiMemorySizeCmd
+ * Implements the *memory size* script level command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - count of elements in objv[]. Should be 3 including command
+ *        and subcommand.
+ * objv - argument array.
+ * flags - unused
+ *
+ * Returns the number of bytes from the pointer in *objv[2]* to the end of
+ * the registered address range containing it. Address ranges are
+ * registered for memory mappings, arena frames and all other memory
+ * allocated through the extension's commands.
+ *
+ * Returns:
+ * *TCL_OK* on success with the size as the interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiMemorySizeCmd(CffiInterpCtx *ipCtxP,
+                  int objc,
+                  Tcl_Obj *const objv[],
+                  CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    void *pv;
+    char *endP;
+
+    CHECK(CffiPointerObjVerify(ipCtxP, objv[2], &pv));
+    if (pv == NULL)
+        return Tclh_ErrorPointerNull(ip);
+    if (!CffiPointerRangeBounds(ipCtxP, pv, &endP)) {
+        return Tclh_ErrorInvalidValue(
+            ip, objv[2], "Size of the memory block is not known.");
+    }
+    Tcl_SetObjResult(ip, Tcl_NewWideIntObj(endP - (char *)pv));
     return TCL_OK;
 }
 
@@ -812,7 +2365,13 @@ CffiMemoryObjCmd(ClientData cdata,
     CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
     /* The flags field CFFI_F_ALLOW_UNSAFE is set for unsafe pointer operation */
     static const Tclh_SubCommand subCommands[] = {
-        {"allocate", 1, 2, "SIZE ?TAG?", CffiMemoryAllocateCmd, 0},
+        {"allocate", 1, 7, "?-align ALIGNMENT? ?-hugepages? ?-pool POOL? SIZE ?TAG?", CffiMemoryAllocateCmd, 0},
+        {"compare", 3, 5, "POINTER1 POINTER2 COUNT ?OFFSET1? ?OFFSET2?", CffiMemoryCompareCmd, 0},
+        {"compare!", 3, 5, "POINTER1 POINTER2 COUNT ?OFFSET1? ?OFFSET2?", CffiMemoryCompareCmd, CFFI_F_ALLOW_UNSAFE},
+        {"copy", 3, 5, "DSTPOINTER SRCPOINTER COUNT ?DSTOFFSET? ?SRCOFFSET?", CffiMemoryCopyCmd, 0},
+        {"copy!", 3, 5, "DSTPOINTER SRCPOINTER COUNT ?DSTOFFSET? ?SRCOFFSET?", CffiMemoryCopyCmd, CFFI_F_ALLOW_UNSAFE},
+        {"find", 3, 4, "POINTER SIZE PATTERN ?OFFSET?", CffiMemoryFindCmd, 0},
+        {"find!", 3, 4, "POINTER SIZE PATTERN ?OFFSET?", CffiMemoryFindCmd, CFFI_F_ALLOW_UNSAFE},
         {"free", 1, 1, "POINTER", CffiMemoryFreeCmd, 0},
         {"frombinary", 1, 2, "BINARY ?TAG?", CffiMemoryFromBinaryCmd, 0},
         {"fromstring", 1, 2, "STRING ?ENCODING?", CffiMemoryFromStringCmd, 0},
@@ -820,11 +2379,19 @@ CffiMemoryObjCmd(ClientData cdata,
 #ifdef _WIN32
         {"fromwinstring", 1, 1, "STRING", CffiMemoryFromWinStringCmd, 0},
 #endif
-        {"new", 2, 3, "TYPE INITIALIZER ?TAG?", CffiMemoryNewCmd, 0},
+        {"map", 1, 8, "PATH ?-readonly? ?-offset OFFSET? ?-length LENGTH? ?-tag TAG?", CffiMemoryMapCmd, 0},
+        {"new", 2, 8, "?-align ALIGNMENT? ?-hugepages? ?-pool POOL? TYPE INITIALIZER ?TAG?", CffiMemoryNewCmd, 0},
+        {"pool", 1, 3, "OPERATION ?ARG ...?", CffiMemoryPoolCmd, 0},
         {"set", 3, 4, "POINTER TYPE VALUE ?INDEX?", CffiMemorySetCmd, 0},
         {"set!", 3, 4, "POINTER TYPE VALUE ?INDEX?", CffiMemorySetCmd, CFFI_F_ALLOW_UNSAFE},
         {"get", 2, 3, "POINTER TYPE ?INDEX?", CffiMemoryGetCmd, 0},
         {"get!", 2, 3, "POINTER TYPE ?INDEX?", CffiMemoryGetCmd, CFFI_F_ALLOW_UNSAFE},
+        {"shm", 2, 4, "OPERATION NAME ?SIZE? ?TAG?", CffiMemoryShmCmd, 0},
+        {"size", 1, 1, "POINTER", CffiMemorySizeCmd, 0},
+        {"hash", 2, 3, "POINTER SIZE ?OFFSET?", CffiMemoryHashCmd, 0},
+        {"hash!", 2, 3, "POINTER SIZE ?OFFSET?", CffiMemoryHashCmd, CFFI_F_ALLOW_UNSAFE},
+        {"move", 3, 5, "DSTPOINTER SRCPOINTER COUNT ?DSTOFFSET? ?SRCOFFSET?", CffiMemoryCopyCmd, CFFI_F_ALLOW_OVERLAP},
+        {"move!", 3, 5, "DSTPOINTER SRCPOINTER COUNT ?DSTOFFSET? ?SRCOFFSET?", CffiMemoryCopyCmd, CFFI_F_ALLOW_UNSAFE | CFFI_F_ALLOW_OVERLAP},
         {"fill", 3, 4, "POINTER BYTEVALUE COUNT ?OFFSET?", CffiMemoryFillCmd, 0},
         {"fill!", 3, 4, "POINTER BYTEVALUE COUNT ?OFFSET?", CffiMemoryFillCmd, CFFI_F_ALLOW_UNSAFE},
         {"tobinary", 2, 3, "POINTER SIZE ?OFFSET?", CffiMemoryToBinaryCmd, 0},
@@ -833,6 +2400,7 @@ CffiMemoryObjCmd(ClientData cdata,
         {"tostring!", 1, 3, "POINTER ?ENCODING? ?OFFSET?", CffiMemoryToStringCmd, CFFI_F_ALLOW_UNSAFE},
         {"tounistring", 1, 2, "POINTER ?OFFSET?", CffiMemoryToUniStringCmd, 0},
         {"tounistring!", 1, 2, "POINTER ?OFFSET?", CffiMemoryToUniStringCmd, CFFI_F_ALLOW_UNSAFE},
+        {"view", 2, 3, "POINTER SIZE ?OFFSET?", CffiMemoryViewCmd, 0},
 #ifdef _WIN32
         {"towinstring", 1, 2, "POINTER ?OFFSET?", CffiMemoryToWinStringCmd, 0},
         {"towinstring!", 1, 2, "POINTER ?OFFSET?", CffiMemoryToWinStringCmd, CFFI_F_ALLOW_UNSAFE},
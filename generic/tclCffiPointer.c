@@ -17,6 +17,8 @@ CFFI_INLINE void CffiPointerNullifyTag(Tcl_Obj **tagObjP) {
     }
 }
 
+static void
+CffiPointerRangeRemove(CffiInterpCtx *ipCtxP, Tcl_Size i, int copy);
 
 static CffiResult
 CffiPointerCastableCmd(CffiInterpCtx *ipCtxP,
@@ -58,6 +60,8 @@ CffiPointerCastableCmd(CffiInterpCtx *ipCtxP,
     }
 
     Tcl_DecrRefCount(superFqnObj);
+    ipCtxP->pointerTagEpoch += 1;
+    CffiPointerRegistryChanged(ipCtxP);
     return ret;
 }
 
@@ -76,6 +80,8 @@ CffiPointerUncastableCmd(CffiInterpCtx *ipCtxP, Tcl_Obj *tagObj)
 
     ret = Tclh_PointerSubtagRemove(ip, ipCtxP->tclhCtxP, tagObj);
     Tcl_DecrRefCount(tagObj);
+    ipCtxP->pointerTagEpoch += 1;
+    CffiPointerRegistryChanged(ipCtxP);
     return ret;
 }
 
@@ -108,6 +114,371 @@ CffiPointerCompareCmd(CffiInterpCtx *ipCtxP, Tcl_Obj *ptr1Obj, Tcl_Obj *ptr2Obj)
     return TCL_OK;
 }
 
+/* Function: CffiPointerRangeFind
+ * Locates the registered address range with the highest start address not
+ * greater than the given address.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address to look up
+ *
+ * Returns:
+ * Index of the range in ipCtxP->pointerRangesP or -1 if there is none.
+ */
+static Tcl_Size
+CffiPointerRangeFind(CffiInterpCtx *ipCtxP, const void *pv)
+{
+    CffiPointerRange *rangesP = ipCtxP->pointerRangesP;
+    Tcl_Size lo = 0;
+    Tcl_Size hi = ipCtxP->nPointerRanges;
+
+    /* Invariant: ranges [0,lo) start at or below pv, [hi,n) above pv */
+    while (lo < hi) {
+        Tcl_Size mid = lo + (hi - lo) / 2;
+        if ((const char *)pv < rangesP[mid].startP)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo - 1;
+}
+
+/* Function: CffiPointerRangeLookup
+ * Checks if an address lies within a registered address range.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address to check
+ *
+ * Returns:
+ * Non-zero if *pv* is within a registered range, 0 otherwise.
+ */
+int
+CffiPointerRangeLookup(CffiInterpCtx *ipCtxP, const void *pv)
+{
+    Tcl_Size i = CffiPointerRangeFind(ipCtxP, pv);
+    return i >= 0 && (const char *)pv < ipCtxP->pointerRangesP[i].endP;
+}
+
+/* Function: CffiPointerRangeBounds
+ * Returns the end of the registered address range containing an address.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - address to look up
+ * endPP - location to store the end of the range, one past the last byte
+ *
+ * Returns:
+ * Non-zero if *pv* is within a registered range, 0 otherwise in which case
+ * *endPP* is not modified.
+ */
+int
+CffiPointerRangeBounds(CffiInterpCtx *ipCtxP, const void *pv, char **endPP)
+{
+    Tcl_Size i = CffiPointerRangeFind(ipCtxP, pv);
+    if (i >= 0 && (const char *)pv < ipCtxP->pointerRangesP[i].endP) {
+        *endPP = ipCtxP->pointerRangesP[i].endP;
+        return 1;
+    }
+    return 0;
+}
+
+/* Function: CffiPointerRangeRegister
+ * Registers an address range as a single unit.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - start of the range
+ * size - size of the range in bytes. Must be positive.
+ *
+ * Pointers within the range are treated as valid derived pointers without
+ * being individually registered. Registering a range is O(log n) in the
+ * number of registered ranges and O(1) when ranges are registered in
+ * increasing address order as is the case for arena allocations.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with an error message in the interpreter
+ * if the range overlaps an existing one.
+ */
+CffiResult
+CffiPointerRangeRegister(CffiInterpCtx *ipCtxP, void *pv, Tcl_Size size)
+{
+    CffiPointerRange *rangesP;
+    char *startP = (char *)pv;
+    char *endP   = startP + size;
+    Tcl_Size i;
+
+    CFFI_ASSERT(pv);
+    CFFI_ASSERT(size > 0);
+
+    i = CffiPointerRangeFind(ipCtxP, pv);
+    rangesP = ipCtxP->pointerRangesP;
+    if ((i >= 0 && startP < rangesP[i].endP)
+        || (i + 1 < ipCtxP->nPointerRanges && rangesP[i + 1].startP < endP)) {
+        return Tclh_ErrorExists(ipCtxP->interp,
+                                "Address range",
+                                NULL,
+                                "Range overlaps a registered address range.");
+    }
+
+    if (ipCtxP->nPointerRanges == ipCtxP->nPointerRangesAllocated) {
+        Tcl_Size n = ipCtxP->nPointerRangesAllocated
+                       ? 2 * ipCtxP->nPointerRangesAllocated
+                       : 16;
+        ipCtxP->pointerRangesP =
+            ckrealloc(ipCtxP->pointerRangesP, n * sizeof(*rangesP));
+        ipCtxP->nPointerRangesAllocated = n;
+        rangesP = ipCtxP->pointerRangesP;
+    }
+
+    /* Insert after position i */
+    i += 1;
+    if (i < ipCtxP->nPointerRanges) {
+        memmove(&rangesP[i + 1],
+                &rangesP[i],
+                (ipCtxP->nPointerRanges - i) * sizeof(*rangesP));
+    }
+    rangesP[i].startP = startP;
+    rangesP[i].endP   = endP;
+    ipCtxP->nPointerRanges += 1;
+    return TCL_OK;
+}
+
+/* Function: CffiPointerRangeRecordAllocation
+ * Registers the address range of a block just allocated by the extension.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - start of the block
+ * size - size of the block in bytes. Nothing is done if 0.
+ *
+ * Recording the range lets commands bounds check accesses to the block.
+ * Any registered range overlapping a block the allocator has just handed
+ * out must belong to memory that was freed without the extension's
+ * knowledge, for example by a C function, so it is removed first.
+ */
+void
+CffiPointerRangeRecordAllocation(CffiInterpCtx *ipCtxP,
+                                 void *pv,
+                                 Tcl_Size size)
+{
+    char *startP = (char *)pv;
+    Tcl_Size i;
+    CffiResult ret;
+
+    if (size <= 0)
+        return;
+    /* Highest range starting within the block. Lower ones end before it. */
+    while ((i = CffiPointerRangeFind(ipCtxP, startP + size - 1)) >= 0
+           && startP < ipCtxP->pointerRangesP[i].endP) {
+        CffiPointerRangeRemove(ipCtxP, i, 0);
+    }
+    ret = CffiPointerRangeRegister(ipCtxP, pv, size);
+    CFFI_ASSERT(ret == TCL_OK);
+    (void)ret;
+}
+
+/* Function: CffiPointerRangeExtend
+ * Extends a registered address range.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - start of a registered range
+ * endP - new end of the range. Must not be below the current end.
+ *
+ * Returns:
+ * 1 if the range was extended, 0 if *pv* is not the start of a registered
+ * range or the extended range would overlap the following one.
+ */
+int
+CffiPointerRangeExtend(CffiInterpCtx *ipCtxP, void *pv, void *endP)
+{
+    CffiPointerRange *rangesP = ipCtxP->pointerRangesP;
+    Tcl_Size i = CffiPointerRangeFind(ipCtxP, pv);
+
+    if (i < 0 || rangesP[i].startP != (char *)pv)
+        return 0;
+    CFFI_ASSERT((char *)endP >= rangesP[i].endP);
+    if (i + 1 < ipCtxP->nPointerRanges
+        && rangesP[i + 1].startP < (char *)endP)
+        return 0;
+    rangesP[i].endP = (char *)endP;
+    return 1;
+}
+
+/* Function: CffiPointerRangeRemove
+ * Removes an entry from the address range registry.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * i - index of the range in ipCtxP->pointerRangesP
+ * copy - if non-zero, memory views into the range are detached with a copy
+ *   of the memory content. Must be 0 if the memory may already be freed.
+ */
+static void
+CffiPointerRangeRemove(CffiInterpCtx *ipCtxP, Tcl_Size i, int copy)
+{
+    CffiPointerRange *rangesP = ipCtxP->pointerRangesP;
+
+    if (ipCtxP->memoryViewsP) {
+        CffiMemoryViewsRelease(ipCtxP,
+                               rangesP[i].startP,
+                               rangesP[i].endP - rangesP[i].startP,
+                               copy);
+    }
+    ipCtxP->nPointerRanges -= 1;
+    if (i < ipCtxP->nPointerRanges) {
+        memmove(&rangesP[i],
+                &rangesP[i + 1],
+                (ipCtxP->nPointerRanges - i) * sizeof(*rangesP));
+    }
+    CffiPointerRegistryChanged(ipCtxP);
+}
+
+/* Function: CffiPointerRangeUnregister
+ * Unregisters an address range.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - start of the range. Nothing is done if no range starts at *pv*.
+ */
+void
+CffiPointerRangeUnregister(CffiInterpCtx *ipCtxP, void *pv)
+{
+    Tcl_Size i = CffiPointerRangeFind(ipCtxP, pv);
+
+    if (i >= 0 && ipCtxP->pointerRangesP[i].startP == (char *)pv)
+        CffiPointerRangeRemove(ipCtxP, i, 1);
+}
+
+/* Function: CffiPointerReleased
+ * Releases the address range, memory views and memory mapping tied to a
+ * pointer that has been unregistered or invalidated.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - the pointer. Must not be NULL.
+ * copy - if non-zero, memory views are detached with a copy of the memory
+ *   content. Must be 0 if the memory may already have been freed, for
+ *   example by the callee for a *dispose* parameter.
+ *
+ * Nothing is done if *pv* is still registered, as is the case for a
+ * counted pointer with outstanding references. This must be called on
+ * every path that removes a pointer registration without going through
+ * the extension's own free commands, else pointers into memory that is no
+ * longer owned keep validating through the range registry.
+ */
+void
+CffiPointerReleased(CffiInterpCtx *ipCtxP, void *pv, int copy)
+{
+    Tcl_Size i;
+
+    if (Tclh_PointerVerify(NULL, ipCtxP->tclhCtxP, pv) == TCL_OK)
+        return;
+    i = CffiPointerRangeFind(ipCtxP, pv);
+    if (i >= 0 && ipCtxP->pointerRangesP[i].startP == (char *)pv)
+        CffiPointerRangeRemove(ipCtxP, i, copy);
+    else if (ipCtxP->memoryViewsP)
+        CffiMemoryViewsRelease(ipCtxP, pv, 1, copy);
+    /* A mapping cannot be unmapped through memory free once unregistered */
+    if (ipCtxP->memoryMappingsP)
+        CffiMemoryMappingRelease(ipCtxP, pv);
+}
+
+/* Function: CffiPointerViewsSnapshot
+ * Detaches the memory views tied to a pointer with a copy of their content.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - the pointer. Must not be NULL.
+ *
+ * Must be called before passing a pointer to a function that may free the
+ * memory, such as for a *dispose* parameter, as the content can no longer
+ * be copied once <CffiPointerReleased> is called after the call.
+ */
+void
+CffiPointerViewsSnapshot(CffiInterpCtx *ipCtxP, void *pv)
+{
+    Tcl_Size i;
+
+    if (ipCtxP->memoryViewsP == NULL)
+        return;
+    i = CffiPointerRangeFind(ipCtxP, pv);
+    if (i >= 0 && ipCtxP->pointerRangesP[i].startP == (char *)pv) {
+        CffiMemoryViewsRelease(ipCtxP,
+                               pv,
+                               ipCtxP->pointerRangesP[i].endP - (char *)pv,
+                               1);
+    }
+    else
+        CffiMemoryViewsRelease(ipCtxP, pv, 1, 1);
+}
+
+/* Function: CffiPointerRegistering
+ * Invalidates cached pointer validations before a pointer is registered if
+ * the registration may change them.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - the pointer about to be registered. Must not be NULL.
+ *
+ * Only successful validations are cached so a new registration cannot
+ * invalidate them. Registering an already registered pointer may replace
+ * its tag, in which case the cache is invalidated.
+ */
+void
+CffiPointerRegistering(CffiInterpCtx *ipCtxP, void *pv)
+{
+    if (Tclh_PointerVerify(NULL, ipCtxP->tclhCtxP, pv) == TCL_OK)
+        CffiPointerRegistryChanged(ipCtxP);
+}
+
+/* Function: CffiPointerObjVerify
+ * Verifies a pointer is registered individually or lies within a registered
+ * address range.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * ptrObj - wrapped pointer
+ * pvP - location to store the pointer value
+ *
+ * NULL pointers are returned without error. Callers must check as needed.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in the interpreter.
+ */
+CffiResult
+CffiPointerObjVerify(CffiInterpCtx *ipCtxP, Tcl_Obj *ptrObj, void **pvP)
+{
+    void *pv;
+
+    CHECK(Tclh_PointerUnwrap(ipCtxP->interp, ptrObj, &pv));
+    if (pv && ipCtxP->nPointerRanges && CffiPointerRangeLookup(ipCtxP, pv)) {
+        *pvP = pv;
+        return TCL_OK;
+    }
+    return Tclh_PointerObjVerify(
+        ipCtxP->interp, ipCtxP->tclhCtxP, ptrObj, pvP, NULL, NULL);
+}
+
+/* Function: CffiPointerRangesCleanup
+ * Releases all registered address ranges.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ */
+void
+CffiPointerRangesCleanup(CffiInterpCtx *ipCtxP)
+{
+    if (ipCtxP->pointerRangesP) {
+        ckfree(ipCtxP->pointerRangesP);
+        ipCtxP->pointerRangesP = NULL;
+    }
+    ipCtxP->nPointerRanges          = 0;
+    ipCtxP->nPointerRangesAllocated = 0;
+    CffiPointerRegistryChanged(ipCtxP);
+}
+
 CffiResult
 CffiPointerObjCmd(ClientData cdata,
                   Tcl_Interp *ip,
@@ -212,6 +583,8 @@ CffiPointerObjCmd(ClientData cdata,
                                      &objP,
                                      NULL,
                                      &registration));
+        registration =
+            CffiPointerRangeCheckRegistration(ipCtxP, pv, registration);
         validity = 1;
         if (pv == NULL || registration == TCLH_POINTER_REGISTRATION_MISSING
             || (objP && registration == TCLH_POINTER_REGISTRATION_WRONGTAG)) {
@@ -270,6 +643,24 @@ CffiPointerObjCmd(ClientData cdata,
     if (ret != TCL_OK)
         return ret;
 
+    /*
+     * Registration only invalidates cached validations when it replaces
+     * the tag of an existing registration. Disposal always does.
+     */
+    switch (cmdIndex) {
+    case SAFE:
+    case COUNTED:
+    case PIN:
+        CffiPointerRegistering(ipCtxP, pv);
+        break;
+    case DISPOSE:
+    case INVALIDATE:
+        CffiPointerRegistryChanged(ipCtxP);
+        break;
+    default:
+        break;
+    }
+
     switch (cmdIndex) {
     case TAG:
         if (ret == TCL_OK && objP)
@@ -298,14 +689,22 @@ CffiPointerObjCmd(ClientData cdata,
         }
         return ret;
     case DISPOSE:
-        if (pv)
-            return Tclh_PointerUnregisterTagged(
+        if (pv) {
+            ret = Tclh_PointerUnregisterTagged(
                 ip, ipCtxP->tclhCtxP, pv, objP);
+            if (ret == TCL_OK)
+                CffiPointerReleased(ipCtxP, pv, 1);
+            return ret;
+        }
         return TCL_OK;
     case INVALIDATE:
-        if (pv)
-            return Tclh_PointerInvalidateTagged(
+        if (pv) {
+            ret = Tclh_PointerInvalidateTagged(
                 ip, ipCtxP->tclhCtxP, pv, objP);
+            if (ret == TCL_OK)
+                CffiPointerReleased(ipCtxP, pv, 1);
+            return ret;
+        }
         return TCL_OK;
     default: /* Just to keep compiler happy */
         Tcl_SetResult(
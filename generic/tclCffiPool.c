@@ -0,0 +1,532 @@
+/*
+ * Copyright (c) 2026, Ashok P. Nadkarni
+ * All rights reserved.
+ *
+ * See the file LICENSE for license
+ */
+
+/*
+ * Implements the *memory pool* command and pooled allocations for the
+ * *memory allocate*, *memory new* and struct *allocate* and *new* commands.
+ *
+ * A pool keeps a free list for each of a set of size classes. Blocks are
+ * carved out of chunks allocated from the system and returned to the free
+ * list of their size class when freed, so repeated allocation and freeing of
+ * blocks of similar size does not go to the system allocator. Requests
+ * larger than the largest size class are allocated directly from the system.
+ *
+ * Every block handed out is tracked in the pool's hash table of outstanding
+ * blocks. This serves both to identify pooled blocks when they are freed
+ * through *memory free* or a struct *free* method and to release all of
+ * them on a *pool reset* without the script having to free each one.
+ */
+
+#include "tclCffiInt.h"
+#include <stdlib.h>
+
+#define ALIGNMENT sizeof(double) /* Same as arenas */
+#define ALIGNMASK (~(intptr_t)(ALIGNMENT - 1))
+/* Round up to alignment size */
+#define ROUNDUP(x_) ((ALIGNMENT - 1 + (x_)) & ALIGNMASK)
+
+#define POOL_CHUNK_SIZE      16384 /* Target size of chunks carved into blocks */
+#define POOL_MAX_SIZECLASSES 64
+#define POOL_OVERSIZE        -1    /* Class index for blocks not in any class */
+
+/* Default size classes */
+static const int cffiPoolDefaultSizeClasses[] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 2048, 4096};
+
+/* Struct: CffiPoolChunk
+ * Header for a chunk of memory allocated from the system and carved into
+ * blocks of a single size class.
+ */
+typedef struct CffiPoolChunk {
+    struct CffiPoolChunk *nextP;
+} CffiPoolChunk;
+#define POOL_CHUNK_HEADER_SIZE ROUNDUP(sizeof(CffiPoolChunk))
+
+/* Struct: CffiPoolFreeBlock
+ * Overlays a free block to link it into the free list of its size class.
+ */
+typedef struct CffiPoolFreeBlock {
+    struct CffiPoolFreeBlock *nextP;
+} CffiPoolFreeBlock;
+
+/* Struct: CffiPoolSizeClass
+ * Free list and chunks for a size class.
+ */
+typedef struct CffiPoolSizeClass {
+    Tcl_Size blockSize;          /* Size of blocks in this class */
+    CffiPoolFreeBlock *freeP;    /* Free list */
+    CffiPoolChunk *chunksP;      /* Chunks allocated for this class */
+} CffiPoolSizeClass;
+
+/* Struct: CffiPool
+ * A pooled allocator. See <CffiPoolAllocate>.
+ */
+typedef struct CffiPool {
+    struct CffiPool *nextP;   /* Next pool in the interpreter */
+    Tcl_Obj *nameObj;         /* Name of the pool. Reference held. */
+    Tcl_HashTable blocks;     /* Outstanding block address -> class index */
+    Tcl_WideUInt hits;        /* Allocations satisfied from a free list */
+    Tcl_WideUInt misses;      /* Allocations that needed system memory */
+    Tcl_WideInt footprint;    /* System memory held by the pool */
+    int nClasses;             /* Number of elements in classes[] */
+    CffiPoolSizeClass classes[1]; /* Must be last. Sorted by block size */
+} CffiPool;
+
+/* Function: CffiPoolClassIndex
+ * Returns the index of the smallest size class that can hold a block.
+ *
+ * Parameters:
+ * poolP - the pool
+ * size - requested block size
+ *
+ * Returns:
+ * Index of the size class or *POOL_OVERSIZE* if larger than all classes.
+ */
+static int
+CffiPoolClassIndex(CffiPool *poolP, Tcl_Size size)
+{
+    int lo = 0, hi = poolP->nClasses;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (poolP->classes[mid].blockSize < size)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < poolP->nClasses ? lo : POOL_OVERSIZE;
+}
+
+/* Function: CffiPoolRefill
+ * Allocates a chunk for a size class and adds its blocks to the free list.
+ *
+ * Parameters:
+ * poolP - the pool
+ * classP - the size class
+ */
+static void
+CffiPoolRefill(CffiPool *poolP, CffiPoolSizeClass *classP)
+{
+    CffiPoolChunk *chunkP;
+    Tcl_Size nBlocks;
+    Tcl_Size chunkSize;
+    char *blockP;
+
+    nBlocks = (POOL_CHUNK_SIZE - POOL_CHUNK_HEADER_SIZE) / classP->blockSize;
+    if (nBlocks == 0)
+        nBlocks = 1;
+    chunkSize = POOL_CHUNK_HEADER_SIZE + nBlocks * classP->blockSize;
+    chunkP = ckalloc(chunkSize);
+    chunkP->nextP = classP->chunksP;
+    classP->chunksP = chunkP;
+    poolP->footprint += chunkSize;
+
+    /* Link blocks in address order so allocations are sequential */
+    blockP = POOL_CHUNK_HEADER_SIZE + (char *)chunkP
+           + (nBlocks - 1) * classP->blockSize;
+    while (nBlocks--) {
+        CffiPoolFreeBlock *freeP = (CffiPoolFreeBlock *)blockP;
+        freeP->nextP             = classP->freeP;
+        classP->freeP            = freeP;
+        blockP -= classP->blockSize;
+    }
+}
+
+/* Function: CffiPoolAllocate
+ * Allocates a block of memory from a pool.
+ *
+ * Parameters:
+ * poolP - the pool
+ * size - requested size. Must be positive.
+ *
+ * The returned block is not registered as a pointer. It must be freed
+ * with <CffiPoolFree> (or released with the pool) and never with *ckfree*.
+ *
+ * Returns:
+ * Pointer to the allocated block. Panics on memory allocation failure
+ * like *ckalloc*.
+ */
+void *
+CffiPoolAllocate(CffiPool *poolP, Tcl_Size size)
+{
+    Tcl_HashEntry *heP;
+    int classIndex;
+    int isNew;
+    void *pv;
+
+    classIndex = CffiPoolClassIndex(poolP, size);
+    if (classIndex == POOL_OVERSIZE) {
+        pv = ckalloc(size);
+        poolP->misses    += 1;
+        poolP->footprint += size;
+    }
+    else {
+        CffiPoolSizeClass *classP = &poolP->classes[classIndex];
+        if (classP->freeP) {
+            poolP->hits += 1;
+        }
+        else {
+            poolP->misses += 1;
+            CffiPoolRefill(poolP, classP);
+        }
+        pv            = classP->freeP;
+        classP->freeP = classP->freeP->nextP;
+    }
+
+    heP = Tcl_CreateHashEntry(&poolP->blocks, pv, &isNew);
+    CFFI_ASSERT(isNew);
+    /* Oversize blocks store their size so the footprint can be updated */
+    Tcl_SetHashValue(heP,
+                     (void *)(intptr_t)(classIndex == POOL_OVERSIZE
+                                            ? -size
+                                            : classIndex));
+    return pv;
+}
+
+/* Function: CffiPoolReleaseEntry
+ * Returns the block for an entry in the outstanding block table to its pool.
+ *
+ * Parameters:
+ * poolP - the pool
+ * heP - entry for the block in the pool's *blocks* table. Deleted on return.
+ */
+static void
+CffiPoolReleaseEntry(CffiPool *poolP, Tcl_HashEntry *heP)
+{
+    void *pv        = Tcl_GetHashKey(&poolP->blocks, heP);
+    intptr_t clsval = (intptr_t)Tcl_GetHashValue(heP);
+
+    Tcl_DeleteHashEntry(heP);
+    if (clsval < 0) {
+        poolP->footprint += clsval; /* clsval is negative of block size */
+        ckfree(pv);
+    }
+    else {
+        CffiPoolSizeClass *classP = &poolP->classes[clsval];
+        CffiPoolFreeBlock *freeP  = (CffiPoolFreeBlock *)pv;
+        freeP->nextP              = classP->freeP;
+        classP->freeP             = freeP;
+    }
+}
+
+/* Function: CffiPoolFree
+ * Returns a block to the pool it was allocated from.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * pv - block to free. Caller is responsible for unregistering it.
+ *
+ * Returns:
+ * Non-zero if *pv* was allocated from a pool and has been freed, 0 if it
+ * does not belong to any pool in which case the caller must free it.
+ */
+int
+CffiPoolFree(CffiInterpCtx *ipCtxP, void *pv)
+{
+    CffiPool *poolP;
+
+    for (poolP = ipCtxP->poolsP; poolP; poolP = poolP->nextP) {
+        Tcl_HashEntry *heP = Tcl_FindHashEntry(&poolP->blocks, pv);
+        if (heP) {
+            CffiPoolReleaseEntry(poolP, heP);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Function: CffiPoolReset
+ * Releases all outstanding blocks of a pool.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * poolP - the pool
+ *
+ * Pointers to the blocks are unregistered and views into them detached.
+ * System memory held for size classes is retained for reuse.
+ */
+static void
+CffiPoolReset(CffiInterpCtx *ipCtxP, CffiPool *poolP)
+{
+    Tcl_HashEntry *heP;
+    Tcl_HashSearch hSearch;
+
+    if (poolP->blocks.numEntries == 0)
+        return;
+
+    CffiPointerRegistryChanged(ipCtxP);
+    while ((heP = Tcl_FirstHashEntry(&poolP->blocks, &hSearch)) != NULL) {
+        void *pv = Tcl_GetHashKey(&poolP->blocks, heP);
+        /* May have been already unregistered through pointer dispose */
+        Tclh_PointerUnregister(NULL, ipCtxP->tclhCtxP, pv);
+        CffiPointerRangeUnregister(ipCtxP, pv);
+        if (ipCtxP->memoryViewsP)
+            CffiMemoryViewsRelease(ipCtxP, pv, 1, 1);
+        CffiPoolReleaseEntry(poolP, heP);
+    }
+}
+
+/* Function: CffiPoolDelete
+ * Releases all blocks and system memory of a pool and frees it.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * poolP - the pool. Must have been unlinked from the interpreter list.
+ */
+static void
+CffiPoolDelete(CffiInterpCtx *ipCtxP, CffiPool *poolP)
+{
+    int i;
+
+    CffiPoolReset(ipCtxP, poolP);
+    for (i = 0; i < poolP->nClasses; ++i) {
+        CffiPoolChunk *chunkP = poolP->classes[i].chunksP;
+        while (chunkP) {
+            CffiPoolChunk *nextP = chunkP->nextP;
+            ckfree(chunkP);
+            chunkP = nextP;
+        }
+    }
+    Tcl_DeleteHashTable(&poolP->blocks);
+    Tcl_DecrRefCount(poolP->nameObj);
+    ckfree(poolP);
+}
+
+/* Function: CffiPoolsCleanup
+ * Deletes all pools for an interpreter.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ */
+void
+CffiPoolsCleanup(CffiInterpCtx *ipCtxP)
+{
+    while (ipCtxP->poolsP) {
+        CffiPool *poolP = ipCtxP->poolsP;
+        ipCtxP->poolsP  = poolP->nextP;
+        CffiPoolDelete(ipCtxP, poolP);
+    }
+}
+
+/* Function: CffiPoolFromObj
+ * Returns the pool with the given name.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * nameObj - name of the pool
+ * poolPP - location to store pointer to the pool
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter if
+ * no pool exists with that name.
+ */
+CffiResult
+CffiPoolFromObj(CffiInterpCtx *ipCtxP, Tcl_Obj *nameObj, CffiPool **poolPP)
+{
+    CffiPool *poolP;
+    const char *name = Tcl_GetString(nameObj);
+
+    for (poolP = ipCtxP->poolsP; poolP; poolP = poolP->nextP) {
+        if (!strcmp(name, Tcl_GetString(poolP->nameObj))) {
+            *poolPP = poolP;
+            return TCL_OK;
+        }
+    }
+    return Tclh_ErrorNotFound(ipCtxP->interp, "Memory pool", nameObj, NULL);
+}
+
+/* Function: CffiPoolSizeCompare
+ * qsort comparison function for size classes.
+ */
+static int
+CffiPoolSizeCompare(const void *aP, const void *bP)
+{
+    Tcl_WideInt a = *(const Tcl_WideInt *)aP;
+    Tcl_WideInt b = *(const Tcl_WideInt *)bP;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/* Function: CffiPoolCreateCmd
+ * Implements the *memory pool create* script level command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments in objv[]
+ * objv - argument array. Options start at objv[3].
+ *
+ * Returns:
+ * *TCL_OK* on success with the pool name as the interpreter result,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+static CffiResult
+CffiPoolCreateCmd(CffiInterpCtx *ipCtxP, int objc, Tcl_Obj *const objv[])
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    Tcl_WideInt sizes[POOL_MAX_SIZECLASSES];
+    CffiPool *poolP;
+    Tcl_Obj **sizeObjs;
+    Tcl_Size nSizes;
+    int i, nClasses;
+
+    if (objc == 3) {
+        nSizes = sizeof(cffiPoolDefaultSizeClasses)
+               / sizeof(cffiPoolDefaultSizeClasses[0]);
+        for (i = 0; i < nSizes; ++i)
+            sizes[i] = cffiPoolDefaultSizeClasses[i];
+    }
+    else {
+        int optIndex;
+        static const char *const opts[] = {"-sizeclasses", NULL};
+        if (objc != 5) {
+            Tcl_WrongNumArgs(ip, 3, objv, "?-sizeclasses SIZES?");
+            return TCL_ERROR;
+        }
+        CHECK(Tcl_GetIndexFromObj(ip, objv[3], opts, "option", 0, &optIndex));
+        CHECK(Tcl_ListObjGetElements(ip, objv[4], &nSizes, &sizeObjs));
+        if (nSizes == 0 || nSizes > POOL_MAX_SIZECLASSES) {
+            return Tclh_ErrorInvalidValue(
+                ip,
+                objv[4],
+                "Number of size classes must be between 1 and 64.");
+        }
+        for (i = 0; i < nSizes; ++i) {
+            CHECK(Tclh_ObjToRangedInt(
+                ip, sizeObjs[i], 1, POOL_CHUNK_SIZE, &sizes[i]));
+        }
+    }
+
+    /* Round up to alignment and sort, removing duplicates */
+    for (i = 0; i < nSizes; ++i) {
+        if (sizes[i] < (Tcl_WideInt)sizeof(CffiPoolFreeBlock))
+            sizes[i] = sizeof(CffiPoolFreeBlock);
+        sizes[i] = ROUNDUP(sizes[i]);
+    }
+    qsort(sizes, nSizes, sizeof(sizes[0]), CffiPoolSizeCompare);
+    for (i = 1, nClasses = 1; i < nSizes; ++i) {
+        if (sizes[i] != sizes[nClasses - 1])
+            sizes[nClasses++] = sizes[i];
+    }
+
+    poolP = ckalloc(sizeof(*poolP) + (nClasses - 1) * sizeof(poolP->classes[0]));
+    memset(poolP, 0, sizeof(*poolP));
+    Tcl_InitHashTable(&poolP->blocks, TCL_ONE_WORD_KEYS);
+    poolP->nClasses = nClasses;
+    for (i = 0; i < nClasses; ++i) {
+        poolP->classes[i].blockSize = (Tcl_Size)sizes[i];
+        poolP->classes[i].freeP     = NULL;
+        poolP->classes[i].chunksP   = NULL;
+    }
+    poolP->nameObj = Tcl_ObjPrintf("pool%u", ++ipCtxP->poolId);
+    Tcl_IncrRefCount(poolP->nameObj);
+    poolP->nextP   = ipCtxP->poolsP;
+    ipCtxP->poolsP = poolP;
+
+    Tcl_SetObjResult(ip, poolP->nameObj);
+    return TCL_OK;
+}
+
+/* Function: CffiPoolStatsCmd
+ * Implements the *memory pool stats* script level command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * poolP - the pool
+ *
+ * Returns:
+ * *TCL_OK* with a dictionary of statistics as the interpreter result.
+ */
+static CffiResult
+CffiPoolStatsCmd(CffiInterpCtx *ipCtxP, CffiPool *poolP)
+{
+    Tcl_Obj *objs[10];
+    Tcl_Obj *sizesObj;
+    int i;
+
+    sizesObj = Tcl_NewListObj(poolP->nClasses, NULL);
+    for (i = 0; i < poolP->nClasses; ++i) {
+        Tcl_ListObjAppendElement(
+            NULL, sizesObj, Tcl_NewWideIntObj(poolP->classes[i].blockSize));
+    }
+    objs[0] = Tcl_NewStringObj("hits", 4);
+    objs[1] = Tcl_NewWideIntObj((Tcl_WideInt)poolP->hits);
+    objs[2] = Tcl_NewStringObj("misses", 6);
+    objs[3] = Tcl_NewWideIntObj((Tcl_WideInt)poolP->misses);
+    objs[4] = Tcl_NewStringObj("footprint", 9);
+    objs[5] = Tcl_NewWideIntObj(poolP->footprint);
+    objs[6] = Tcl_NewStringObj("allocated", 9);
+    objs[7] = Tcl_NewWideIntObj(poolP->blocks.numEntries);
+    objs[8] = Tcl_NewStringObj("sizeclasses", 11);
+    objs[9] = sizesObj;
+    Tcl_SetObjResult(ipCtxP->interp, Tcl_NewListObj(10, objs));
+    return TCL_OK;
+}
+
+/* Function: CffiMemoryPoolCmd
+ * Implements the *memory pool* script level command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * objc - number of arguments in objv[]. At least 3.
+ * objv - argument array. objv[2] is the pool operation.
+ * flags - unused
+ *
+ * Returns:
+ * *TCL_OK* on success with result of the operation in the interpreter,
+ * *TCL_ERROR* on failure with error message in interpreter.
+ */
+CffiResult
+CffiMemoryPoolCmd(CffiInterpCtx *ipCtxP,
+                  int objc,
+                  Tcl_Obj *const objv[],
+                  CffiFlags flags)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiPool *poolP;
+    CffiPool **prevPP;
+    int opIndex;
+    static const char *const ops[] = {
+        "create", "delete", "names", "reset", "stats", NULL};
+    enum OP { CREATE, DELETE, NAMES, RESET, STATS };
+
+    CHECK(Tcl_GetIndexFromObj(ip, objv[2], ops, "operation", 0, &opIndex));
+    if (opIndex == CREATE)
+        return CffiPoolCreateCmd(ipCtxP, objc, objv);
+    if (opIndex == NAMES) {
+        Tcl_Obj *namesObj;
+        if (objc != 3) {
+            Tcl_WrongNumArgs(ip, 3, objv, NULL);
+            return TCL_ERROR;
+        }
+        namesObj = Tcl_NewListObj(0, NULL);
+        for (poolP = ipCtxP->poolsP; poolP; poolP = poolP->nextP)
+            Tcl_ListObjAppendElement(NULL, namesObj, poolP->nameObj);
+        Tcl_SetObjResult(ip, namesObj);
+        return TCL_OK;
+    }
+
+    if (objc != 4) {
+        Tcl_WrongNumArgs(ip, 3, objv, "POOL");
+        return TCL_ERROR;
+    }
+    CHECK(CffiPoolFromObj(ipCtxP, objv[3], &poolP));
+
+    switch (opIndex) {
+    case DELETE:
+        for (prevPP = &ipCtxP->poolsP; *prevPP != poolP;
+             prevPP = &(*prevPP)->nextP)
+            ;
+        *prevPP = poolP->nextP;
+        CffiPoolDelete(ipCtxP, poolP);
+        break;
+    case RESET:
+        CffiPoolReset(ipCtxP, poolP);
+        break;
+    case STATS:
+        return CffiPoolStatsCmd(ipCtxP, poolP);
+    }
+    return TCL_OK;
+}
@@ -19,7 +19,16 @@ static void CffiParamCleanup(CffiParam *paramP)
     Tclh_ObjClearPtr(&paramP->nameObj);
 }
 
-static CffiProto *CffiProtoAllocate(Tcl_Size nparams)
+/* Function: CffiProtoAllocate
+ * Allocates a zero-initialized prototype descriptor.
+ *
+ * Parameters:
+ * nparams - number of parameter slots to allocate
+ *
+ * Returns:
+ * Pointer to the descriptor with *nParams* and reference count set to 0.
+ */
+CffiProto *CffiProtoAllocate(Tcl_Size nparams)
 {
     size_t         sz;
     CffiProto *protoP;
@@ -52,9 +61,13 @@ CffiProtoUnref(CffiProto *protoP)
             CffiParamCleanup(&protoP->params[i]);
         }
 #ifdef CFFI_USE_LIBFFI
-        if (protoP->cifP)
+        if (CffiProtoIsVarargs(protoP))
+            CffiLibffiVarargsCifsFree(protoP); /* cifP points into these */
+        else if (protoP->cifP)
             ckfree(protoP->cifP);
 #endif
+        if (protoP->planP)
+            ckfree(protoP->planP);
         ckfree(protoP);
     }
     else
@@ -257,6 +270,8 @@ CffiPrototypeParse(CffiInterpCtx *ipCtxP,
         }
     }
 
+    CffiCallPlanInit(protoP);
+
     *protoPP = protoP;
     return TCL_OK;
 }
@@ -356,6 +371,8 @@ CffiPrototypeDeleteCmd(CffiInterpCtx *ipCtxP,
                        Tcl_Obj *const objv[])
 {
     CFFI_ASSERT(objc == 3);
+    /* Cached function pointer calls may reference deleted prototypes */
+    CffiCallCacheReset(ipCtxP);
     return CffiNameDeleteNames(ipCtxP->interp,
                                &ipCtxP->scope.prototypes,
                                Tcl_GetString(objv[2]),
@@ -369,6 +386,8 @@ CffiPrototypeClearCmd(CffiInterpCtx *ipCtxP,
                       Tcl_Obj *const objv[])
 {
     CFFI_ASSERT(objc == 2);
+    /* Cached function pointer calls may reference deleted prototypes */
+    CffiCallCacheReset(ipCtxP);
     return CffiNameDeleteNames(ipCtxP->interp,
                                &ipCtxP->scope.prototypes,
                                NULL,
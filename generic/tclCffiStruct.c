@@ -8,11 +8,12 @@
 #define TCLH_SHORTNAMES
 #include "tclCffiInt.h"
 
-static int CffiStructFindField(Tcl_Interp *ip,
+static int CffiStructFindField(CffiInterpCtx *ipCtxP,
                                CffiStruct *structP,
-                               const char *fieldNameP);
+                               Tcl_Obj *fieldNameObj);
+static int CffiFieldIsCacheable(const CffiTypeAndAttrs *typeAttrsP);
 
-static CffiStruct *CffiStructCkalloc(Tcl_Size nfields)
+CffiStruct *CffiStructCkalloc(Tcl_Size nfields)
 {
     size_t         sz;
     CffiStruct *structP;
@@ -20,9 +21,36 @@ static CffiStruct *CffiStructCkalloc(Tcl_Size nfields)
     sz = offsetof(CffiStruct, fields) + (nfields * sizeof(structP->fields[0]));
     structP = ckalloc(sz);
     memset(structP, 0, sz);
+    Tcl_InitHashTable(&structP->fieldIndex, TCL_STRING_KEYS);
     return structP;
 }
 
+/* Function: CffiStructAddFieldIndex
+ * Adds a field to the field name index of a struct.
+ *
+ * Parameters:
+ * structP - struct descriptor
+ * fieldIndex - index of the field in structP->fields[]. Its name must
+ *   already have been set.
+ *
+ * Returns:
+ * 1 on success, 0 if a field of the same name is already present.
+ */
+int
+CffiStructAddFieldIndex(CffiStruct *structP, int fieldIndex)
+{
+    Tcl_HashEntry *heP;
+    int isNew;
+
+    heP = Tcl_CreateHashEntry(&structP->fieldIndex,
+                              Tcl_GetString(structP->fields[fieldIndex].nameObj),
+                              &isNew);
+    if (!isNew)
+        return 0;
+    Tcl_SetHashValue(heP, (ClientData)(intptr_t)fieldIndex);
+    return 1;
+}
+
 void
 CffiStructUnref(CffiStruct *structP)
 {
@@ -49,6 +77,7 @@ CffiStructUnref(CffiStruct *structP)
                 Tcl_DecrRefCount(structP->fields[i].nameObj);
             CffiTypeAndAttrsCleanup(&structP->fields[i].fieldType);
         }
+        Tcl_DeleteHashTable(&structP->fieldIndex);
         ckfree(structP);
     }
     else {
@@ -510,7 +539,7 @@ CffiStructComputeFieldAddress(CffiInterpCtx *ipCtxP,
 {
     Tcl_Interp *ip  = ipCtxP->interp;
 
-    int fldIndex = CffiStructFindField(ip, structP, Tcl_GetString(fldNameObj));
+    int fldIndex = CffiStructFindField(ipCtxP, structP, fldNameObj);
     if (fldIndex < 0)
         return TCL_ERROR;
 
@@ -582,6 +611,8 @@ CffiStructComputeAddress(CffiInterpCtx *ipCtxP,
                                  &registration);
     if (ret != TCL_OK)
         return ret;
+    registration =
+        CffiPointerRangeCheckRegistration(ipCtxP, structAddr, registration);
 
     if (structAddr == NULL)
         return Tclh_ErrorPointerNull(ip);
@@ -737,7 +768,6 @@ CffiStructParse(CffiInterpCtx *ipCtxP,
     structP->pack    = pack;
 
     for (i = 0, j = 0; i < nobjs; i += 2, ++j) {
-        int k;
         if (CffiTypeAndAttrsParse(ipCtxP,
                                   objs[i + 1],
                                   CFFI_F_TYPE_PARSE_FIELD,
@@ -773,22 +803,17 @@ CffiStructParse(CffiInterpCtx *ipCtxP,
             }
         }
 
-        /* Check for dup field names */
-        for (k = 0; k < j; ++k) {
-            if (!strcmp(Tcl_GetString(objs[i]),
-                        Tcl_GetString(structP->fields[k].nameObj))) {
-                CffiStructUnref(structP);
-                return Tclh_ErrorExists(
-                    ip,
-                    "Field",
-                    objs[i],
-                    "Field names must be unique.");
-            }
-        }
         Tcl_IncrRefCount(objs[i]);
         structP->fields[j].nameObj = objs[i];
         /* Note: update incrementally for structP cleanup in case of errors */
         structP->nFields += 1;
+
+        /* Check for dup field names */
+        if (!CffiStructAddFieldIndex(structP, (int)j)) {
+            CffiStructUnref(structP);
+            return Tclh_ErrorExists(
+                ip, "Field", objs[i], "Field names must be unique.");
+        }
     }
 
     /* Calculate metadata for all fields */
@@ -869,6 +894,15 @@ CffiStructParse(CffiInterpCtx *ipCtxP,
         structP->flags |= CFFI_F_STRUCT_VARSIZE;
     }
 
+    if (!isUnion && !(structP->flags & CFFI_F_STRUCT_VARSIZE)) {
+        for (i = 0; i < nfields; ++i) {
+            if (!CffiFieldIsCacheable(&structP->fields[i].fieldType))
+                break;
+        }
+        if (i == nfields)
+            structP->flags |= CFFI_F_STRUCT_CACHEABLE;
+    }
+
     Tcl_IncrRefCount(nameObj);
     structP->name      = nameObj;
 #ifdef CFFI_USE_LIBFFI
@@ -885,33 +919,111 @@ CffiStructParse(CffiInterpCtx *ipCtxP,
     return TCL_OK;
 }
 
+/*
+ * Internal representation for field names passed to the struct field
+ * access commands. Caches the index of the field in the struct definition
+ * so repeated accesses with the same name object need not look it up.
+ * As for struct values, the definitions epoch guards against the struct
+ * definition having been deleted and its memory reused.
+ */
+typedef struct CffiFieldNameIntRep {
+    CffiInterpCtx *ipCtxP;     /* Context of the struct definition */
+    const CffiStruct *structP; /* Struct definition. Not referenced */
+    Tcl_WideUInt epoch;        /* ipCtxP->definitionsEpoch at lookup */
+    int fieldIndex;            /* Index into structP->fields[] */
+} CffiFieldNameIntRep;
+
+static void CffiFieldNameObjFreeIntRep(Tcl_Obj *objP);
+static void CffiFieldNameObjDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj);
+
+static const Tcl_ObjType cffiFieldNameObjType = {
+    "cffi-fieldname",
+    CffiFieldNameObjFreeIntRep,
+    CffiFieldNameObjDupIntRep,
+    NULL, /* String rep is never invalidated */
+    NULL,
+};
+
+static void
+CffiFieldNameObjFreeIntRep(Tcl_Obj *objP)
+{
+    ckfree(objP->internalRep.twoPtrValue.ptr1);
+    objP->typePtr = NULL;
+}
+
+static void
+CffiFieldNameObjDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj)
+{
+    CffiFieldNameIntRep *dstP = ckalloc(sizeof(*dstP));
+    *dstP = *(CffiFieldNameIntRep *)srcObj->internalRep.twoPtrValue.ptr1;
+    dstObj->internalRep.twoPtrValue.ptr1 = dstP;
+    dstObj->internalRep.twoPtrValue.ptr2 = NULL;
+    dstObj->typePtr = &cffiFieldNameObjType;
+}
+
 /* Function: CffiStructFindField
  * Returns the field index corresponding to a field name
  *
  * Parameters:
- * ip - interpreter. May be NULL if error messages not required.
+ * ipCtxP - interpreter context
  * structP - struct descriptor
- * fieldNameP - name of field
+ * fieldNameObj - name of field
+ *
+ * The field is looked up in the struct's field name index and the result
+ * cached in the internal representation of *fieldNameObj*.
  *
  * Returns:
- * Index of field or -1 if not found.
+ * Index of field or -1 if not found with an error message in the interpreter.
  */
 static int
-CffiStructFindField(Tcl_Interp *ip, CffiStruct *structP, const char *fieldNameP)
+CffiStructFindField(CffiInterpCtx *ipCtxP,
+                    CffiStruct *structP,
+                    Tcl_Obj *fieldNameObj)
 {
-    int i;
+    Tcl_HashEntry *heP;
+    CffiFieldNameIntRep *intRepP;
+    const char *fieldNameP;
+    int fieldIndex;
     char message[100];
 
-    for (i = 0; i < structP->nFields; ++i) {
-        if (!strcmp(fieldNameP, Tcl_GetString(structP->fields[i].nameObj)))
-            return i;
+    if (fieldNameObj->typePtr == &cffiFieldNameObjType) {
+        intRepP =
+            (CffiFieldNameIntRep *)fieldNameObj->internalRep.twoPtrValue.ptr1;
+        if (intRepP->structP == structP && intRepP->ipCtxP == ipCtxP
+            && intRepP->epoch == ipCtxP->definitionsEpoch) {
+            return intRepP->fieldIndex;
+        }
     }
-    snprintf(message,
-             sizeof(message),
-             "No such field in struct definition %s.",
-             Tcl_GetString(structP->name));
-    Tclh_ErrorNotFoundStr(ip, "Field", fieldNameP, message);
-    return -1;
+
+    fieldNameP = Tcl_GetString(fieldNameObj);
+    heP        = Tcl_FindHashEntry(&structP->fieldIndex, fieldNameP);
+    if (heP == NULL) {
+        snprintf(message,
+                 sizeof(message),
+                 "No such field in struct definition %s.",
+                 Tcl_GetString(structP->name));
+        Tclh_ErrorNotFoundStr(ipCtxP->interp, "Field", fieldNameP, message);
+        return -1;
+    }
+    fieldIndex = (int)(intptr_t)Tcl_GetHashValue(heP);
+
+    if (fieldNameObj->typePtr == &cffiFieldNameObjType) {
+        intRepP =
+            (CffiFieldNameIntRep *)fieldNameObj->internalRep.twoPtrValue.ptr1;
+    }
+    else {
+        intRepP = ckalloc(sizeof(*intRepP));
+        if (fieldNameObj->typePtr && fieldNameObj->typePtr->freeIntRepProc)
+            fieldNameObj->typePtr->freeIntRepProc(fieldNameObj);
+        fieldNameObj->internalRep.twoPtrValue.ptr1 = intRepP;
+        fieldNameObj->internalRep.twoPtrValue.ptr2 = NULL;
+        fieldNameObj->typePtr = &cffiFieldNameObjType;
+    }
+    intRepP->ipCtxP     = ipCtxP;
+    intRepP->structP    = structP;
+    intRepP->epoch      = ipCtxP->definitionsEpoch;
+    intRepP->fieldIndex = fieldIndex;
+    return fieldIndex;
 }
 
 static void
@@ -1181,6 +1293,256 @@ CffiStructInfoCmd(Tcl_Interp *ip,
     return TCL_OK;
 }
 
+/*
+ * Tcl_ObjType for caching the native form of struct values. Passing the same
+ * dictionary value repeatedly, for example a configuration struct, then
+ * only needs a copy of the cached native bytes. The cache is only valid for
+ * the struct definition it was converted for and only as long as no
+ * definitions have changed since as enum, alias and nested struct
+ * definitions affect the conversion. Structs containing pointers or strings
+ * are never cached as their native form depends on more than the script
+ * level value. See <CffiFieldIsCacheable>.
+ *
+ * Accessing a cached value as a dictionary regenerates the dictionary from
+ * the string representation, discarding the cache.
+ */
+typedef struct CffiStructValueIntRep {
+    CffiInterpCtx *ipCtxP;     /* Context of the struct definition */
+    const CffiStruct *structP; /* Struct definition. Not referenced */
+    Tcl_WideUInt epoch;        /* ipCtxP->definitionsEpoch at conversion */
+    Tcl_Size dictSize;         /* Number of elements in the dictionary */
+    int size;                  /* Size of native value */
+    union {
+        double d;
+        long long ll;
+        void *p;
+    } bytes[1]; /* Native value. Actually of size *size* */
+} CffiStructValueIntRep;
+
+static void CffiStructValueObjFreeIntRep(Tcl_Obj *objP);
+static void CffiStructValueObjDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj);
+
+static const Tcl_ObjType cffiStructValueObjType = {
+    "cffi-structvalue",
+    CffiStructValueObjFreeIntRep,
+    CffiStructValueObjDupIntRep,
+    NULL, /* String rep is never invalidated */
+    NULL,
+};
+
+static void
+CffiStructValueObjFreeIntRep(Tcl_Obj *objP)
+{
+    ckfree(objP->internalRep.twoPtrValue.ptr1);
+    objP->typePtr = NULL;
+}
+
+static void
+CffiStructValueObjDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj)
+{
+    CffiStructValueIntRep *srcP =
+        (CffiStructValueIntRep *)srcObj->internalRep.twoPtrValue.ptr1;
+    size_t sz = offsetof(CffiStructValueIntRep, bytes) + srcP->size;
+    CffiStructValueIntRep *dstP = ckalloc(sz);
+    memcpy(dstP, srcP, sz);
+    dstObj->internalRep.twoPtrValue.ptr1 = dstP;
+    dstObj->internalRep.twoPtrValue.ptr2 = NULL;
+    dstObj->typePtr = &cffiStructValueObjType;
+}
+
+/* Function: CffiFieldIsCacheable
+ * Returns whether a field's native value depends only on its script value.
+ *
+ * Parameters:
+ * typeAttrsP - field type
+ *
+ * Pointers need to be validated on every conversion and strings are stored
+ * as pointers to transient memory so structs with these field types cannot
+ * have their native form cached.
+ *
+ * Returns:
+ * Non-0 if the field is cacheable, 0 otherwise.
+ */
+static int
+CffiFieldIsCacheable(const CffiTypeAndAttrs *typeAttrsP)
+{
+    switch (typeAttrsP->dataType.baseType) {
+    case CFFI_K_TYPE_SCHAR:
+    case CFFI_K_TYPE_UCHAR:
+    case CFFI_K_TYPE_SHORT:
+    case CFFI_K_TYPE_USHORT:
+    case CFFI_K_TYPE_INT:
+    case CFFI_K_TYPE_UINT:
+    case CFFI_K_TYPE_LONG:
+    case CFFI_K_TYPE_ULONG:
+    case CFFI_K_TYPE_LONGLONG:
+    case CFFI_K_TYPE_ULONGLONG:
+    case CFFI_K_TYPE_FLOAT:
+    case CFFI_K_TYPE_DOUBLE:
+    case CFFI_K_TYPE_CHAR_ARRAY:
+    case CFFI_K_TYPE_UNICHAR_ARRAY:
+    case CFFI_K_TYPE_BYTE_ARRAY:
+    case CFFI_K_TYPE_UUID:
+#ifdef _WIN32
+    case CFFI_K_TYPE_WINCHAR_ARRAY:
+#endif
+        return 1;
+    case CFFI_K_TYPE_STRUCT:
+        return (typeAttrsP->dataType.u.structP->flags
+                & CFFI_F_STRUCT_CACHEABLE)
+            != 0;
+    default:
+        return 0;
+    }
+}
+
+/* Function: CffiStructObjDictSize
+ * Returns the number of elements in a struct dictionary value.
+ *
+ * Parameters:
+ * ip - interpreter
+ * structValueObj - the struct value
+ * sizeP - location to store number of elements
+ *
+ * Unlike *Tcl_DictObjSize*, this does not discard a cached native form.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+CffiResult
+CffiStructObjDictSize(Tcl_Interp *ip, Tcl_Obj *structValueObj, Tcl_Size *sizeP)
+{
+    if (structValueObj->typePtr == &cffiStructValueObjType) {
+        CffiStructValueIntRep *intRepP =
+            (CffiStructValueIntRep *)structValueObj->internalRep.twoPtrValue.ptr1;
+        *sizeP = intRepP->dictSize;
+        return TCL_OK;
+    }
+    return Tcl_DictObjSize(ip, structValueObj, sizeP);
+}
+
+/* Function: CffiStructFromListObj
+ * Constructs a C struct from a list of field values.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * structP - pointer to the struct definition internal form. Must not be
+ *           a union.
+ * structValueObj - list of field values in the order of the fields in the
+ *           struct definition. Missing trailing values are treated as
+ *           for missing dictionary keys in <CffiStructFromObj>.
+ * flags - if CFFI_F_PRESERVE_ON_ERROR is set, the target location will
+ *   be preserved in case of errors.
+ * structResultP - the location where the struct is to be constructed
+ * memlifoP - the memory allocator for fields that are typed as *string*
+ *            or *unistring*. See <CffiStructFromObj>.
+ *
+ * The positional form avoids the dictionary lookups of the field names.
+ * It is not supported for variable sized structs.
+ *
+ * Returns:
+ * *TCL_OK* on success or *TCL_ERROR* on error with message stored in
+ * the interpreter.
+ */
+static CffiResult
+CffiStructFromListObj(CffiInterpCtx *ipCtxP,
+                      const CffiStruct *structP,
+                      Tcl_Obj *structValueObj,
+                      CffiFlags flags,
+                      void *structResultP,
+                      Tclh_Lifo *memlifoP)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    Tcl_Obj **valueObjs;
+    Tcl_Size nValues;
+    int i;
+    Tcl_DString ds;
+    CffiResult ret;
+    void *structAddress;
+
+    CFFI_ASSERT(!CffiStructIsUnion(structP));
+
+    if (CffiStructIsVariableSize(structP)) {
+        return CffiErrorStructIsVariableSize(
+            ip, (CffiStruct *)structP, "list conversion");
+    }
+    CHECK(Tcl_ListObjGetElements(ip, structValueObj, &nValues, &valueObjs));
+    if (nValues > structP->nFields) {
+        return Tclh_ErrorInvalidValue(
+            ip,
+            structValueObj,
+            "Number of values exceeds number of struct fields.");
+    }
+
+    /* See comments in CffiStructFromObj */
+    if (flags & CFFI_F_PRESERVE_ON_ERROR) {
+        Tcl_DStringInit(&ds);
+        Tcl_DStringSetLength(&ds, structP->size);
+        structAddress = Tcl_DStringValue(&ds);
+    }
+    else
+        structAddress = structResultP;
+
+    if (structP->flags & CFFI_F_STRUCT_CLEAR)
+        memset(structAddress, 0, structP->size);
+
+    ret = TCL_OK;
+    for (i = 0; i < structP->nFields; ++i) {
+        Tcl_Obj *valueObj;
+        const CffiField *fieldP = &structP->fields[i];
+        void *fieldAddress      = fieldP->offset + (char *)structAddress;
+
+        if (i < nValues)
+            valueObj = valueObjs[i];
+        else {
+            if (fieldP->fieldType.flags & CFFI_F_ATTR_STRUCTSIZE) {
+                CFFI_ASSERT(structP->structSizeFieldIndex == i);
+                CffiStructInitSizeField(structP, structAddress);
+                continue;
+            }
+            valueObj = fieldP->fieldType.parseModeSpecificObj;
+            if (valueObj == NULL) {
+                if (structP->flags & CFFI_F_STRUCT_CLEAR)
+                    continue;
+                ret = Tclh_ErrorNotFound(ip,
+                                         "Struct field",
+                                         fieldP->nameObj,
+                                         "Field missing in struct list value.");
+                break;
+            }
+        }
+        /* Nested structs are positional only if the field says so */
+        ret = CffiNativeValueFromObj(
+            ipCtxP,
+            &fieldP->fieldType,
+            0,
+            valueObj,
+            flags & ~(CFFI_F_PRESERVE_ON_ERROR | CFFI_F_AS_LIST),
+            fieldAddress,
+            0,
+            memlifoP);
+        if (ret != TCL_OK)
+            break;
+    }
+
+    if (flags & CFFI_F_PRESERVE_ON_ERROR) {
+        if (ret == TCL_OK)
+            memcpy(structResultP, structAddress, structP->size);
+        Tcl_DStringFree(&ds);
+    }
+
+    if (ret != TCL_OK && i < structP->nFields) {
+        Tcl_AppendResult(ip,
+                         " Error converting field ",
+                         Tcl_GetString(structP->name),
+                         ".",
+                         Tcl_GetString(structP->fields[i].nameObj),
+                         " to a native value.",
+                         NULL);
+    }
+    return ret;
+}
+
 /* Function: CffiStructFromObj
  * Constructs a C struct or union from a *Tcl_Obj* wrapper.
  *
@@ -1199,6 +1561,14 @@ CffiStructInfoCmd(Tcl_Interp *ip,
  *            result in an error being raised. Caller is responsible
  *            for ensuring the memory allocated from *memlifoP* stays
  *            allocated for the lifetime of the constructed struct.
+ *
+ * If *flags* contains CFFI_F_AS_LIST, *structValueObj* is a list of field
+ * values in field order instead of a dictionary. See <CffiStructFromListObj>.
+ *
+ * For structs marked with CFFI_F_STRUCT_CACHEABLE, the constructed value is
+ * cached in the internal representation of *structValueObj* and copied
+ * on subsequent calls with the same value.
+ *
  * Returns:
  * *TCL_OK* on success with a pointer to the structure stored in *structPP* or
  * *TCL_ERROR* on error with message stored in the interpreter.
@@ -1217,6 +1587,23 @@ CffiStructFromObj(CffiInterpCtx *ipCtxP,
     CffiResult ret;
     void *structAddress;
     int structSize;
+    CffiStructValueIntRep *intRepP;
+
+    if ((flags & CFFI_F_AS_LIST) && !CffiStructIsUnion(structP)) {
+        return CffiStructFromListObj(
+            ipCtxP, structP, structValueObj, flags, structResultP, memlifoP);
+    }
+
+    if (structValueObj->typePtr == &cffiStructValueObjType) {
+        intRepP =
+            (CffiStructValueIntRep *)structValueObj->internalRep.twoPtrValue.ptr1;
+        if (intRepP->structP == structP && intRepP->ipCtxP == ipCtxP
+            && intRepP->epoch == ipCtxP->definitionsEpoch) {
+            CFFI_ASSERT(intRepP->size == structP->size);
+            memcpy(structResultP, intRepP->bytes, intRepP->size);
+            return TCL_OK;
+        }
+    }
 
     CHECK(CffiStructSizeForObj(
         ipCtxP, structP, structValueObj, &structSize, NULL));
@@ -1342,6 +1729,26 @@ CffiStructFromObj(CffiInterpCtx *ipCtxP,
                              Tcl_GetString(structP->fields[i].nameObj),
                              " to a native value.",
                              NULL);
+    } else if (structP->flags & CFFI_F_STRUCT_CACHEABLE) {
+        Tcl_Size dictSize;
+        if (Tcl_DictObjSize(NULL, structValueObj, &dictSize) == TCL_OK) {
+            /* Replace the dictionary internal rep but keep the string rep */
+            (void)Tcl_GetString(structValueObj);
+            intRepP = ckalloc(offsetof(CffiStructValueIntRep, bytes)
+                              + structSize);
+            intRepP->ipCtxP   = ipCtxP;
+            intRepP->structP  = structP;
+            intRepP->epoch    = ipCtxP->definitionsEpoch;
+            intRepP->dictSize = dictSize;
+            intRepP->size     = structSize;
+            memcpy(intRepP->bytes, structResultP, structSize);
+            if (structValueObj->typePtr
+                && structValueObj->typePtr->freeIntRepProc)
+                structValueObj->typePtr->freeIntRepProc(structValueObj);
+            structValueObj->internalRep.twoPtrValue.ptr1 = intRepP;
+            structValueObj->internalRep.twoPtrValue.ptr2 = NULL;
+            structValueObj->typePtr = &cffiStructValueObjType;
+        }
     } else if (CffiStructIsUnion(structP)) {
         Tcl_Size numDictElems;
         if (i == structP->nFields) {
@@ -1368,10 +1775,13 @@ CffiStructFromObj(CffiInterpCtx *ipCtxP,
  * ipCtxP - interpreter context
  * structP - pointer to the struct definition internal descriptor
  * valueP - pointer to C structure to wrap
+ * flags - if CFFI_F_AS_LIST is set, the struct is returned as a list of
+ *    field values in field order instead of a dictionary
  * valueObjP - location to store the pointer to the returned Tcl_Obj.
  *    Following standard practice, the reference ocunt on the Tcl_Obj is 0.
  *
- * For structs valueObjP will hold a dictionary. For unions, it is a binary.
+ * For structs valueObjP will hold a dictionary or list. For unions, it is
+ * a binary.
  *
  * Returns:
  * *TCL_OK* on success with the wrapper Tcl_Obj pointer stored in valueObjP.
@@ -1381,6 +1791,7 @@ CffiResult
 CffiStructToObj(CffiInterpCtx *ipCtxP,
                 const CffiStruct *structP,
                 void *valueP,
+                CffiFlags flags,
                 Tcl_Obj **valueObjP)
 {
     int i;
@@ -1398,7 +1809,9 @@ CffiStructToObj(CffiInterpCtx *ipCtxP,
         return TCL_OK;
     }
 
-    valueObj = Tcl_NewListObj(structP->nFields, NULL);
+    valueObj = Tcl_NewListObj(
+        (flags & CFFI_F_AS_LIST) ? structP->nFields : 2 * structP->nFields,
+        NULL);
     for (i = 0; i < structP->nFields; ++i) {
         const CffiField *fieldP = &structP->fields[i];
         Tcl_Obj *fieldObj;
@@ -1420,7 +1833,8 @@ CffiStructToObj(CffiInterpCtx *ipCtxP,
                                    &fieldObj);
         if (ret != TCL_OK)
             goto error_return;
-        Tcl_ListObjAppendElement( ip, valueObj, fieldP->nameObj);
+        if ((flags & CFFI_F_AS_LIST) == 0)
+            Tcl_ListObjAppendElement( ip, valueObj, fieldP->nameObj);
         Tcl_ListObjAppendElement( ip, valueObj, fieldObj);
     }
     *valueObjP = valueObj;
@@ -1486,6 +1900,47 @@ CffiErrorStructIsVariableSize(Tcl_Interp *ip, CffiStruct *structP, const char *o
         ip, oper, structP->name, "Operation not permitted on variable sized structs.");
 }
 
+/* Function: CffiStructAsListOption
+ * Checks for a leading *-aslist* option in struct command arguments.
+ *
+ * Parameters:
+ * ip - interpreter
+ * structP - struct descriptor. The option is not valid for unions since
+ *   their values are binary strings, not field values.
+ * objc - number of arguments in objv[]
+ * objv - argument array. This includes the command and subcommand provided
+ *   at the script level.
+ * flagsP - location to store CFFI_F_AS_LIST if the option is present
+ *   and 0 otherwise
+ * indexP - location to store the index of the first argument following
+ *   the option
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter if
+ * the option is specified for a union.
+ */
+static CffiResult
+CffiStructAsListOption(Tcl_Interp *ip,
+                       const CffiStruct *structP,
+                       int objc,
+                       Tcl_Obj *const objv[],
+                       CffiFlags *flagsP,
+                       int *indexP)
+{
+    if (objc > 2 && !strcmp(Tcl_GetString(objv[2]), "-aslist")) {
+        if (CffiStructIsUnion(structP)) {
+            return Tclh_ErrorInvalidValue(
+                ip, objv[2], "The -aslist option is not valid for unions.");
+        }
+        *flagsP = CFFI_F_AS_LIST;
+        *indexP = 3;
+        return TCL_OK;
+    }
+    *flagsP = 0;
+    *indexP = 2;
+    return TCL_OK;
+}
+
 /* Function: CffiStructAllocateCmd
  * Allocates memory for one or more structures.
  *
@@ -1507,27 +1962,39 @@ CffiStructAllocateCmd(Tcl_Interp *ip,
                       CffiStructCmdCtx *structCtxP)
 {
     CffiStruct *structP = structCtxP->structP;
+    CffiAllocOptions allocOpts;
     int count;
     int vlaCount = -1;
-    static const char *const opts[] = {"-count", "-vlacount", NULL};
-    enum Opts { COUNT, VLACOUNT };
+    static const char *const opts[] = {
+        "-align", "-count", "-hugepages", "-pool", "-vlacount", NULL};
+    enum Opts { ALIGN, COUNT, HUGEPAGES, POOL, VLACOUNT };
     int optIndex;
     Tcl_WideInt wide;
 
-    CFFI_ASSERT(objc >= 2 && objc <= 6);
+    CFFI_ASSERT(objc >= 2 && objc <= 11);
 
+    allocOpts.poolP     = NULL;
+    allocOpts.align     = 0;
+    allocOpts.hugepages = 0;
     if (objc == 2)
         count = 1;
-    else if (objc == 3) {
+    else if (objc == 3 && strcmp(Tcl_GetString(objv[2]), "-hugepages")) {
         /* Old style - S allocate COUNT */
         CHECK(Tclh_ObjToRangedInt(ip, objv[2], 1, INT_MAX, &wide));
         count = (int)wide;
     } else {
-        /* New style - S allocate ?-count N? ?-vlacount VLACOUNT? */
+        /*
+         * New style - S allocate ?-count N? ?-vlacount VLACOUNT? ?-pool POOL?
+         *   ?-align ALIGNMENT? ?-hugepages?
+         */
         int i;
         count = 1; /* Default */
         for (i = 2; i < objc; ++i) {
             CHECK( Tcl_GetIndexFromObj(ip, objv[i], opts, "option", 0, &optIndex));
+            if (optIndex == HUGEPAGES) {
+                allocOpts.hugepages = 1;
+                continue;
+            }
             if (i == objc-1)
                 return Tclh_ErrorOptionValueMissing(ip, objv[i], NULL);
             ++i;
@@ -1540,8 +2007,21 @@ CffiStructAllocateCmd(Tcl_Interp *ip,
                 CHECK(Tclh_ObjToRangedInt(ip, objv[i], 0, INT_MAX, &wide));
                 vlaCount = (int)wide;
                 break;
+            case POOL:
+                CHECK(CffiPoolFromObj(
+                    structCtxP->ipCtxP, objv[i], &allocOpts.poolP));
+                break;
+            case ALIGN:
+                CHECK(CffiAlignmentFromObj(ip, objv[i], &allocOpts.align));
+                break;
             }
         }
+        if (allocOpts.poolP && (allocOpts.align || allocOpts.hugepages)) {
+            return Tclh_ErrorGeneric(
+                ip,
+                NULL,
+                "The -pool option cannot be used with -align or -hugepages.");
+        }
     }
 
     if (CffiStructIsVariableSize(structP)) {
@@ -1568,19 +2048,32 @@ CffiStructAllocateCmd(Tcl_Interp *ip,
     if (count >= TCL_SIZE_MAX/structSize) {
         return Tclh_ErrorAllocation(ip, "Struct", "Array size too large.");
     }
-    resultP = ckalloc(count * structSize);
+    CHECK(CffiMemoryAlloc(
+        structCtxP->ipCtxP, count * structSize, &allocOpts, &resultP));
 
+    /* Registration may replace tag of a stale registration */
+    CffiPointerRegistering(structCtxP->ipCtxP, resultP);
     if (Tclh_PointerRegister(ip,
                              structCtxP->ipCtxP->tclhCtxP,
                              resultP,
                              structP->name,
                              &resultObj)
         != TCL_OK) {
-        ckfree(resultP);
-        return TCL_ERROR;
+        goto free_and_error;
     }
+    /*
+     * Record the allocation as an address range as well so accesses are
+     * bounds checked and pointers to array elements are treated as derived
+     * from the registered base pointer.
+     */
+    CffiPointerRangeRecordAllocation(
+        structCtxP->ipCtxP, resultP, count * structSize);
     Tcl_SetObjResult(ip, resultObj);
     return TCL_OK;
+
+free_and_error:
+    CffiMemoryFree(structCtxP->ipCtxP, resultP);
+    return TCL_ERROR;
 }
 
 /* Function: CffiStructNewCmd
@@ -1592,7 +2085,9 @@ CffiStructAllocateCmd(Tcl_Interp *ip,
  * objv - argument array.
  * scructCtxP - pointer to struct context
  *
- * obj[2] - initializer for the struct
+ * The arguments following the subcommand are optional allocation options
+ * as accepted by <CffiAllocOptionsParse> and an optional initializer for
+ * the struct.
  *
  * Returns:
  * *TCL_OK* on success with the wrapped pointer as the interpreter result.
@@ -1606,36 +2101,59 @@ CffiStructNewCmd(Tcl_Interp *ip,
 {
     CffiStruct *structP = structCtxP->structP;
     CffiInterpCtx *ipCtxP = structCtxP->ipCtxP;
+    CffiAllocOptions allocOpts;
+    Tcl_Obj *initObj;
     Tcl_Obj *resultObj;
     void *resultP;
     int ret;
     int structSize;
+    CffiFlags flags;
+    int i;
 
-    CFFI_ASSERT(objc == 2 || objc == 3);
+    CFFI_ASSERT(objc >= 2 && objc <= 9);
+
+    CHECK(CffiStructAsListOption(ip, structP, objc, objv, &flags, &i));
+    CHECK(CffiAllocOptionsParse(ipCtxP, objc, objv, &i, &allocOpts));
+    if (objc - i > 1) {
+        Tcl_WrongNumArgs(ip,
+                         2,
+                         objv,
+                         "?-aslist? ?-align ALIGNMENT? ?-hugepages? "
+                         "?-pool POOL? ?INITIALIZER?");
+        return TCL_ERROR;
+    }
+    initObj = i < objc ? objv[i] : NULL;
+
+    if (initObj && (flags & CFFI_F_AS_LIST)
+        && CffiStructIsVariableSize(structP)) {
+        return CffiErrorStructIsVariableSize(ip, structP, "new");
+    }
 
     /* Note - this will fail for variable size structs when objc==2. TODO */
     CHECK(CffiStructSizeForObj(
-        ipCtxP, structP, objc == 2 ? NULL : objv[2], &structSize, NULL));
+        ipCtxP, structP, initObj, &structSize, NULL));
 
-    resultP = ckalloc(structSize);
-    if (objc == 3)
+    CHECK(CffiMemoryAlloc(ipCtxP, structSize, &allocOpts, &resultP));
+    if (initObj)
         ret = CffiStructFromObj(
-            structCtxP->ipCtxP, structP, objv[2], 0, resultP, NULL);
+            structCtxP->ipCtxP, structP, initObj, flags, resultP, NULL);
     else
         ret = CffiStructObjDefault(structCtxP->ipCtxP, structP, resultP);
 
     if (ret == TCL_OK) {
+        CffiPointerRegistering(ipCtxP, resultP);
         ret = Tclh_PointerRegister(ip,
                                    structCtxP->ipCtxP->tclhCtxP,
                                    resultP,
                                    structP->name,
                                    &resultObj);
         if (ret == TCL_OK) {
+            CffiPointerRangeRecordAllocation(ipCtxP, resultP, structSize);
             Tcl_SetObjResult(ip, resultObj);
             return TCL_OK;
         }
     }
-    ckfree(resultP);
+    CffiMemoryFree(ipCtxP, resultP);
     return TCL_ERROR;
 }
 
@@ -1696,7 +2214,8 @@ CffiStructObjDefault(CffiInterpCtx *ipCtxP,
  * structCtxP - safe pointer to struct context
  * safe - if non-0, structCtxP must be a registered pointer
  *
- * The **objv** contains the following arguments:
+ * The **objv** contains the following arguments after an optional
+ * *-aslist* option:
  * objv[2] - pointer to memory
  * objv[3] - optional, index into array of structs pointed to by objv[2]
  *
@@ -1716,15 +2235,22 @@ CffiStructFromNativePointer(Tcl_Interp *ip,
     CffiInterpCtx *ipCtxP = structCtxP->ipCtxP;
     void *structAddr;
     Tcl_Obj *resultObj;
+    CffiFlags flags;
+    int i;
 
+    CHECK(CffiStructAsListOption(ip, structP, objc, objv, &flags, &i));
+    if (objc - i < 1 || objc - i > 2) {
+        Tcl_WrongNumArgs(ip, 2, objv, "?-aslist? POINTER ?INDEX?");
+        return TCL_ERROR;
+    }
     CHECK(CffiStructComputeAddress(ipCtxP,
                                    structP,
-                                   objv[2],
+                                   objv[i],
                                    safe,
-                                   objc > 3 ? objv[3] : NULL,
+                                   objc > i + 1 ? objv[i + 1] : NULL,
                                    &structAddr));
 
-    CHECK(CffiStructToObj(ipCtxP, structP, structAddr, &resultObj));
+    CHECK(CffiStructToObj(ipCtxP, structP, structAddr, flags, &resultObj));
 
     Tcl_SetObjResult(ip, resultObj);
     return TCL_OK;
@@ -1800,9 +2326,10 @@ CffiStructFromNativeCmd(Tcl_Interp *ip,
  * structCtxP - pointer to struct context
  * safe - if non-0, objv[2] must be a registered pointer
  *
- * The **objv** contains the following arguments:
+ * The **objv** contains the following arguments after an optional
+ * *-aslist* option:
  * objv[2] - pointer to memory
- * objv[3] - dictionary value to use as initializer
+ * objv[3] - dictionary (or list if *-aslist*) value to use as initializer
  * objv[4] - optional, index into array of structs pointed to by objv[2]
  *
  * Returns:
@@ -1819,6 +2346,15 @@ CffiStructToNativePointer(Tcl_Interp *ip,
     void *structAddr;
     CffiStruct *structP = structCtxP->structP;
     CffiInterpCtx *ipCtxP = structCtxP->ipCtxP;
+    CffiFlags flags;
+    int i;
+
+    CHECK(CffiStructAsListOption(ip, structP, objc, objv, &flags, &i));
+    if (objc - i < 2 || objc - i > 3) {
+        Tcl_WrongNumArgs(
+            ip, 2, objv, "?-aslist? POINTER INITIALIZER ?INDEX?");
+        return TCL_ERROR;
+    }
 
     if (CffiStructIsVariableSize(structP)) {
         return CffiErrorStructIsVariableSize(ip, structP, "tonative");
@@ -1826,15 +2362,16 @@ CffiStructToNativePointer(Tcl_Interp *ip,
 
     CHECK(CffiStructComputeAddress(ipCtxP,
                                    structP,
-                                   objv[2],
+                                   objv[i],
                                    safe,
-                                   objc > 4 ? objv[4] : NULL,
+                                   objc > i + 2 ? objv[i + 2] : NULL,
                                    &structAddr));
+    CHECK(CffiMemoryCheckWritable(ipCtxP, objv[i], structAddr));
 
     CHECK(CffiStructFromObj(ipCtxP,
                             structP,
-                            objv[3],
-                            CFFI_F_PRESERVE_ON_ERROR,
+                            objv[i + 1],
+                            flags | CFFI_F_PRESERVE_ON_ERROR,
                             structAddr,
                             NULL));
 
@@ -1911,7 +2448,9 @@ CffiStructToNativeUnsafeCmd(Tcl_Interp *ip,
  * structCtxP - pointer to struct context
  * safe - if non-0, objv[2] must be a registered pointer
  *
- * The **objv** contains the following arguments:
+ * The **objv** contains the following arguments after an optional
+ * *-aslist* option which causes struct valued fields to be returned as
+ * positional lists:
  * objv[2] - pointer to memory holding the struct value
  * objv[3] - field name
  * objv[4] - optional, index into array of structs pointed to by objv[2]
@@ -1937,26 +2476,34 @@ CffiStructGetNativePointer(Tcl_Interp *ip,
     void *fldAddr;
     int fldArraySize;
     int fldIndex;
+    CffiTypeAndAttrs fieldType;
+    CffiFlags flags;
+    int i;
 
+    CHECK(CffiStructAsListOption(ip, structP, objc, objv, &flags, &i));
+    if (objc - i < 2 || objc - i > 3) {
+        Tcl_WrongNumArgs(ip, 2, objv, "?-aslist? POINTER FIELD ?INDEX?");
+        return TCL_ERROR;
+    }
     CHECK(CffiStructComputeAddress(ipCtxP,
                                    structP,
-                                   objv[2],
+                                   objv[i],
                                    safe,
-                                   objc > 4 ? objv[4] : NULL,
+                                   objc > i + 2 ? objv[i + 2] : NULL,
                                    &structAddr));
     CHECK(CffiStructComputeFieldAddress(ipCtxP,
                                         structP,
                                         structAddr,
-                                        objv[3],
+                                        objv[i + 1],
                                         &fldIndex,
                                         &fldAddr,
                                         &fldArraySize));
-    CHECK(CffiNativeValueToObj(ipCtxP,
-                               &structP->fields[fldIndex].fieldType,
-                               fldAddr,
-                               0,
-                               fldArraySize,
-                               &valueObj));
+    /* Shallow copy only to add the attribute. Must not be cleaned up. */
+    fieldType = structP->fields[fldIndex].fieldType;
+    if (flags & CFFI_F_AS_LIST)
+        fieldType.flags |= CFFI_F_ATTR_LIST;
+    CHECK(CffiNativeValueToObj(
+        ipCtxP, &fieldType, fldAddr, 0, fldArraySize, &valueObj));
     Tcl_SetObjResult(ip, valueObj);
     return TCL_OK;
 }
@@ -2063,6 +2610,7 @@ CffiStructSetNativePointer(Tcl_Interp *ip,
                                    safe,
                                    objc > 5 ? objv[5] : NULL,
                                    &structAddr));
+    CHECK(CffiMemoryCheckWritable(ipCtxP, objv[2], structAddr));
     CHECK(CffiStructComputeFieldAddress(ipCtxP,
                                         structP,
                                         structAddr,
@@ -2298,6 +2846,360 @@ CffiStructGetNativeFieldsUnsafeCmd(Tcl_Interp *ip,
     return CffiStructGetNativeFieldsPointer(ip, objc, objv, structCtxP, 0);
 }
 
+/* Function: CffiFieldIsVectorColumn
+ * Returns whether a field is stored as a vector in columnar form.
+ *
+ * Parameters:
+ * typeAttrsP - field type
+ *
+ * Numeric scalar fields without enum or bitmask annotations are stored as
+ * vectors. See <CffiVectorNew>.
+ *
+ * Returns:
+ * Non-zero if the field column is a vector, 0 otherwise.
+ */
+static int
+CffiFieldIsVectorColumn(const CffiTypeAndAttrs *typeAttrsP)
+{
+    CffiBaseType baseType = typeAttrsP->dataType.baseType;
+
+    if (!CffiTypeIsNotArray(&typeAttrsP->dataType)
+        || (typeAttrsP->flags & (CFFI_F_ATTR_ENUM | CFFI_F_ATTR_BITMASK)))
+        return 0;
+    return CffiTypeIsInteger(baseType) || baseType == CFFI_K_TYPE_FLOAT
+        || baseType == CFFI_K_TYPE_DOUBLE;
+}
+
+/* Function: CffiStructCheckArrayBounds
+ * Verifies an array of structs lies within the memory allocated for it.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * structP - struct descriptor. Must not be variable sized.
+ * ptrObj - wrapped pointer for error messages
+ * baseP - address of the first struct in the array
+ * count - number of structs in the array
+ *
+ * Pointers whose allocation size is not known are not checked.
+ *
+ * Returns:
+ * *TCL_OK* if in bounds or bounds are not known, *TCL_ERROR* with error
+ * message in interpreter otherwise.
+ */
+static CffiResult
+CffiStructCheckArrayBounds(CffiInterpCtx *ipCtxP,
+                           CffiStruct *structP,
+                           Tcl_Obj *ptrObj,
+                           char *baseP,
+                           Tcl_Size count)
+{
+    char *endP;
+
+    if (ipCtxP->nPointerRanges == 0
+        || !CffiPointerRangeBounds(ipCtxP, baseP, &endP))
+        return TCL_OK;
+    if (count > (endP - baseP) / structP->size) {
+        return Tclh_ErrorInvalidValue(
+            ipCtxP->interp,
+            ptrObj,
+            "Memory region extends beyond the end of the allocation.");
+    }
+    return TCL_OK;
+}
+
+/* Function: CffiStructToColumnsCmd
+ * Returns the fields of an array of native structs as columns.
+ *
+ * Parameters:
+ * ip - Interpreter
+ * objc - number of arguments in objv[]. Caller should have checked for
+ *        total of 4-5 arguments.
+ * objv - argument array. This includes the command and subcommand provided
+ *   at the script level.
+ * structCtxP - pointer to struct context
+ *
+ * The **objv** contains the following arguments:
+ * objv[2] - safe pointer to the array of structs
+ * objv[3] - number of structs in the array
+ * objv[4] - optional, list of names of fields to retrieve. Defaults to all
+ *   fields.
+ *
+ * Each column is extracted by walking the array with a stride of the struct
+ * size. Numeric fields are returned as vectors and other fields as lists.
+ *
+ * Returns:
+ * *TCL_OK* on success with a dictionary mapping field names to columns
+ * as the interp result;
+ * *TCL_ERROR* on failure with an error message in the interpreter.
+ */
+static CffiResult
+CffiStructToColumnsCmd(Tcl_Interp *ip,
+                       int objc,
+                       Tcl_Obj *const objv[],
+                       CffiStructCmdCtx *structCtxP)
+{
+    CffiStruct *structP   = structCtxP->structP;
+    CffiInterpCtx *ipCtxP = structCtxP->ipCtxP;
+    Tcl_Obj **fieldNameObjs = NULL;
+    Tcl_Size nFieldNames;
+    Tcl_Obj *resultObj;
+    Tcl_WideInt wide;
+    Tcl_Size count, row;
+    char *baseP;
+    int i;
+
+    CFFI_ASSERT(objc == 4 || objc == 5);
+
+    if (CffiStructIsVariableSize(structP)) {
+        return CffiErrorStructIsVariableSize(ip, structP, "tocolumns");
+    }
+    CHECK(Tclh_ObjToRangedInt(
+        ip, objv[3], 0, TCL_SIZE_MAX / structP->size, &wide));
+    count = (Tcl_Size)wide;
+    if (objc > 4) {
+        CHECK(Tcl_ListObjGetElements(ip, objv[4], &nFieldNames, &fieldNameObjs));
+    }
+    else
+        nFieldNames = structP->nFields;
+    CHECK(CffiStructComputeAddress(
+        ipCtxP, structP, objv[2], 1, NULL, (void **)&baseP));
+    CHECK(CffiStructCheckArrayBounds(ipCtxP, structP, objv[2], baseP, count));
+
+    resultObj = Tcl_NewDictObj();
+    for (i = 0; i < nFieldNames; ++i) {
+        const CffiField *fieldP;
+        Tcl_Obj *columnObj;
+        char *fromP;
+        int fldIndex;
+
+        if (fieldNameObjs) {
+            fldIndex = CffiStructFindField(ipCtxP, structP, fieldNameObjs[i]);
+            if (fldIndex < 0)
+                goto error_return;
+        }
+        else
+            fldIndex = i;
+        fieldP = &structP->fields[fldIndex];
+        fromP  = fieldP->offset + baseP;
+
+        if (CffiFieldIsVectorColumn(&fieldP->fieldType)) {
+            int elemSize = fieldP->fieldType.dataType.baseTypeSize;
+            char *toP;
+            columnObj = CffiVectorNew(fieldP->fieldType.dataType.baseType,
+                                      elemSize,
+                                      count,
+                                      (void **)&toP);
+            for (row = 0; row < count; ++row) {
+                memcpy(toP, fromP, elemSize);
+                toP += elemSize;
+                fromP += structP->size;
+            }
+        }
+        else {
+            columnObj = Tcl_NewListObj(count, NULL);
+            for (row = 0; row < count; ++row) {
+                Tcl_Obj *valueObj;
+                if (CffiNativeValueToObj(ipCtxP,
+                                         &fieldP->fieldType,
+                                         fromP,
+                                         0,
+                                         fieldP->fieldType.dataType.arraySize,
+                                         &valueObj)
+                    != TCL_OK) {
+                    Tcl_DecrRefCount(columnObj);
+                    goto error_return;
+                }
+                Tcl_ListObjAppendElement(NULL, columnObj, valueObj);
+                fromP += structP->size;
+            }
+        }
+        Tcl_DictObjPut(NULL, resultObj, fieldP->nameObj, columnObj);
+    }
+    Tcl_SetObjResult(ip, resultObj);
+    return TCL_OK;
+
+error_return:
+    Tcl_DecrRefCount(resultObj);
+    return TCL_ERROR;
+}
+
+/* Function: CffiStructFromColumnsCmd
+ * Initializes an array of native structs from columns of field values.
+ *
+ * Parameters:
+ * ip - Interpreter
+ * objc - number of arguments in objv[]. Caller should have checked for
+ *        total of 4 arguments.
+ * objv - argument array. This includes the command and subcommand provided
+ *   at the script level.
+ * structCtxP - pointer to struct context
+ *
+ * The **objv** contains the following arguments:
+ * objv[2] - safe pointer to memory for the array of structs
+ * objv[3] - dictionary mapping field names to columns of values. All
+ *   columns must have the same length, which is the number of structs
+ *   written. Columns may be vectors or lists.
+ *
+ * Columns that are vectors of the same type as the field are copied
+ * without per element conversion. Fields missing from the dictionary are
+ * defaulted as in <CffiStructFromObj>. Unlike the *tonative* method, the
+ * memory content is not preserved on errors.
+ *
+ * Returns:
+ * *TCL_OK* on success with the number of structs written as the interp
+ * result;
+ * *TCL_ERROR* on failure with an error message in the interpreter.
+ */
+static CffiResult
+CffiStructFromColumnsCmd(Tcl_Interp *ip,
+                         int objc,
+                         Tcl_Obj *const objv[],
+                         CffiStructCmdCtx *structCtxP)
+{
+    CffiStruct *structP   = structCtxP->structP;
+    CffiInterpCtx *ipCtxP = structCtxP->ipCtxP;
+    Tcl_Obj **columnObjs;
+    Tcl_Size count, row;
+    Tcl_DString ds;
+    char *baseP;
+    CffiResult ret;
+    int i;
+
+    CFFI_ASSERT(objc == 4);
+
+    if (CffiStructIsVariableSize(structP)) {
+        return CffiErrorStructIsVariableSize(ip, structP, "fromcolumns");
+    }
+    CHECK(CffiStructComputeAddress(
+        ipCtxP, structP, objv[2], 1, NULL, (void **)&baseP));
+    CHECK(CffiMemoryCheckWritable(ipCtxP, objv[2], baseP));
+
+    /* Collect the columns and verify they are all the same length */
+    columnObjs = ckalloc(structP->nFields * sizeof(Tcl_Obj *));
+    count      = -1; /* No column seen yet */
+    ret        = TCL_OK;
+    for (i = 0; i < structP->nFields; ++i) {
+        Tcl_Size len;
+        ret = Tcl_DictObjGet(
+            ip, objv[3], structP->fields[i].nameObj, &columnObjs[i]);
+        if (ret != TCL_OK)
+            goto vamoose;
+        if (columnObjs[i] == NULL)
+            continue;
+        if (CffiVectorValues(columnObjs[i],
+                             structP->fields[i].fieldType.dataType.baseType,
+                             &len)
+            == NULL) {
+            ret = Tcl_ListObjLength(ip, columnObjs[i], &len);
+            if (ret != TCL_OK)
+                goto vamoose;
+        }
+        if (count < 0)
+            count = len;
+        else if (len != count) {
+            ret = Tclh_ErrorInvalidValue(
+                ip, columnObjs[i], "Columns must all have the same length.");
+            goto vamoose;
+        }
+    }
+    if (count <= 0)
+        goto vamoose;
+
+    ret = CffiStructCheckArrayBounds(ipCtxP, structP, objv[2], baseP, count);
+    if (ret != TCL_OK)
+        goto vamoose;
+
+    if (structP->flags & CFFI_F_STRUCT_CLEAR)
+        memset(baseP, 0, count * structP->size);
+
+    for (i = 0; i < structP->nFields && ret == TCL_OK; ++i) {
+        const CffiField *fieldP = &structP->fields[i];
+        const void *vectorP;
+        Tcl_Obj **valueObjs;
+        Tcl_Size len;
+        char *toP = fieldP->offset + baseP;
+
+        if (columnObjs[i] == NULL) {
+            if (fieldP->fieldType.flags & CFFI_F_ATTR_STRUCTSIZE) {
+                for (row = 0; row < count; ++row)
+                    CffiStructInitSizeField(structP, row * structP->size + baseP);
+                continue;
+            }
+            if (fieldP->fieldType.parseModeSpecificObj == NULL) {
+                if (structP->flags & CFFI_F_STRUCT_CLEAR)
+                    continue;
+                ret = Tclh_ErrorNotFound(ip,
+                                         "Struct field",
+                                         fieldP->nameObj,
+                                         "Field missing in struct columns value.");
+                continue;
+            }
+            /* Convert the default once and replicate it */
+            Tcl_DStringInit(&ds);
+            Tcl_DStringSetLength(&ds, fieldP->size);
+            ret = CffiNativeValueFromObj(ipCtxP,
+                                         &fieldP->fieldType,
+                                         0,
+                                         fieldP->fieldType.parseModeSpecificObj,
+                                         0,
+                                         Tcl_DStringValue(&ds),
+                                         0,
+                                         NULL);
+            if (ret == TCL_OK) {
+                for (row = 0; row < count; ++row) {
+                    memcpy(toP, Tcl_DStringValue(&ds), fieldP->size);
+                    toP += structP->size;
+                }
+            }
+            Tcl_DStringFree(&ds);
+            continue;
+        }
+
+        vectorP = CffiVectorValues(
+            columnObjs[i], fieldP->fieldType.dataType.baseType, &len);
+        if (vectorP && CffiFieldIsVectorColumn(&fieldP->fieldType)) {
+            const char *fromP = vectorP;
+            int elemSize = fieldP->fieldType.dataType.baseTypeSize;
+            for (row = 0; row < count; ++row) {
+                memcpy(toP, fromP, elemSize);
+                fromP += elemSize;
+                toP += structP->size;
+            }
+            continue;
+        }
+
+        ret = Tcl_ListObjGetElements(ip, columnObjs[i], &len, &valueObjs);
+        for (row = 0; ret == TCL_OK && row < count; ++row) {
+            ret = CffiNativeValueFromObj(ipCtxP,
+                                         &fieldP->fieldType,
+                                         0,
+                                         valueObjs[row],
+                                         0,
+                                         toP,
+                                         0,
+                                         NULL);
+            toP += structP->size;
+        }
+    }
+
+    if (ret != TCL_OK) {
+        /* Loop increments i even on failure of the last field */
+        Tcl_AppendResult(ip,
+                         " Error converting field ",
+                         Tcl_GetString(structP->name),
+                         ".",
+                         Tcl_GetString(structP->fields[i - 1].nameObj),
+                         " to a native value.",
+                         NULL);
+    }
+
+vamoose:
+    ckfree(columnObjs);
+    if (ret == TCL_OK)
+        Tcl_SetObjResult(ip, Tcl_NewWideIntObj(count));
+    return ret;
+}
+
 /* Function: CffiStructFieldPointerCmd
  * Returns a pointer to a field in a native struct.
  *
@@ -2379,13 +3281,18 @@ CffiStructFreeCmd(Tcl_Interp *ip,
     void *valueP;
     CffiResult ret;
 
+    CffiPointerRegistryChanged(structCtxP->ipCtxP);
     ret = Tclh_PointerObjUnregister(ip,
                                     structCtxP->ipCtxP->tclhCtxP,
                                     objv[2],
                                     &valueP,
                                     structCtxP->structP->name);
-    if (ret == TCL_OK && valueP)
-        ckfree(valueP);
+    if (ret == TCL_OK && valueP) {
+        CffiPointerRangeUnregister(structCtxP->ipCtxP, valueP);
+        if (structCtxP->ipCtxP->memoryViewsP)
+            CffiMemoryViewsRelease(structCtxP->ipCtxP, valueP, 1, 1);
+        CffiMemoryFree(structCtxP->ipCtxP, valueP);
+    }
     return ret;
 }
 
@@ -2461,7 +3368,7 @@ CffiStructFromBinaryCmd(Tcl_Interp *ip,
     Tcl_Obj *resultObj;
     CffiStruct *structP = structCtxP->structP;
 
-    valueP = Tcl_GetByteArrayFromObj(objv[2], &len);
+    valueP = CffiGetByteArrayFromObj(objv[2], &len);
     if (objc == 4)
         CHECK(Tclh_ObjToUInt(ip, objv[3], &offset));
     else
@@ -2480,7 +3387,7 @@ CffiStructFromBinaryCmd(Tcl_Interp *ip,
         goto truncation;
 
     ret = CffiStructToObj(
-        structCtxP->ipCtxP, structP, offset + valueP, &resultObj);
+        structCtxP->ipCtxP, structP, offset + valueP, 0, &resultObj);
     if (ret == TCL_OK)
         Tcl_SetObjResult(ip, resultObj);
     return ret;
@@ -2551,27 +3458,29 @@ CffiStructInstanceCmd(ClientData cdata,
 {
     CffiStructCmdCtx *structCtxP = (CffiStructCmdCtx *)cdata;
     static const Tclh_SubCommand subCommands[] = {
-        {"allocate", 0, 4, "?-count COUNT? ?-vlacount VLACOUNT?", CffiStructAllocateCmd},
+        {"allocate", 0, 9, "?-count COUNT? ?-vlacount VLACOUNT? ?-pool POOL? ?-align ALIGNMENT? ?-hugepages?", CffiStructAllocateCmd},
         {"describe", 0, 0, "", CffiStructDescribeCmd},
         {"destroy", 0, 0, "", CffiStructDestroyCmd},
         {"fieldpointer", 2, 4, "POINTER FIELD ?TAG? ?INDEX?", CffiStructFieldPointerCmd},
-        {"getnative", 2, 3, "POINTER FIELD ?INDEX?", CffiStructGetNativeCmd},
-        {"getnative!", 2, 3, "POINTER FIELD ?INDEX?", CffiStructGetNativeUnsafeCmd},
+        {"getnative", 2, 4, "?-aslist? POINTER FIELD ?INDEX?", CffiStructGetNativeCmd},
+        {"getnative!", 2, 4, "?-aslist? POINTER FIELD ?INDEX?", CffiStructGetNativeUnsafeCmd},
         {"getnativefields", 2, 3, "POINTER FIELDNAMES ?INDEX?", CffiStructGetNativeFieldsCmd},
         {"getnativefields!", 2, 3, "POINTER FIELDNAMES ?INDEX?", CffiStructGetNativeFieldsUnsafeCmd},
         {"free", 1, 1, "POINTER", CffiStructFreeCmd},
         {"frombinary", 1, 1, "BINARY", CffiStructFromBinaryCmd},
-        {"fromnative", 1, 2, "POINTER ?INDEX?", CffiStructFromNativeCmd},
-        {"fromnative!", 1, 2, "POINTER ?INDEX?", CffiStructFromNativeUnsafeCmd},
+        {"fromcolumns", 2, 2, "POINTER COLUMNS", CffiStructFromColumnsCmd},
+        {"fromnative", 1, 3, "?-aslist? POINTER ?INDEX?", CffiStructFromNativeCmd},
+        {"fromnative!", 1, 3, "?-aslist? POINTER ?INDEX?", CffiStructFromNativeUnsafeCmd},
         {"info", 0, 2, "?-vlacount VLACOUNT?", CffiStructInfoCmd},
         {"name", 0, 0, "", CffiStructNameCmd},
-        {"new", 0, 1, "?INITIALIZER?", CffiStructNewCmd},
+        {"new", 0, 7, "?-aslist? ?-align ALIGNMENT? ?-hugepages? ?-pool POOL? ?INITIALIZER?", CffiStructNewCmd},
         {"setnative", 3, 4, "POINTER FIELD VALUE ?INDEX?", CffiStructSetNativeCmd},
         {"setnative!", 3, 4, "POINTER FIELD VALUE ?INDEX?", CffiStructSetNativeUnsafeCmd},
         {"size", 0, 2, "?-vlacount VLACOUNT?", CffiStructSizeCmd},
         {"tobinary", 1, 1, "DICTIONARY", CffiStructToBinaryCmd},
-        {"tonative", 2, 3, "POINTER INITIALIZER ?INDEX?", CffiStructToNativeCmd},
-        {"tonative!", 2, 3, "POINTER INITIALIZER ?INDEX?", CffiStructToNativeUnsafeCmd},
+        {"tocolumns", 2, 3, "POINTER COUNT ?FIELDS?", CffiStructToColumnsCmd},
+        {"tonative", 2, 4, "?-aslist? POINTER INITIALIZER ?INDEX?", CffiStructToNativeCmd},
+        {"tonative!", 2, 4, "?-aslist? POINTER INITIALIZER ?INDEX?", CffiStructToNativeUnsafeCmd},
         {NULL}
     };
     int cmdIndex;
@@ -2584,6 +3493,7 @@ static void
 CffiStructOrUnionInstanceDeleter(ClientData cdata)
 {
     CffiStructCmdCtx *ctxP = (CffiStructCmdCtx *)cdata;
+    CffiDefinitionsChanged(ctxP->ipCtxP);
     if (ctxP->structP)
         CffiStructUnref(ctxP->structP);
     /* Note ctxP->ipCtxP is interp-wide and not to be freed here */
@@ -2618,7 +3528,7 @@ CffiUnionDecodeCmd(Tcl_Interp *ip,
     CFFI_ASSERT(objc == 4);
     CFFI_ASSERT(CffiStructIsUnion(structP));
 
-    valueP = Tcl_GetByteArrayFromObj(objv[3], &len);
+    valueP = CffiGetByteArrayFromObj(objv[3], &len);
     if (len < structP->size)
         return Tclh_ErrorInvalidValue(
             ip, objv[2], "Union binary value is truncated.");
@@ -2800,6 +3710,65 @@ notfound:
     return TCL_ERROR;
 }
 
+/* Function: CffiStructRenameTrace
+ * Command trace invoked when a struct or union command is renamed.
+ *
+ * Parameters:
+ * cdata - the interpreter context
+ * ip - interpreter
+ * oldName - unused
+ * newName - unused
+ * flags - unused
+ *
+ * Type declarations naming the struct by its command name resolve
+ * differently after a rename so cached parses must be invalidated.
+ */
+static void
+CffiStructRenameTrace(ClientData cdata,
+                      Tcl_Interp *ip,
+                      const char *oldName,
+                      const char *newName,
+                      int flags)
+{
+    CffiDefinitionsChanged((CffiInterpCtx *)cdata);
+}
+
+/* Function: CffiStructCreateCommand
+ * Creates the script level command for a struct or union definition.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * cmdNameObj - fully qualified name of the command
+ * structP - struct descriptor. Its reference count is incremented.
+ *
+ * Any existing command of the same name is replaced. The caller is
+ * responsible for calling <CffiDefinitionsChanged>.
+ */
+void
+CffiStructCreateCommand(CffiInterpCtx *ipCtxP,
+                        Tcl_Obj *cmdNameObj,
+                        CffiStruct *structP)
+{
+    CffiStructCmdCtx *structCtxP;
+
+    structCtxP          = ckalloc(sizeof(*structCtxP));
+    structCtxP->ipCtxP  = ipCtxP;
+    CffiStructRef(structP);
+    structCtxP->structP = structP;
+
+    Tcl_CreateObjCommand(ipCtxP->interp,
+                         Tcl_GetString(cmdNameObj),
+                         CffiStructIsUnion(structP) ? CffiUnionInstanceCmd
+                                                    : CffiStructInstanceCmd,
+                         structCtxP,
+                         CffiStructOrUnionInstanceDeleter);
+    (void)Tcl_TraceCommand(ipCtxP->interp,
+                           Tcl_GetString(cmdNameObj),
+                           TCL_TRACE_RENAME,
+                           CffiStructRenameTrace,
+                           ipCtxP);
+}
+
 static CffiResult
 CffiStructOrUnionObjCmd(ClientData cdata,
                         Tcl_Interp *ip,
@@ -2810,7 +3779,6 @@ CffiStructOrUnionObjCmd(ClientData cdata,
 {
     CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
     CffiStruct *structP = NULL;
-    CffiStructCmdCtx *structCtxP;
     static const Tclh_SubCommand structCommands[] = {
         {"new", 1, 4, "STRUCTDEF ?-clear? ?-pack N?", NULL},
         {"create", 2, 5, "OBJNAME STRUCTDEF ?-clear? ?-pack N?", NULL},
@@ -2901,18 +3869,8 @@ CffiStructOrUnionObjCmd(ClientData cdata,
     if (ret == TCL_OK) {
         if (clear)
             structP->flags |= CFFI_F_STRUCT_CLEAR;
-        structCtxP          = ckalloc(sizeof(*structCtxP));
-        structCtxP->ipCtxP  = ipCtxP;
-        CffiStructRef(structP);
-        structCtxP->structP = structP;
-
-        Tcl_CreateObjCommand(ip,
-                             Tcl_GetString(cmdNameObj),
-                             baseType == CFFI_K_TYPE_STRUCT
-                                 ? CffiStructInstanceCmd
-                                 : CffiUnionInstanceCmd,
-                             structCtxP,
-                             CffiStructOrUnionInstanceDeleter);
+        CffiStructCreateCommand(ipCtxP, cmdNameObj, structP);
+        CffiDefinitionsChanged(ipCtxP);
         Tcl_SetObjResult(ip, cmdNameObj);
     }
     Tcl_DecrRefCount(cmdNameObj);
@@ -30,6 +30,7 @@
 #ifdef _WIN32
 typedef UUID uuid_t;
 #else
+#include <time.h>
 #include <uuid/uuid.h>
 typedef struct UUID {
     uuid_t bytes;
@@ -1348,8 +1349,8 @@ FNPACK(4)
 struct BaseInterface;
 struct DerivedInterface;
 
-int BaseInterfaceGet(struct BaseInterface *);
-int BaseInterfaceSet(struct BaseInterface *, int a);
+DLLEXPORT int BaseInterfaceGet(struct BaseInterface *);
+DLLEXPORT int BaseInterfaceSet(struct BaseInterface *, int a);
 void BaseInterfaceDelete(struct BaseInterface *);
 int DerivedInterfaceSetMax(struct DerivedInterface *tiP, int a, int b);
 
@@ -1391,11 +1392,11 @@ DLLEXPORT BaseInterface *BaseInterfaceNew(int val) {
     tiP->baseValue = val;
     return tiP;
 }
-int BaseInterfaceGet(struct BaseInterface *tiP)
+DLLEXPORT int BaseInterfaceGet(struct BaseInterface *tiP)
 {
     return tiP->baseValue;
 }
-int BaseInterfaceSet(struct BaseInterface *tiP, int newValue)
+DLLEXPORT int BaseInterfaceSet(struct BaseInterface *tiP, int newValue)
 {
     int old = tiP->baseValue;
     tiP->baseValue = newValue;
@@ -1494,3 +1495,53 @@ DLLEXPORT void reverseUuidArray(int n, const UUID *from, UUID *to)
     }
 }
 
+/*
+ * Functions for testing asynchronous calls. These block the calling thread.
+ */
+static void testSleep(int ms)
+{
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts;
+    ts.tv_sec  = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+EXTERN int sleepAndReturn(int ms, int value)
+{
+    testSleep(ms);
+    return value;
+}
+
+EXTERN int sleepAndStore(int ms, int value, int *outP)
+{
+    testSleep(ms);
+    if (outP)
+        *outP = value;
+    return value;
+}
+
+EXTERN void *sleepAndReturnPointer(int ms, void *p)
+{
+    testSleep(ms);
+    return p;
+}
+
+EXTERN int sleepAndSetErrno(int ms, int err)
+{
+    testSleep(ms);
+    errno = err;
+    return -1;
+}
+
+EXTERN unsigned long long computeSum(unsigned int n)
+{
+    unsigned long long sum = 0;
+    unsigned int i;
+    for (i = 0; i < n; ++i)
+        sum += i;
+    return sum;
+}
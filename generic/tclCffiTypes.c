@@ -13,7 +13,7 @@
     (CFFI_F_ATTR_PARAM_MASK | CFFI_F_ATTR_REQUIREMENT_MASK               \
      | CFFI_F_ATTR_SAVEERROR | CFFI_F_ATTR_ERROR_MASK | CFFI_F_ATTR_ENUM \
      | CFFI_F_ATTR_BITMASK | CFFI_F_ATTR_STRUCTSIZE                      \
-     | CFFI_F_ATTR_NOVALUECHECKS | CFFI_F_ATTR_DISCARD)
+     | CFFI_F_ATTR_NOVALUECHECKS | CFFI_F_ATTR_DISCARD | CFFI_F_ATTR_VECTOR)
 
 /* Note string cannot be INOUT parameter */
 #define CFFI_VALID_STRING_ATTRS                                                \
@@ -96,7 +96,7 @@ const struct CffiBaseTypeInfo cffiBaseTypes[] = {
      /* Note NUMERIC left out of float and double for now as the same error
         checks do not apply */
      CFFI_F_ATTR_PARAM_MASK | CFFI_F_ATTR_SAVEERROR | CFFI_F_ATTR_NOVALUECHECKS
-         | CFFI_F_ATTR_DISCARD,
+         | CFFI_F_ATTR_DISCARD | CFFI_F_ATTR_VECTOR,
      sizeof(float)},
     {TOKENANDLEN(double),
      DCSIG(DOUBLE),
@@ -104,13 +104,14 @@ const struct CffiBaseTypeInfo cffiBaseTypes[] = {
      /* Note NUMERIC left out of float and double for now as the same error
         checks do not apply */
      CFFI_F_ATTR_PARAM_MASK | CFFI_F_ATTR_SAVEERROR | CFFI_F_ATTR_NOVALUECHECKS
-         | CFFI_F_ATTR_DISCARD,
+         | CFFI_F_ATTR_DISCARD | CFFI_F_ATTR_VECTOR,
      sizeof(double)},
     {TOKENANDLEN(struct),
      DCSIG(AGGREGATE),
      CFFI_K_TYPE_STRUCT,
      CFFI_F_ATTR_PARAM_MASK | CFFI_F_ATTR_NULLIFEMPTY
-         | CFFI_F_ATTR_SAVEERROR | CFFI_F_ATTR_NOVALUECHECKS | CFFI_F_ATTR_DISCARD,
+         | CFFI_F_ATTR_SAVEERROR | CFFI_F_ATTR_NOVALUECHECKS | CFFI_F_ATTR_DISCARD
+         | CFFI_F_ATTR_LIST,
      0},
     /* For pointer, only LASTERROR/ERRNO make sense for reporting errors */
     /*  */
@@ -206,6 +207,8 @@ enum cffiTypeAttrOpt {
     NULLOK,
     SAVEERROR,
     PINNED,
+    LIST,
+    VECTOR,
 };
 typedef struct CffiAttrs {
     const char *attrName; /* Token */
@@ -280,6 +283,8 @@ static CffiAttrs cffiAttrs[] = {
     {"nullok", NULLOK, /* synonym */ -1, CFFI_F_TYPE_PARSE_ALL, 1},
     {"saveerrors", SAVEERROR, CFFI_F_ATTR_SAVEERROR, CFFI_F_TYPE_PARSE_RETURN, 1},
     {"pinned", PINNED, CFFI_F_ATTR_PINNED, CFFI_F_TYPE_PARSE_ALL, 1},
+    {"list", LIST, CFFI_F_ATTR_LIST, CFFI_F_TYPE_PARSE_ALL, 1},
+    {"vector", VECTOR, CFFI_F_ATTR_VECTOR, CFFI_F_TYPE_PARSE_ALL, 1},
     {NULL}};
 
 CffiResult
@@ -429,10 +434,12 @@ CffiMakePointerObj(CffiInterpCtx *ipCtxP,
         Tcl_IncrRefCount(tagObj);
     }
     if (pv == NULL || flags == CFFI_F_ATTR_UNSAFE) {
-        *ptrObjP    = Tclh_PointerWrap(NULL, tagObj);
+        *ptrObjP    = Tclh_PointerWrap(pv, tagObj);
         ret         = TCL_OK;
     }
     else {
+        /* Registration may replace the tag of an existing registration */
+        CffiPointerRegistering(ipCtxP, pv);
         switch (flags) {
         case CFFI_F_ATTR_COUNTED:
             ret = Tclh_PointerRegisterCounted(
@@ -877,7 +884,7 @@ CffiTypeSizeForValue(CffiInterpCtx *ipCtxP,
     if (typeAttrsP == NULL)
         typeAttrsP = &typeAttrs;
 
-    CHECK(CffiTypeAndAttrsParse(
+    CHECK(CffiTypeAndAttrsParseCached(
         ipCtxP, typeObj, CFFI_F_TYPE_PARSE_FIELD, typeAttrsP));
 
     CffiResult ret;
@@ -1300,9 +1307,33 @@ CffiTypeAndAttrsParse(CffiInterpCtx *ipCtxP,
         case SAVEERROR:
             flags |= CFFI_F_ATTR_SAVEERROR;
             break;
+        case LIST:
+            if (baseType == CFFI_K_TYPE_STRUCT
+                && CffiStructIsVariableSize(typeAttrP->dataType.u.structP)) {
+                message = "The list annotation is not valid for variable "
+                          "sized structs.";
+                goto invalid_format;
+            }
+            flags |= CFFI_F_ATTR_LIST;
+            break;
+        case VECTOR:
+            if (CffiTypeIsNotArray(&typeAttrP->dataType)) {
+                message = "The vector annotation is only valid for arrays.";
+                goto invalid_format;
+            }
+            flags |= CFFI_F_ATTR_VECTOR;
+            break;
         }
     }
 
+    /* Vectors hold raw numeric values, not enum or bitmask names */
+    if ((flags & CFFI_F_ATTR_VECTOR)
+        && (flags & (CFFI_F_ATTR_ENUM | CFFI_F_ATTR_BITMASK))) {
+        message = "The vector annotation cannot be combined with the enum or "
+                  "bitmask annotations.";
+        goto invalid_format;
+    }
+
     /*
      * Redo nullifempty check now that all attributes are collected. It is
      * allowed if the base type allows it or if it is an inout or out param.
@@ -1578,6 +1609,178 @@ error_exit: /* interp must already contain error message */
     return TCL_ERROR;
 }
 
+/* Process-wide source of definition epochs. See CffiDefinitionsChanged */
+TCL_DECLARE_MUTEX(cffiDefinitionsEpochLock)
+static Tcl_WideUInt cffiDefinitionsEpoch;
+
+/*
+ * Tcl_ObjType for caching parsed type declarations. The cached parse is
+ * only valid for the interpreter context, current namespace and parse mode
+ * in which it was parsed, and only as long as no aliases, enums or
+ * structs have been defined, deleted or renamed since. The latter is
+ * tracked through the definitions epoch of the interpreter context.
+ * Struct names are resolved as commands which also depends on the
+ * namespace path. Tcl provides no notification of path changes so the
+ * resolution of the struct name is rechecked instead.
+ */
+typedef struct CffiTypeAndAttrsIntRep {
+    CffiTypeAndAttrs typeAttrs;  /* Parsed declaration */
+    CffiInterpCtx *ipCtxP;       /* Context in which it was parsed */
+    Tcl_Namespace *nsP;          /* Namespace in which it was parsed */
+    Tcl_WideUInt epoch;          /* ipCtxP->definitionsEpoch at parse time */
+    Tcl_Obj *structNameObj;      /* Struct name for struct types, else NULL.
+                                    Caches command resolution. */
+    Tcl_Command structCmd;       /* Command structNameObj resolved to */
+    CffiTypeParseMode parseMode; /* Parse mode used */
+    char nsName[1];              /* Name of nsP as namespaces may be deleted
+                                    and reallocated. Actually variable size */
+} CffiTypeAndAttrsIntRep;
+
+static void CffiTypeAndAttrsObjFreeIntRep(Tcl_Obj *objP);
+static void CffiTypeAndAttrsObjDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj);
+
+static const Tcl_ObjType cffiTypeAndAttrsObjType = {
+    "cffi-typeattrs",
+    CffiTypeAndAttrsObjFreeIntRep,
+    CffiTypeAndAttrsObjDupIntRep,
+    NULL, /* String rep is never invalidated */
+    NULL,
+};
+
+static void
+CffiTypeAndAttrsObjFreeIntRep(Tcl_Obj *objP)
+{
+    CffiTypeAndAttrsIntRep *intRepP =
+        (CffiTypeAndAttrsIntRep *)objP->internalRep.twoPtrValue.ptr1;
+    CffiTypeAndAttrsCleanup(&intRepP->typeAttrs);
+    if (intRepP->structNameObj)
+        Tcl_DecrRefCount(intRepP->structNameObj);
+    ckfree(intRepP);
+    objP->typePtr = NULL;
+}
+
+static void
+CffiTypeAndAttrsObjDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj)
+{
+    CffiTypeAndAttrsIntRep *srcP =
+        (CffiTypeAndAttrsIntRep *)srcObj->internalRep.twoPtrValue.ptr1;
+    size_t nsNameLen = strlen(srcP->nsName);
+    CffiTypeAndAttrsIntRep *dstP = ckalloc(sizeof(*dstP) + nsNameLen);
+    CffiTypeAndAttrsInit(&dstP->typeAttrs, &srcP->typeAttrs);
+    memcpy(dstP->nsName, srcP->nsName, nsNameLen + 1);
+    dstP->ipCtxP    = srcP->ipCtxP;
+    dstP->nsP       = srcP->nsP;
+    dstP->epoch     = srcP->epoch;
+    dstP->structNameObj = srcP->structNameObj;
+    if (dstP->structNameObj)
+        Tcl_IncrRefCount(dstP->structNameObj);
+    dstP->structCmd = srcP->structCmd;
+    dstP->parseMode = srcP->parseMode;
+    dstObj->internalRep.twoPtrValue.ptr1 = dstP;
+    dstObj->internalRep.twoPtrValue.ptr2 = NULL;
+    dstObj->typePtr = &cffiTypeAndAttrsObjType;
+}
+
+/* Function: CffiTypeAndAttrsParseCached
+ * Parses a type and attribute definition caching the result in the
+ * definition object.
+ *
+ * Parameters:
+ *   ipCtxP - Interpreter context
+ *   typeAttrObj - parameter definition object
+ *   parseMode - as for <CffiTypeAndAttrsParse>
+ *   typeAttrP - pointer to structure to hold parsed information.
+ *
+ * This is intended for commands that take a type declaration on every
+ * invocation, such as *memory get*, as opposed to definitions that are
+ * parsed once. The parse is cached in the internal representation of
+ * *typeAttrObj* and reused while it remains valid. See
+ * <CffiDefinitionsChanged>.
+ *
+ * Returns:
+ * TCL_OK on success, else TCL_ERROR with an error message in the interpreter.
+ * On success, caller must call <CffiTypeAndAttrsCleanup> on *typeAttrP*.
+ */
+CffiResult
+CffiTypeAndAttrsParseCached(CffiInterpCtx *ipCtxP,
+                            Tcl_Obj *typeAttrObj,
+                            CffiTypeParseMode parseMode,
+                            CffiTypeAndAttrs *typeAttrP)
+{
+    CffiTypeAndAttrsIntRep *intRepP;
+    Tcl_Namespace *nsP = Tcl_GetCurrentNamespace(ipCtxP->interp);
+
+    if (typeAttrObj->typePtr == &cffiTypeAndAttrsObjType) {
+        intRepP =
+            (CffiTypeAndAttrsIntRep *)typeAttrObj->internalRep.twoPtrValue.ptr1;
+        if (intRepP->ipCtxP == ipCtxP && intRepP->nsP == nsP
+            && intRepP->parseMode == parseMode
+            && intRepP->epoch == ipCtxP->definitionsEpoch
+            && !strcmp(intRepP->nsName, nsP->fullName)
+            && (intRepP->structNameObj == NULL
+                || Tcl_GetCommandFromObj(ipCtxP->interp,
+                                         intRepP->structNameObj)
+                       == intRepP->structCmd)) {
+            CffiTypeAndAttrsInit(typeAttrP, &intRepP->typeAttrs);
+            return TCL_OK;
+        }
+    }
+
+    CHECK(CffiTypeAndAttrsParse(ipCtxP, typeAttrObj, parseMode, typeAttrP));
+
+    /* Replace existing internal rep but keep the string rep */
+    (void)Tcl_GetString(typeAttrObj);
+    size_t nsNameLen = strlen(nsP->fullName);
+    intRepP = ckalloc(sizeof(*intRepP) + nsNameLen);
+    CffiTypeAndAttrsInit(&intRepP->typeAttrs, typeAttrP);
+    memcpy(intRepP->nsName, nsP->fullName, nsNameLen + 1);
+    intRepP->ipCtxP    = ipCtxP;
+    intRepP->nsP       = nsP;
+    intRepP->epoch     = ipCtxP->definitionsEpoch;
+    intRepP->structNameObj = NULL;
+    intRepP->structCmd     = NULL;
+    if (typeAttrP->dataType.baseType == CFFI_K_TYPE_STRUCT) {
+        Tcl_Obj *typeObj;
+        const char *nameP;
+        if (Tcl_ListObjIndex(NULL, typeAttrObj, 0, &typeObj) == TCL_OK
+            && typeObj
+            && (nameP = strchr(Tcl_GetString(typeObj), '.')) != NULL) {
+            const char *lbP = strchr(++nameP, '[');
+            intRepP->structNameObj =
+                Tcl_NewStringObj(nameP, lbP ? (Tcl_Size)(lbP - nameP) : -1);
+            Tcl_IncrRefCount(intRepP->structNameObj);
+            intRepP->structCmd =
+                Tcl_GetCommandFromObj(ipCtxP->interp, intRepP->structNameObj);
+        }
+    }
+    intRepP->parseMode = parseMode;
+    if (typeAttrObj->typePtr && typeAttrObj->typePtr->freeIntRepProc)
+        typeAttrObj->typePtr->freeIntRepProc(typeAttrObj);
+    typeAttrObj->internalRep.twoPtrValue.ptr1 = intRepP;
+    typeAttrObj->internalRep.twoPtrValue.ptr2 = NULL;
+    typeAttrObj->typePtr = &cffiTypeAndAttrsObjType;
+    return TCL_OK;
+}
+
+/* Function: CffiDefinitionsChanged
+ * Invalidates type declarations cached by <CffiTypeAndAttrsParseCached>.
+ *
+ * Parameters:
+ *   ipCtxP - Interpreter context
+ *
+ * Must be called whenever aliases, enums or structs are defined or deleted
+ * as these change the result of parsing type declarations. The epoch is
+ * drawn from a process-wide counter so that a context allocated at the
+ * address of a deleted one never matches stale cached parses.
+ */
+void
+CffiDefinitionsChanged(CffiInterpCtx *ipCtxP)
+{
+    Tcl_MutexLock(&cffiDefinitionsEpochLock);
+    ipCtxP->definitionsEpoch = ++cffiDefinitionsEpoch;
+    Tcl_MutexUnlock(&cffiDefinitionsEpochLock);
+}
+
 
 /* Function: CffiTypeAndAttrsCleanup
  * Cleans up any allocation in the parameter representation.
@@ -1854,6 +2057,8 @@ CffiNativeScalarFromObj(CffiInterpCtx *ipCtxP,
             CHECK(CffiStructSizeForObj(
                 ipCtxP, typeAttrsP->dataType.u.structP, valueObj, &iLen, NULL));
             len = iLen;
+            if (typeAttrsP->flags & CFFI_F_ATTR_LIST)
+                flags |= CFFI_F_AS_LIST;
             if (flags & CFFI_F_PRESERVE_ON_ERROR) {
                 Tcl_DStringInit(&ds);
                 Tcl_DStringSetLength(&ds, len);
@@ -2133,6 +2338,23 @@ CffiNativeValueFromObj(CffiInterpCtx *ipCtxP,
                 CHECK(CffiBytesFromObjSafe(ip, valueObj, valueP, count, NULL));
                 break;
             default:
+                /* Vectors of the same base type are copied as is */
+                {
+                    const void *vecValuesP;
+                    vecValuesP = CffiVectorValues(
+                        valueObj, typeAttrsP->dataType.baseType, &nvalues);
+                    if (vecValuesP) {
+                        if (nvalues > count)
+                            nvalues = count;
+                        memcpy(valueP, vecValuesP, nvalues * baseSize);
+                        if (nvalues < count) {
+                            memset((baseSize * nvalues) + (char *)valueP,
+                                   0,
+                                   baseSize * (count - nvalues));
+                        }
+                        break;
+                    }
+                }
                 /* Store each contained element */
                 if (Tcl_ListObjGetElements(
                         ip, valueObj, &nvalues, &valueObjList)
@@ -2365,6 +2587,7 @@ CffiNativeValueToObj(CffiInterpCtx *ipCtxP,
     int offset;
     void *valueP;
     Tcl_Obj *valueObj;
+    CffiFlags structFlags;
     CffiBaseType baseType = typeAttrsP->dataType.baseType;
     Tcl_Interp *ip    = ipCtxP->interp;
 
@@ -2400,11 +2623,25 @@ CffiNativeValueToObj(CffiInterpCtx *ipCtxP,
     }
     valueP = offset + (char *)valueBaseP;
 
+    if ((typeAttrsP->flags & CFFI_F_ATTR_VECTOR) && count > 0) {
+        /* Numeric array annotated as a vector. Copy storage as is. */
+        int elemSize = cffiBaseTypes[baseType].size;
+        void *vecValuesP;
+        *valueObjP = CffiVectorNew(baseType, elemSize, count, &vecValuesP);
+        memcpy(vecValuesP, valueP, count * elemSize);
+        return TCL_OK;
+    }
+
     switch (baseType) {
     case CFFI_K_TYPE_STRUCT:
+        structFlags =
+            (typeAttrsP->flags & CFFI_F_ATTR_LIST) ? CFFI_F_AS_LIST : 0;
         if (count < 0) {
-            return CffiStructToObj(
-                ipCtxP, typeAttrsP->dataType.u.structP, valueP, valueObjP);
+            return CffiStructToObj(ipCtxP,
+                                   typeAttrsP->dataType.u.structP,
+                                   valueP,
+                                   structFlags,
+                                   valueObjP);
         }
         else {
             /* Array, possible even a single element, still represent as list */
@@ -2419,8 +2656,11 @@ CffiNativeValueToObj(CffiInterpCtx *ipCtxP,
             /* TBD - may be allocate Tcl_Obj* array from memlifo for speed */
             listObj = Tcl_NewListObj(count, NULL);
             for (i = 0, offset = 0; i < count; ++i, offset += elem_size) {
-                    ret = CffiStructToObj(
-                        ipCtxP, structP, offset + (char *)valueP, &valueObj);
+                    ret = CffiStructToObj(ipCtxP,
+                                          structP,
+                                          offset + (char *)valueP,
+                                          structFlags,
+                                          &valueObj);
                     if (ret != TCL_OK) {
                     Tcl_DecrRefCount(listObj);
                     return ret;
@@ -2563,6 +2803,8 @@ CffiPointerToObj(CffiInterpCtx *ipCtxP,
                 pointer, typeAttrsP->dataType.u.tagNameObj);
             ret         = TCL_OK;
         } else {
+            /* Registration may replace tag of an existing registration */
+            CffiPointerRegistering(ipCtxP, pointer);
             if (flags & CFFI_F_ATTR_COUNTED)
                 ret = Tclh_PointerRegisterCounted(
                     ip,
@@ -2616,6 +2858,28 @@ CffiPointerFromObj(CffiInterpCtx *ipCtxP,
     Tclh_PointerTypeTag tag;
     Tclh_PointerTagRelation tagRelation;
     Tclh_PointerRegistrationStatus registration;
+    Tcl_Obj *targetTagObj = typeAttrsP->dataType.u.tagNameObj;
+    CffiPointerCacheEntry *cacheP = NULL;
+
+    /*
+     * Passing the same pointer repeatedly is common, e.g. handles. Skip
+     * the tag relation checks and registry lookup if the same pointer
+     * value and tag was validated against the target tag and no pointers
+     * have been unregistered since. Unwrapping only reads the internal
+     * representation once the object has been converted to a pointer.
+     */
+    if (Tclh_PointerUnwrap(NULL, pointerObj, &pv) == TCL_OK && pv != NULL
+        && Tclh_PointerObjGetTag(NULL, pointerObj, &tag) == TCL_OK) {
+        cacheP = &ipCtxP->pointerCache
+                      [(((uintptr_t)pv >> 4) ^ ((uintptr_t)targetTagObj >> 4))
+                       & (CFFI_POINTER_CACHE_SIZE - 1)];
+        if (cacheP->pv == pv && cacheP->tagObj == tag
+            && cacheP->targetTagObj == targetTagObj
+            && cacheP->epoch == ipCtxP->pointerRegistryEpoch) {
+            *pointerP = pv;
+            return TCL_OK;
+        }
+    }
 
     ret = Tclh_PointerObjDissect(ipCtxP->interp,
                                  ipCtxP->tclhCtxP,
@@ -2627,6 +2891,7 @@ CffiPointerFromObj(CffiInterpCtx *ipCtxP,
                                  &registration);
     if (ret != TCL_OK)
         return ret;
+    registration = CffiPointerRangeCheckRegistration(ipCtxP, pv, registration);
     if (pv == NULL) {
         if ((typeAttrsP->flags & CFFI_F_ATTR_NOVALUECHECKS) == 0) {
             return Tclh_ErrorPointerNull(ipCtxP->interp);
@@ -2655,12 +2920,54 @@ CffiPointerFromObj(CffiInterpCtx *ipCtxP,
                         ipCtxP->interp, pointerObj, registration);
             }
         }
+        /*
+         * Only cache if registration was good even if not required so
+         * the entry is valid for both safe and unsafe declarations.
+         */
+        if (cacheP
+            && (registration == TCLH_POINTER_REGISTRATION_OK
+                || registration == TCLH_POINTER_REGISTRATION_DERIVED)) {
+            if (cacheP->tagObj)
+                Tcl_DecrRefCount(cacheP->tagObj);
+            if (cacheP->targetTagObj)
+                Tcl_DecrRefCount(cacheP->targetTagObj);
+            if (tag)
+                Tcl_IncrRefCount(tag);
+            if (targetTagObj)
+                Tcl_IncrRefCount(targetTagObj);
+            cacheP->pv           = pv;
+            cacheP->tagObj       = tag;
+            cacheP->targetTagObj = targetTagObj;
+            cacheP->epoch        = ipCtxP->pointerRegistryEpoch;
+        }
     }
 
     *pointerP = pv;
     return TCL_OK;
 }
 
+/* Function: CffiPointerCacheReset
+ * Releases all entries in the pointer validation cache.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ */
+void
+CffiPointerCacheReset(CffiInterpCtx *ipCtxP)
+{
+    int i;
+    for (i = 0; i < CFFI_POINTER_CACHE_SIZE; ++i) {
+        CffiPointerCacheEntry *cacheP = &ipCtxP->pointerCache[i];
+        if (cacheP->tagObj)
+            Tcl_DecrRefCount(cacheP->tagObj);
+        if (cacheP->targetTagObj)
+            Tcl_DecrRefCount(cacheP->targetTagObj);
+        cacheP->pv           = NULL;
+        cacheP->tagObj       = NULL;
+        cacheP->targetTagObj = NULL;
+    }
+}
+
 /* Function: CffiUniStringToObj
  * Wraps an encoded unistring/unichars into a *Tcl_Obj*
  *
@@ -3063,7 +3370,7 @@ CffiBytesFromObjSafe(Tcl_Interp *ip,
     Tcl_Size fromLen;
     unsigned char *fromP;
 
-    fromP = Tcl_GetByteArrayFromObj(fromObj, &fromLen);
+    fromP = CffiGetByteArrayFromObj(fromObj, &fromLen);
     if (fromLen > toSize) {
         return Tclh_ErrorInvalidValue(ip,
                                       NULL,
@@ -3344,7 +3651,7 @@ CffiTypeFrombinaryCmd(CffiInterpCtx *ipCtxP,
     if (pv == NULL)
         return TCL_ERROR;
 
-    CHECK(CffiTypeAndAttrsParse(
+    CHECK(CffiTypeAndAttrsParseCached(
         ipCtxP, typeObj, CFFI_F_TYPE_PARSE_FIELD, &typeAttrs));
 
     ret = CffiNativeValueToObj(ipCtxP,
@@ -3423,7 +3730,7 @@ CffiTypeObjCmd(ClientData cdata,
         }
     }
 
-    CHECK(CffiTypeAndAttrsParse(ipCtxP, objv[2], parse_mode, &typeAttrs));
+    CHECK(CffiTypeAndAttrsParseCached(ipCtxP, objv[2], parse_mode, &typeAttrs));
     if (CffiTypeIsVariableSize(&typeAttrs.dataType) && vlaCount < 0) {
         CffiTypeAndAttrsCleanup(&typeAttrs);
         return CffiErrorMissingVLACountOption(ip);
@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) 2026, Ashok P. Nadkarni
+ * All rights reserved.
+ *
+ * See the file LICENSE for license
+ */
+
+/*
+ * Implements the *vector* command and the vector Tcl_ObjType.
+ *
+ * A vector is a Tcl value holding a contiguous native array of a numeric
+ * base type. Array parameters and fields of the same base type copy the
+ * native storage directly instead of converting one list element at a time
+ * (see <CffiVectorValues>). The string representation is that of a list of
+ * the elements so vectors can be passed anywhere a list is expected. Note
+ * however that doing so may shimmer the value to a list, after which it is
+ * no longer usable with the *vector* commands.
+ */
+
+#include "tclCffiInt.h"
+
+/* Struct: CffiVector
+ * Internal representation of a vector. The elements are stored following
+ * the header.
+ */
+typedef struct CffiVector {
+    Tcl_Size count;       /* Number of elements */
+    CffiBaseType baseType; /* Type of elements */
+    int elemSize;         /* Size of each element */
+    union {
+        double d;
+        long long ll;
+    } values[1]; /* Element storage - actually of size count*elemSize */
+} CffiVector;
+#define VECTOR_HEADER_SIZE offsetof(CffiVector, values)
+
+static void CffiVectorFreeIntRep(Tcl_Obj *objP);
+static void CffiVectorDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj);
+static void CffiVectorUpdateString(Tcl_Obj *objP);
+
+static const Tcl_ObjType cffiVectorObjType = {
+    "cffi-vector",
+    CffiVectorFreeIntRep,
+    CffiVectorDupIntRep,
+    CffiVectorUpdateString,
+    NULL,
+};
+
+#define VECTORP(objP_) ((CffiVector *)(objP_)->internalRep.twoPtrValue.ptr1)
+
+static CffiVector *
+CffiVectorAllocate(CffiBaseType baseType, int elemSize, Tcl_Size count)
+{
+    CffiVector *vecP = ckalloc(VECTOR_HEADER_SIZE + count * elemSize);
+    vecP->count      = count;
+    vecP->baseType   = baseType;
+    vecP->elemSize   = elemSize;
+    return vecP;
+}
+
+static Tcl_Obj *
+CffiVectorNewObj(CffiVector *vecP)
+{
+    Tcl_Obj *objP = Tcl_NewObj();
+    Tcl_InvalidateStringRep(objP);
+    objP->internalRep.twoPtrValue.ptr1 = vecP;
+    objP->internalRep.twoPtrValue.ptr2 = NULL;
+    objP->typePtr                      = &cffiVectorObjType;
+    return objP;
+}
+
+static void
+CffiVectorFreeIntRep(Tcl_Obj *objP)
+{
+    ckfree(VECTORP(objP));
+    objP->typePtr = NULL;
+}
+
+static void
+CffiVectorDupIntRep(Tcl_Obj *srcObj, Tcl_Obj *dstObj)
+{
+    CffiVector *srcP = VECTORP(srcObj);
+    Tcl_Size size    = VECTOR_HEADER_SIZE + srcP->count * srcP->elemSize;
+    CffiVector *vecP = ckalloc(size);
+    memcpy(vecP, srcP, size);
+    dstObj->internalRep.twoPtrValue.ptr1 = vecP;
+    dstObj->internalRep.twoPtrValue.ptr2 = NULL;
+    dstObj->typePtr                      = &cffiVectorObjType;
+}
+
+/* Function: CffiVectorElementToObj
+ * Returns a Tcl_Obj for an element of a vector.
+ *
+ * Parameters:
+ * vecP - the vector
+ * indx - index of the element. Caller must ensure it is in range.
+ *
+ * Returns:
+ * A Tcl_Obj with a reference count of 0.
+ */
+static Tcl_Obj *
+CffiVectorElementToObj(const CffiVector *vecP, Tcl_Size indx)
+{
+    const void *valuesP = vecP->values;
+
+    switch (vecP->baseType) {
+    case CFFI_K_TYPE_SCHAR:
+        return Tcl_NewIntObj(indx[(signed char *)valuesP]);
+    case CFFI_K_TYPE_UCHAR:
+        return Tcl_NewIntObj(indx[(unsigned char *)valuesP]);
+    case CFFI_K_TYPE_SHORT:
+        return Tcl_NewIntObj(indx[(short *)valuesP]);
+    case CFFI_K_TYPE_USHORT:
+        return Tcl_NewIntObj(indx[(unsigned short *)valuesP]);
+    case CFFI_K_TYPE_INT:
+        return Tcl_NewIntObj(indx[(int *)valuesP]);
+    case CFFI_K_TYPE_UINT:
+        return Tcl_NewWideIntObj(indx[(unsigned int *)valuesP]);
+    case CFFI_K_TYPE_LONG:
+        return Tcl_NewLongObj(indx[(long *)valuesP]);
+    case CFFI_K_TYPE_ULONG:
+        return Tclh_ObjFromULong(indx[(unsigned long *)valuesP]);
+    case CFFI_K_TYPE_LONGLONG:
+        return Tcl_NewWideIntObj(indx[(long long *)valuesP]);
+    case CFFI_K_TYPE_ULONGLONG:
+        return Tclh_ObjFromULongLong(indx[(unsigned long long *)valuesP]);
+    case CFFI_K_TYPE_FLOAT:
+        return Tcl_NewDoubleObj(indx[(float *)valuesP]);
+    case CFFI_K_TYPE_DOUBLE:
+        return Tcl_NewDoubleObj(indx[(double *)valuesP]);
+    default:
+        CFFI_PANIC("Unexpected vector base type %d.", vecP->baseType);
+        return NULL; /* NOTREACHED - keep compiler happy */
+    }
+}
+
+static void
+CffiVectorUpdateString(Tcl_Obj *objP)
+{
+    CffiVector *vecP = VECTORP(objP);
+    Tcl_Obj *listObj;
+    const char *s;
+    Tcl_Size i, len;
+
+    listObj = Tcl_NewListObj(vecP->count, NULL);
+    for (i = 0; i < vecP->count; ++i) {
+        Tcl_ListObjAppendElement(
+            NULL, listObj, CffiVectorElementToObj(vecP, i));
+    }
+    s            = Tcl_GetStringFromObj(listObj, &len);
+    objP->bytes  = ckalloc(len + 1);
+    objP->length = len;
+    memcpy(objP->bytes, s, len + 1);
+    Tcl_DecrRefCount(listObj);
+}
+
+/* Function: CffiVectorValues
+ * Returns the native storage of a vector of a given base type.
+ *
+ * Parameters:
+ * objP - a Tcl value
+ * baseType - required base type of the vector elements
+ * countP - location to store the number of elements
+ *
+ * Used by conversion routines to copy vector contents without per element
+ * conversion. The returned memory must be treated as read-only.
+ *
+ * Returns:
+ * Pointer to the elements if *objP* is a vector with elements of type
+ * *baseType* and NULL otherwise.
+ */
+const void *
+CffiVectorValues(Tcl_Obj *objP, CffiBaseType baseType, Tcl_Size *countP)
+{
+    CffiVector *vecP;
+    if (objP->typePtr != &cffiVectorObjType)
+        return NULL;
+    vecP = VECTORP(objP);
+    if (vecP->baseType != baseType)
+        return NULL;
+    *countP = vecP->count;
+    return vecP->values;
+}
+
+/* Function: CffiVectorNew
+ * Returns a new vector value with uninitialized elements.
+ *
+ * Parameters:
+ * baseType - base type of the vector elements. Must be a numeric type.
+ * elemSize - size of each element
+ * count - number of elements
+ * valuesPP - location to store pointer to the element storage
+ *
+ * The caller must fill in all *count* elements at **valuesPP* before the
+ * value is used.
+ *
+ * Returns:
+ * A Tcl_Obj with a reference count of 0.
+ */
+Tcl_Obj *
+CffiVectorNew(CffiBaseType baseType,
+              int elemSize,
+              Tcl_Size count,
+              void **valuesPP)
+{
+    CffiVector *vecP = CffiVectorAllocate(baseType, elemSize, count);
+    *valuesPP        = vecP->values;
+    return CffiVectorNewObj(vecP);
+}
+
+/* Function: CffiVectorFromObj
+ * Returns the vector internal representation of a Tcl value.
+ *
+ * Parameters:
+ * ip - interpreter
+ * objP - the Tcl value
+ * vecPP - location to store the vector
+ *
+ * Vectors cannot be regenerated from their string representation since it
+ * does not record the element type.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+static CffiResult
+CffiVectorFromObj(Tcl_Interp *ip, Tcl_Obj *objP, CffiVector **vecPP)
+{
+    if (objP->typePtr != &cffiVectorObjType) {
+        return Tclh_ErrorInvalidValue(ip, objP, "Not a vector.");
+    }
+    *vecPP = VECTORP(objP);
+    return TCL_OK;
+}
+
+/* Function: CffiVectorElementTypeFromObj
+ * Parses the element type of a vector.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * typeObj - type declaration. Must be a numeric scalar type without
+ *   annotations that affect the value representation.
+ * typeAttrsP - location to store the parsed type. Only the dataType
+ *   fields are set. The caller need not clean it up.
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+static CffiResult
+CffiVectorElementTypeFromObj(CffiInterpCtx *ipCtxP,
+                             Tcl_Obj *typeObj,
+                             CffiTypeAndAttrs *typeAttrsP)
+{
+    CffiTypeAndAttrs parsed;
+    CffiBaseType baseType;
+    CffiResult ret = TCL_OK;
+
+    CHECK(CffiTypeAndAttrsParseCached(
+        ipCtxP, typeObj, CFFI_F_TYPE_PARSE_FIELD, &parsed));
+    baseType = parsed.dataType.baseType;
+    if (CffiTypeIsArray(&parsed.dataType)
+        || (parsed.flags & (CFFI_F_ATTR_ENUM | CFFI_F_ATTR_BITMASK))
+        || !(CffiTypeIsInteger(baseType) || baseType == CFFI_K_TYPE_FLOAT
+             || baseType == CFFI_K_TYPE_DOUBLE)) {
+        ret = Tclh_ErrorInvalidValue(
+            ipCtxP->interp,
+            typeObj,
+            "Vector element type must be a numeric scalar type.");
+    }
+    else {
+        memset(typeAttrsP, 0, sizeof(*typeAttrsP));
+        typeAttrsP->dataType.baseType     = baseType;
+        typeAttrsP->dataType.arraySize    = -1;
+        typeAttrsP->dataType.baseTypeSize = parsed.dataType.baseTypeSize;
+    }
+    CffiTypeAndAttrsCleanup(&parsed);
+    return ret;
+}
+
+/* Function: CffiVectorIndexFromObj
+ * Parses a vector element index.
+ *
+ * Parameters:
+ * ip - interpreter
+ * vecP - the vector
+ * indexObj - the index. Must be in the range 0 to one less than the number
+ *   of elements.
+ * indexP - location to store the index
+ *
+ * Returns:
+ * *TCL_OK* on success, *TCL_ERROR* with error message in interpreter.
+ */
+static CffiResult
+CffiVectorIndexFromObj(Tcl_Interp *ip,
+                       const CffiVector *vecP,
+                       Tcl_Obj *indexObj,
+                       Tcl_Size *indexP)
+{
+    Tcl_WideInt wide;
+    CHECK(Tclh_ObjToWideInt(ip, indexObj, &wide));
+    if (wide < 0 || wide >= vecP->count) {
+        return Tclh_ErrorInvalidValue(ip, indexObj, "Index out of range.");
+    }
+    *indexP = (Tcl_Size)wide;
+    return TCL_OK;
+}
+
+/* Function: CffiVectorReduce
+ * Computes the sum, minimum or maximum of the elements of a vector.
+ *
+ * Parameters:
+ * ip - interpreter
+ * vecP - the vector
+ * op - one of 's', '<' or '>' for sum, minimum and maximum respectively
+ *
+ * The sum of integer types is computed with 64-bit integer arithmetic and
+ * that of floating point types as a double. The minimum and maximum are
+ * returned as elements of the vector.
+ *
+ * Returns:
+ * *TCL_OK* on success with the result in the interpreter, *TCL_ERROR* with
+ * error message in interpreter.
+ */
+static CffiResult
+CffiVectorReduce(Tcl_Interp *ip, const CffiVector *vecP, char op)
+{
+    Tcl_Size i, found;
+
+    if (op == 's') {
+        Tcl_Obj *sumObj;
+#define SUM_(type_, accumtype_, objfn_)                        \
+    do {                                                       \
+        const type_ *p_ = (const type_ *)vecP->values;         \
+        accumtype_ sum_ = 0;                                   \
+        for (i = 0; i < vecP->count; ++i)                      \
+            sum_ += p_[i];                                     \
+        sumObj = objfn_(sum_);                                 \
+    } while (0)
+
+        switch (vecP->baseType) {
+        case CFFI_K_TYPE_SCHAR: SUM_(signed char, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_UCHAR: SUM_(unsigned char, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_SHORT: SUM_(short, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_USHORT: SUM_(unsigned short, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_INT: SUM_(int, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_UINT: SUM_(unsigned int, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_LONG: SUM_(long, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_ULONG: SUM_(unsigned long, unsigned long long, Tclh_ObjFromULongLong); break;
+        case CFFI_K_TYPE_LONGLONG: SUM_(long long, Tcl_WideInt, Tcl_NewWideIntObj); break;
+        case CFFI_K_TYPE_ULONGLONG: SUM_(unsigned long long, unsigned long long, Tclh_ObjFromULongLong); break;
+        case CFFI_K_TYPE_FLOAT: SUM_(float, double, Tcl_NewDoubleObj); break;
+        case CFFI_K_TYPE_DOUBLE: SUM_(double, double, Tcl_NewDoubleObj); break;
+        default:
+            return CffiErrorType(ip, vecP->baseType, __FILE__, __LINE__);
+        }
+#undef SUM_
+        Tcl_SetObjResult(ip, sumObj);
+        return TCL_OK;
+    }
+
+    if (vecP->count == 0) {
+        return Tclh_ErrorGeneric(ip, NULL, "Vector is empty.");
+    }
+
+#define FIND_(type_)                                                 \
+    do {                                                             \
+        const type_ *p_ = (const type_ *)vecP->values;               \
+        found           = 0;                                         \
+        if (op == '<') {                                             \
+            for (i = 1; i < vecP->count; ++i) {                      \
+                if (p_[i] < p_[found])                               \
+                    found = i;                                       \
+            }                                                        \
+        }                                                            \
+        else {                                                       \
+            for (i = 1; i < vecP->count; ++i) {                      \
+                if (p_[i] > p_[found])                               \
+                    found = i;                                       \
+            }                                                        \
+        }                                                            \
+    } while (0)
+
+    switch (vecP->baseType) {
+    case CFFI_K_TYPE_SCHAR: FIND_(signed char); break;
+    case CFFI_K_TYPE_UCHAR: FIND_(unsigned char); break;
+    case CFFI_K_TYPE_SHORT: FIND_(short); break;
+    case CFFI_K_TYPE_USHORT: FIND_(unsigned short); break;
+    case CFFI_K_TYPE_INT: FIND_(int); break;
+    case CFFI_K_TYPE_UINT: FIND_(unsigned int); break;
+    case CFFI_K_TYPE_LONG: FIND_(long); break;
+    case CFFI_K_TYPE_ULONG: FIND_(unsigned long); break;
+    case CFFI_K_TYPE_LONGLONG: FIND_(long long); break;
+    case CFFI_K_TYPE_ULONGLONG: FIND_(unsigned long long); break;
+    case CFFI_K_TYPE_FLOAT: FIND_(float); break;
+    case CFFI_K_TYPE_DOUBLE: FIND_(double); break;
+    default:
+        return CffiErrorType(ip, vecP->baseType, __FILE__, __LINE__);
+    }
+#undef FIND_
+    Tcl_SetObjResult(ip, CffiVectorElementToObj(vecP, found));
+    return TCL_OK;
+}
+
+/* Function: CffiVectorCreate
+ * Implements the *vector create* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * typeObj - element type
+ * valuesObj - list of element values
+ * countObj - number of elements. May be NULL in which case the number of
+ *   elements in *valuesObj* is used. Elements not present in *valuesObj*
+ *   are set to 0.
+ *
+ * Returns:
+ * *TCL_OK* on success with the vector in the interpreter result,
+ * *TCL_ERROR* with error message in interpreter.
+ */
+static CffiResult
+CffiVectorCreate(CffiInterpCtx *ipCtxP,
+                 Tcl_Obj *typeObj,
+                 Tcl_Obj *valuesObj,
+                 Tcl_Obj *countObj)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiTypeAndAttrs typeAttrs;
+    CffiVector *vecP;
+    Tcl_Obj **valueObjs;
+    Tcl_Size i, nvalues, count;
+    int elemSize;
+
+    CHECK(CffiVectorElementTypeFromObj(ipCtxP, typeObj, &typeAttrs));
+    CHECK(Tcl_ListObjGetElements(ip, valuesObj, &nvalues, &valueObjs));
+    elemSize = typeAttrs.dataType.baseTypeSize;
+    if (countObj) {
+        Tcl_WideInt wide;
+        CHECK(Tclh_ObjToRangedInt(
+            ip, countObj, 0, (TCL_SIZE_MAX - VECTOR_HEADER_SIZE) / elemSize, &wide));
+        count = (Tcl_Size)wide;
+        if (nvalues > count) {
+            return Tclh_ErrorInvalidValue(
+                ip, valuesObj, "Number of values exceeds vector size.");
+        }
+    }
+    else
+        count = nvalues;
+
+    vecP = CffiVectorAllocate(typeAttrs.dataType.baseType, elemSize, count);
+    for (i = 0; i < nvalues; ++i) {
+        if (CffiNativeScalarFromObj(ipCtxP,
+                                    &typeAttrs,
+                                    valueObjs[i],
+                                    0,
+                                    vecP->values,
+                                    i,
+                                    NULL)
+            != TCL_OK) {
+            ckfree(vecP);
+            return TCL_ERROR;
+        }
+    }
+    if (nvalues < count) {
+        memset(nvalues * elemSize + (char *)vecP->values,
+               0,
+               (count - nvalues) * elemSize);
+    }
+    Tcl_SetObjResult(ip, CffiVectorNewObj(vecP));
+    return TCL_OK;
+}
+
+/* Function: CffiVectorSet
+ * Implements the *vector set* command.
+ *
+ * Parameters:
+ * ipCtxP - interpreter context
+ * varNameObj - name of variable holding the vector
+ * indexObj - index of element to set
+ * valueObj - value to store
+ *
+ * As for *lset*, the vector is modified in place if the variable value
+ * is not shared.
+ *
+ * Returns:
+ * *TCL_OK* on success with the new vector in the interpreter result,
+ * *TCL_ERROR* with error message in interpreter.
+ */
+static CffiResult
+CffiVectorSet(CffiInterpCtx *ipCtxP,
+              Tcl_Obj *varNameObj,
+              Tcl_Obj *indexObj,
+              Tcl_Obj *valueObj)
+{
+    Tcl_Interp *ip = ipCtxP->interp;
+    CffiTypeAndAttrs typeAttrs;
+    CffiVector *vecP;
+    Tcl_Obj *vecObj;
+    Tcl_Obj *resultObj;
+    Tcl_Size indx;
+
+    vecObj = Tcl_ObjGetVar2(ip, varNameObj, NULL, TCL_LEAVE_ERR_MSG);
+    if (vecObj == NULL)
+        return TCL_ERROR;
+    CHECK(CffiVectorFromObj(ip, vecObj, &vecP));
+    CHECK(CffiVectorIndexFromObj(ip, vecP, indexObj, &indx));
+
+    memset(&typeAttrs, 0, sizeof(typeAttrs));
+    typeAttrs.dataType.baseType     = vecP->baseType;
+    typeAttrs.dataType.arraySize    = -1;
+    typeAttrs.dataType.baseTypeSize = vecP->elemSize;
+
+    if (Tcl_IsShared(vecObj)) {
+        vecObj = Tcl_DuplicateObj(vecObj);
+        vecP   = VECTORP(vecObj);
+    }
+    Tcl_IncrRefCount(vecObj);
+    if (CffiNativeScalarFromObj(
+            ipCtxP, &typeAttrs, valueObj, 0, vecP->values, indx, NULL)
+        != TCL_OK) {
+        Tcl_DecrRefCount(vecObj);
+        return TCL_ERROR;
+    }
+    Tcl_InvalidateStringRep(vecObj);
+    resultObj = Tcl_ObjSetVar2(ip, varNameObj, NULL, vecObj, TCL_LEAVE_ERR_MSG);
+    Tcl_DecrRefCount(vecObj);
+    if (resultObj == NULL)
+        return TCL_ERROR;
+    Tcl_SetObjResult(ip, resultObj);
+    return TCL_OK;
+}
+
+/* Function: CffiVectorObjCmd
+ * Implements the *vector* script level command.
+ *
+ * Parameters:
+ * cdata - interpreter context
+ * ip - interpreter
+ * objc - number of arguments in objv[]
+ * objv - argument array
+ *
+ * Returns:
+ * *TCL_OK* on success with result in interpreter, *TCL_ERROR* with error
+ * message in interpreter.
+ */
+CffiResult
+CffiVectorObjCmd(ClientData cdata,
+                 Tcl_Interp *ip,
+                 int objc,
+                 Tcl_Obj *const objv[])
+{
+    CffiInterpCtx *ipCtxP = (CffiInterpCtx *)cdata;
+    enum cmds { CREATE, GET, LENGTH, MAX, MIN, RANGE, SET, SUM, TYPE };
+    int cmdIndex;
+    static Tclh_SubCommand subCommands[] = {
+        {"create", 2, 3, "TYPE VALUES ?COUNT?", NULL},
+        {"get", 2, 2, "VECTOR INDEX", NULL},
+        {"length", 1, 1, "VECTOR", NULL},
+        {"max", 1, 1, "VECTOR", NULL},
+        {"min", 1, 1, "VECTOR", NULL},
+        {"range", 3, 3, "VECTOR FIRST LAST", NULL},
+        {"set", 3, 3, "VARNAME INDEX VALUE", NULL},
+        {"sum", 1, 1, "VECTOR", NULL},
+        {"type", 1, 1, "VECTOR", NULL},
+        {NULL}};
+    CffiVector *vecP;
+    CffiVector *sliceP;
+    Tcl_WideInt first, last;
+    Tcl_Size indx;
+
+    CHECK(Tclh_SubCommandLookup(ip, subCommands, objc, objv, &cmdIndex));
+    switch (cmdIndex) {
+    case CREATE:
+        return CffiVectorCreate(
+            ipCtxP, objv[2], objv[3], objc > 4 ? objv[4] : NULL);
+    case SET:
+        return CffiVectorSet(ipCtxP, objv[2], objv[3], objv[4]);
+    default:
+        break;
+    }
+
+    CHECK(CffiVectorFromObj(ip, objv[2], &vecP));
+    switch (cmdIndex) {
+    case GET:
+        CHECK(CffiVectorIndexFromObj(ip, vecP, objv[3], &indx));
+        Tcl_SetObjResult(ip, CffiVectorElementToObj(vecP, indx));
+        break;
+    case LENGTH:
+        Tcl_SetObjResult(ip, Tcl_NewWideIntObj(vecP->count));
+        break;
+    case MAX:
+        return CffiVectorReduce(ip, vecP, '>');
+    case MIN:
+        return CffiVectorReduce(ip, vecP, '<');
+    case SUM:
+        return CffiVectorReduce(ip, vecP, 's');
+    case RANGE:
+        /* Same semantics as lrange for out of range indices */
+        CHECK(Tclh_ObjToWideInt(ip, objv[3], &first));
+        CHECK(Tclh_ObjToWideInt(ip, objv[4], &last));
+        if (first < 0)
+            first = 0;
+        if (last >= vecP->count)
+            last = vecP->count - 1;
+        if (first > last) {
+            first = 0;
+            last  = -1;
+        }
+        sliceP = CffiVectorAllocate(
+            vecP->baseType, vecP->elemSize, (Tcl_Size)(last - first + 1));
+        memcpy(sliceP->values,
+               first * vecP->elemSize + (char *)vecP->values,
+               sliceP->count * vecP->elemSize);
+        Tcl_SetObjResult(ip, CffiVectorNewObj(sliceP));
+        break;
+    case TYPE:
+        Tcl_SetResult(
+            ip, (char *)cffiBaseTypes[vecP->baseType].token, TCL_STATIC);
+        break;
+    }
+    return TCL_OK;
+}
@@ -85,6 +85,7 @@ CffiWrapperStdcallCmd(Tcl_Interp *ip,
  *
  * The *objv[2]* element contains the function definition list.
  * This is a flat list of function name, type, parameter definitions.
+ * Remaining elements are the options *-ignoremissing* and *-lazy*.
  *
  * Returns:
  * Returns TCL_OK on success and TCL_ERROR on failure with error message
@@ -101,15 +102,15 @@ CffiWrapperManyFunctionsCmd(Tcl_Interp *ip,
     Tcl_Obj **objs;
     Tcl_Size i, nobjs;
     int ret;
-    int ignoreMissing = 0;
-    static const char * const opts[2] = {"-ignoremissing", NULL};
+    int flags = 0;
+    int opt;
+    static const char * const opts[] = {"-ignoremissing", "-lazy", NULL};
 
-    CFFI_ASSERT(objc == 3 || objc == 4);
+    CFFI_ASSERT(objc >= 3 && objc <= 5);
 
-    if (objc == 4) {
-        /* Use this just to get the error message right */
-        CHECK(Tcl_GetIndexFromObj(ip, objv[3], opts, "option", 0, &i));
-        ignoreMissing = 1;
+    for (i = 3; i < objc; ++i) {
+        CHECK(Tcl_GetIndexFromObj(ip, objv[i], opts, "option", 0, &opt));
+        flags |= opt == 0 ? CFFI_F_DEFINE_IGNOREMISSING : CFFI_F_DEFINE_LAZY;
     }
 
     CHECK(Tcl_ListObjGetElements(ip, objv[2], &nobjs, &objs));
@@ -127,7 +128,7 @@ CffiWrapperManyFunctionsCmd(Tcl_Interp *ip,
                                            objs[i + 1],
                                            objs[i + 2],
                                            callMode,
-                                           ignoreMissing);
+                                           flags);
         if (ret != TCL_OK) {
             if (errorMessages == NULL) {
                 errorMessages = Tcl_NewStringObj("Errors:", -1);
@@ -256,10 +257,10 @@ CffiWrapperInstanceCmd(ClientData cdata,
         {"addressof", 1, 1, "SYMBOL", CffiWrapperAddressOfCmd},
         {"destroy", 0, 0, "", CffiWrapperDestroyCmd},
         {"function", 3, 3, "NAME RETURNTYPE PARAMDEFS", CffiWrapperFunctionCmd},
-        {"functions", 1, 2, "FUNCTIONLIST ?-ignoremissing?", CffiWrapperFunctionsCmd},
+        {"functions", 1, 3, "FUNCTIONLIST ?-ignoremissing? ?-lazy?", CffiWrapperFunctionsCmd},
         {"path", 0, 0, "", CffiWrapperPathCmd},
         {"stdcall", 3, 3, "NAME RETURNTYPE PARAMDEFS", CffiWrapperStdcallCmd},
-        {"stdcalls", 1, 2, "FUNCTIONLIST ?-ignoremissing?", CffiWrapperStdcallsCmd},
+        {"stdcalls", 1, 3, "FUNCTIONLIST ?-ignoremissing? ?-lazy?", CffiWrapperStdcallsCmd},
         {NULL}};
     int cmdIndex;
 